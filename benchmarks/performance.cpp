@@ -14,8 +14,40 @@
 
 #include <cassert>
 #include <condition_variable>
+#include <sstream>
 #include <thread>
 
+namespace ozo {
+
+std::ostream& operator <<(std::ostream& stream, connection_selection value) {
+    switch (value) {
+        case connection_selection::lifo:
+            return stream << "lifo";
+        case connection_selection::fifo:
+            return stream << "fifo";
+        case connection_selection::affinity:
+            return stream << "affinity";
+    }
+    return stream;
+}
+
+std::istream& operator >>(std::istream& stream, connection_selection& value) {
+    std::string token;
+    stream >> token;
+    if (token == "lifo") {
+        value = connection_selection::lifo;
+    } else if (token == "fifo") {
+        value = connection_selection::fifo;
+    } else if (token == "affinity") {
+        value = connection_selection::affinity;
+    } else {
+        throw std::invalid_argument("Invalid connection selection: \"" + token + "\"");
+    }
+    return stream;
+}
+
+} // namespace ozo
+
 namespace {
 
 namespace asio = boost::asio;
@@ -85,6 +117,7 @@ struct benchmark_params {
     ozo::time_traits::duration request_timeout = std::chrono::seconds(1);
     ozo::time_traits::duration idle_timeout = std::chrono::seconds(1);
     ozo::time_traits::duration lifespan = std::chrono::seconds(1);
+    ozo::connection_selection selection = ozo::connection_selection::lifo;
 };
 
 struct benchmark_report {
@@ -97,6 +130,7 @@ struct benchmark_report {
     OZO_STD_OPTIONAL<std::size_t> queue_capacity;
     OZO_STD_OPTIONAL<std::size_t> connections;
     OZO_STD_OPTIONAL<bool> parse_result;
+    OZO_STD_OPTIONAL<ozo::connection_selection> selection;
 };
 
 std::ostream& operator <<(std::ostream& stream, const benchmark_report& value) {
@@ -117,6 +151,9 @@ std::ostream& operator <<(std::ostream& stream, const benchmark_report& value) {
     if (value.parse_result) {
         stream << "parse_result: " << *value.parse_result << '\n';
     }
+    if (value.selection) {
+        stream << "selection: " << *value.selection << '\n';
+    }
     stream << value.stats << '\n';
     return stream;
 }
@@ -222,6 +259,7 @@ benchmark_report use_connection_pool(const benchmark_params& params, Query query
     report.coroutines = params.coroutines;
     report.queue_capacity = params.queue_capacity;
     report.parse_result = parse_result;
+    report.selection = params.selection;
 
     benchmark_t benchmark(params.coroutines, params.duration);
     benchmark.set_print_progress(params.verbose);
@@ -231,6 +269,7 @@ benchmark_report use_connection_pool(const benchmark_params& params, Query query
     ozo::connection_pool_config config;
     config.capacity = params.coroutines + 1;
     config.queue_capacity = params.queue_capacity;
+    config.selection = params.selection;
     ozo::connection_pool pool(connection_info, config, !ozo::thread_safe);
 
     for (std::size_t token = 0; token < params.coroutines; ++token) {
@@ -284,6 +323,7 @@ benchmark_report use_connection_pool_mult_threads(const benchmark_params& params
     report.threads_number = params.threads_number;
     report.connections = params.connections;
     report.parse_result = parse_result;
+    report.selection = params.selection;
 
     benchmark_t benchmark(params.coroutines * params.threads_number, params.duration);
     benchmark.set_print_progress(params.verbose);
@@ -292,6 +332,7 @@ benchmark_report use_connection_pool_mult_threads(const benchmark_params& params
     ozo::connection_pool_config config;
     config.capacity = params.connections;
     config.queue_capacity = params.queue_capacity;
+    config.selection = params.selection;
     std::vector<std::unique_ptr<context>> contexts;
     ozo::connection_pool pool(connection_info, config);
     std::atomic_size_t finished_coroutines {0};
@@ -552,6 +593,11 @@ struct adl_serializer<benchmark_report> {
         if (value.parse_result) {
             j["parse_result"] = *value.parse_result;
         }
+        if (value.selection) {
+            std::ostringstream selection;
+            selection << *value.selection;
+            j["selection"] = selection.str();
+        }
         j["output"] = value.output;
         j["stats"] = value.stats;
     }
@@ -597,6 +643,8 @@ int main(int argc, char **argv) {
             ("request_timeout", po::value<double>()->default_value(1), "request timeout in seconds")
             ("idle_timeout", po::value<double>()->default_value(1), "pooled connection idle timeout in seconds")
             ("lifespan", po::value<double>()->default_value(1), "pooled connection lifespan in seconds")
+            ("selection", po::value<ozo::connection_selection>()->default_value(ozo::connection_selection::lifo),
+                "pooled idle connection selection policy (lifo, fifo, affinity)")
         ;
 
         po::variables_map variables;
@@ -633,6 +681,7 @@ int main(int argc, char **argv) {
         params.request_timeout = to_duration(variables.at("request_timeout"));
         params.idle_timeout = to_duration(variables.at("idle_timeout"));
         params.lifespan = to_duration(variables.at("lifespan"));
+        params.selection = variables.at("selection").as<ozo::connection_selection>();
 
         const auto report = run_benchmark(name, params);
 
@@ -8,6 +8,7 @@
 #include <ozo/core/none.h>
 #include <ozo/deadline.h>
 #include <ozo/pg/handle.h>
+#include <ozo/statistics.h>
 
 #include <ozo/detail/bind.h>
 #include <ozo/detail/functional.h>
@@ -83,7 +84,7 @@ inline constexpr decltype(auto) unwrap_connection(T&& conn) noexcept {
  * The class object is non-copyable.
  *
  * @tparam OidMap --- oid map of types are used with connection
- * @tparam Statistics --- statistics of the connection (not supported yet)
+ * @tparam Statistics --- statistics of the connection, see @ref group-statistics
  *
  * @thread_safety{Safe,Unsafe}
  * @ingroup group-connection-types
@@ -101,7 +102,7 @@ public:
      * Construct a new connection object.
      *
      * @param io --- execution context for IO operations associated with the object.
-     * @param statistics --- initial statistics (not supported yet)
+     * @param statistics --- initial statistics, see @ref group-statistics
      */
     connection(io_context& io, Statistics statistics);
 
@@ -132,11 +133,19 @@ public:
      */
     const oid_map_type& oid_map() const noexcept { return oid_map_;}
 
+    /**
+     * Update the connection statistics, see @ref group-statistics. Keys which are not supported
+     * by the statistics type are ignored.
+     *
+     * @param key --- statistics key, e.g. `ozo::request_counter`.
+     * @param value --- value for the key.
+     */
     template <typename Key, typename Value>
-    void update_statistics(const Key&, const Value&) noexcept {
-        static_assert(std::is_void_v<Key>, "update_statistics is not supperted");
+    void update_statistics(const Key& key, Value&& value) noexcept {
+        ozo::update_statistics(statistics_, key, std::forward<Value>(value));
     }
     const Statistics& statistics() const noexcept { return statistics_;}
+    Statistics& statistics() noexcept { return statistics_;}
 
     /**
      * Get the additional context object for an error that occurred during the last operation on the connection.
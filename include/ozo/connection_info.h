@@ -6,6 +6,8 @@
 #include <ozo/ext/std/shared_ptr.h>
 
 #include <chrono>
+#include <string>
+#include <vector>
 
 namespace ozo {
 
@@ -28,6 +30,7 @@ template <
 class connection_info {
     std::string conn_str;
     Statistics statistics;
+    impl::session_statements session;
 
 public:
     using connection_type = std::shared_ptr<ozo::connection<OidMap, Statistics>>; //!< Type of connection which is produced by the source.
@@ -44,6 +47,32 @@ public:
             : conn_str(std::move(conn_str)), statistics(std::move(statistics)) {
     }
 
+    /**
+     * @brief Construct a new connection information object with session initialization statements
+     *
+     * The statements, e.g. `SET application_name = 'app'` or `SET statement_timeout = 1000`, are executed
+     * on each new connection before it is provided to a user. If libpq supports the pipeline mode they are sent
+     * together with the oid map request in a single round trip.
+     *
+     * @param conn_str --- connection string which is being used to create connection to a database.
+     * @param session --- session initialization statements.
+     * @param OidMap --- #OidMap for custom types support.
+     * @param statistics --- statistics are being used for connections.
+     */
+    connection_info(std::string conn_str, std::vector<std::string> session, const OidMap& = OidMap{},
+            Statistics statistics = Statistics{})
+            : conn_str(std::move(conn_str)), statistics(std::move(statistics)),
+              session(std::make_shared<const std::vector<std::string>>(std::move(session))) {
+    }
+
+    /**
+     * Session initialization statements which are executed on each new connection.
+     */
+    const std::vector<std::string>& session_statements() const noexcept {
+        static const std::vector<std::string> empty;
+        return session ? *session : empty;
+    }
+
     /**
      * @brief Provides connection is binded to the given `io_context`
      *
@@ -61,7 +90,7 @@ public:
         static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
         auto allocator = asio::get_associated_allocator(handler);
         impl::async_connect(conn_str, t, std::allocate_shared<ozo::connection<OidMap, Statistics>>(allocator, io, statistics),
-            std::forward<Handler>(handler));
+            session, std::forward<Handler>(handler));
     }
 
     auto operator [](io_context& io) const & {
@@ -76,6 +105,9 @@ public:
 template<typename OidMap, typename Statistics>
 connection_info(std::string, const OidMap&, Statistics statistics) -> connection_info<OidMap, Statistics>;
 
+template<typename OidMap, typename Statistics>
+connection_info(std::string, std::vector<std::string>, const OidMap&, Statistics statistics) -> connection_info<OidMap, Statistics>;
+
 //[[DEPRECATED]] for backward compatibility only
 template <typename ...Ts>
 [[deprecated]] auto make_connector(const connection_info<Ts...>& source, io_context& io, time_traits::duration timeout) {
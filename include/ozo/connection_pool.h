@@ -6,9 +6,55 @@
 #include <ozo/connector.h>
 #include <ozo/core/thread_safety.h>
 #include <ozo/detail/connection_pool.h>
+#include <ozo/detail/pooled_stream.h>
+
+#include <array>
+#include <limits>
 
 namespace ozo {
 
+/**
+ * @brief Idle connection selection policy of the connection pool
+ * @ingroup group-connection-types
+ *
+ * Defines which one of the idle connections is provided by the `ozo::connection_pool`
+ * if there are several of them available. Connections which are not selected for a long
+ * time are closed by the pool due to the `connection_pool_config::idle_timeout`.
+ */
+enum class connection_selection {
+    lifo, //!< the most recently used connection --- it is hot in the server's and client's caches and most likely alive
+    fifo, //!< the least recently used connection --- all the connections are used evenly
+    affinity, //!< the most recently used connection which was used with the same `io_context`, otherwise the most recently used one
+};
+
+/**
+ * @brief Priority of the request for a connection from the connection pool
+ * @ingroup group-connection-types
+ *
+ * If there is no available connection, requests wait in the `ozo::connection_pool`
+ * queue. Requests of higher priority are served first, requests of the same
+ * priority are served in order of arrival.
+ */
+enum class connection_priority {
+    low, //!< background or batch requests which may wait
+    normal, //!< default priority
+    high, //!< latency-critical requests
+};
+
+/**
+ * Number of the `ozo::connection_priority` classes.
+ */
+inline constexpr std::size_t connection_priorities_count = 3;
+
+/**
+ * @brief Maximum number of queued requests per `ozo::connection_priority`
+ * @ingroup group-connection-types
+ *
+ * The array is indexed by the priority value, e.g. `quota[std::size_t(ozo::connection_priority::low)]`.
+ * The total number of queued requests is limited by `connection_pool_config::queue_capacity` anyway.
+ */
+using connection_queue_quota = std::array<std::size_t, connection_priorities_count>;
+
 /**
  * @brief Connection pool configuration
  * @ingroup group-connection-types
@@ -22,6 +68,13 @@ struct connection_pool_config {
     std::size_t queue_capacity = 128; //!< maximum number of queued requests to get available connection
     time_traits::duration idle_timeout = std::chrono::seconds(60); //!< time interval to close connection after last usage
     time_traits::duration lifespan = std::chrono::hours(24); //!< time interval to keep connection open
+    connection_selection selection = connection_selection::lifo; //!< policy to select one of available idle connections
+    connection_queue_quota queue_quota = { //!< maximum number of queued requests per priority, unlimited by default
+        std::numeric_limits<std::size_t>::max(),
+        std::numeric_limits<std::size_t>::max(),
+        std::numeric_limits<std::size_t>::max(),
+    };
+    bool deadline_admission = false; //!< reject requests which are unlikely to meet their deadlines, see `ozo::connection_pool`
 };
 
 /**
@@ -50,13 +103,15 @@ struct connection_traits {
     using statistics_type = typename Rep::statistics_type; //!< Connection statistics to be collected
 };
 
-template <typename OidMap, typename Statistics = none_t>
+template <typename OidMap, typename Statistics = none_t, typename Executor = asio::io_context::executor_type>
 class connection_rep {
 public:
     using oid_map_type = OidMap;
     using native_handle_type = typename ozo::pg::conn::pointer;
     using statistics_type = Statistics;
     using error_context_type = std::string;
+    using executor_type = Executor;
+    using stream_type = typename detail::pooled_stream<executor_type>::stream_type;
 
     const ozo::pg::conn& safe_native_handle() const & {return safe_handle_;}
     ozo::pg::conn& safe_native_handle() & {return safe_handle_;}
@@ -67,8 +122,8 @@ public:
     const auto& statistics() const & {return statistics_;}
 
     template <typename Key, typename Value>
-    void update_statistics(const Key&, Value&&) noexcept {
-        static_assert(std::is_void_v<Key>, "update_statistics is not supperted");
+    void update_statistics(const Key& key, Value&& value) noexcept {
+        ozo::update_statistics(statistics_, key, std::forward<Value>(value));
     }
 
     const error_context_type& get_error_context() const noexcept {
@@ -78,6 +133,34 @@ public:
         error_context_ = std::move(v);
     }
 
+    /**
+     * Get the time point the connection representation was created at.
+     * It is used by the pool to limit the connection lifespan.
+     */
+    time_traits::time_point created_at() const noexcept { return created_at_;}
+
+    /**
+     * Get the connection socket stream registered within the executor's
+     * execution context. The registration is kept between pool checkouts
+     * and is made again only for an executor of another execution context.
+     *
+     * @param ex --- executor of the connection.
+     * @return stream_type& --- reference on the stream.
+     */
+    stream_type& bind_stream(const executor_type& ex) {
+        return stream_.bind(ex, safe_handle_.get());
+    }
+
+    /**
+     * Unregister the connection socket from the reactor without closing it.
+     */
+    void release_stream() noexcept { stream_.release(); }
+
+    /**
+     * Cancel asynchronous operations on the connection socket if it is registered.
+     */
+    void cancel_stream() noexcept { stream_.cancel(); }
+
     connection_rep(
         ozo::pg::conn&& safe_handle,
         OidMap oid_map = OidMap{},
@@ -87,11 +170,19 @@ public:
       oid_map_(std::move(oid_map)),
       error_context_(std::move(error_context)),
       statistics_(std::move(statistics)) {}
+
+    connection_rep(connection_rep&&) = default;
+    connection_rep& operator =(connection_rep&&) = default;
+
+    ~connection_rep() { release_stream(); }
 private:
+    // The stream goes first to be released before the handle is closed on assignment.
+    detail::pooled_stream<executor_type> stream_;
     ozo::pg::conn safe_handle_;
     oid_map_type oid_map_;
     error_context_type error_context_;
     statistics_type statistics_;
+    time_traits::time_point created_at_ = time_traits::now();
 };
 
 /**
@@ -104,6 +195,10 @@ private:
  * status is different than `ozo::transaction_status::idle` then it will not return to
  * the pool and be closed. The class object is non-copyable.
  *
+ * The connection socket stays registered within the execution context of the executor
+ * between checkouts, so getting an idle connection for the same execution context
+ * does not register the socket again.
+ *
  * @tparam Rep      --- underlying connection pool representation for the real connection.
  * @tparam Executor --- the type of the executor is used to perform IO; currently only
  *                      `boost::asio::io_context::executor_type` is supported.
@@ -143,7 +238,7 @@ public:
 
     template <typename Key, typename Value>
     void update_statistics(const Key& key, Value&& v) noexcept {
-        ozo::unwrap(rep_).update_statistics(key, std::forward<Value(v)>);
+        ozo::unwrap(rep_).update_statistics(key, std::forward<Value>(v));
     }
     const statistics_type& statistics() const noexcept { return ozo::unwrap(rep_).statistics();}
 
@@ -249,11 +344,10 @@ public:
 
     ~pooled_connection();
 private:
-    using stream_type = typename detail::connection_stream<executor_type>::type;
+    decltype(auto) stream() { return ozo::unwrap(rep_).bind_stream(ex_); }
 
     rep_type rep_;
     executor_type ex_;
-    stream_type stream_;
 };
 
 template <typename ...Ts>
@@ -263,6 +357,13 @@ template <typename T>
 struct connection_traits<yamail::resource_pool::handle<T>> :
     connection_traits<typename yamail::resource_pool::handle<T>::value_type> {};
 
+template <typename T>
+struct connection_traits<detail::pooled_handle<T>> :
+    connection_traits<typename detail::pooled_handle<T>::value_type> {};
+
+template <typename Pool>
+class prioritized_connection_source;
+
 /**
  * @brief Connection pool implementation
  *
@@ -279,6 +380,32 @@ struct connection_traits<yamail::resource_pool::handle<T>> :
  *
  * The request may be limited by time via optional `connection_pool_timeouts` argument of the `connection_pool::operator()`.
  *
+ * Requests in the queue are served in order of their `ozo::connection_priority`. With `connection_pool_config::deadline_admission`
+ * enabled the pool estimates the time connections are used for and rejects the request with the
+ * `yamail::resource_pool::error::get_resource_timeout` error early, instead of spending a connection on it, if the request
+ * deadline is unlikely to be met after waiting for the requests ahead of it in the queue.
+ *
+ * If there are several idle connections the one is provided according to the `connection_pool_config::selection` policy.
+ *
+ * Before an idle connection is provided it is checked without a round trip to the server: the socket is polled for
+ * pending input with zero timeout and the input is consumed by libpq if any. So connections closed by a server or
+ * a connection pooler restart are replaced with new ones instead of failing the first request. Connections silently
+ * dropped by the network can be detected this way with TCP keepalives enabled via libpq connection parameters
+ * (`keepalives_idle`, `keepalives_interval`, `keepalives_count`).
+ *
+ * Idle connections keep their sockets registered within the execution context they were used with last time,
+ * and memory of the `pooled_connection` objects is reused, so the checkout of an idle connection
+ * for the same execution context performs neither memory allocation nor socket registration.
+ *
+ * @warning Since idle connections keep sockets registered, the pool should be destroyed before
+ * the `io_context` objects it was used with. Earlier versions allowed the pool to outlive them,
+ * so make sure the pool is declared after (i.e. destroyed before) the `io_context` objects, e.g.
+ *
+ * @code
+boost::asio::io_context io;
+ozo::connection_pool pool(source, config); // destroyed before io
+ * @endcode
+ *
  * `connection_pool` models `ConnectionSource` concept itself using underlying `ConnectionSource`.
  *
  * @tparam Source --- underlying `ConnectionSource` which is being used to create connection to a database.
@@ -303,7 +430,9 @@ class connection_pool {
     static_assert(ConnectionSource<Source>, "should model ConnectionSource concept");
 
 public:
-    using connection_rep_type = ozo::connection_rep<typename ozo::unwrap_type<ozo::connection_type<Source>>::oid_map_type>;
+    using connection_rep_type = ozo::connection_rep<
+        typename ozo::unwrap_type<ozo::connection_type<Source>>::oid_map_type,
+        detail::get_pooled_statistics_t<ozo::unwrap_type<ozo::connection_type<Source>>>>;
 
     using impl_type = detail::get_connection_pool_impl_t<connection_rep_type, ThreadSafety>;
     /**
@@ -315,13 +444,13 @@ public:
      * Thread safe by default (`ozo::thread_safety<true>`).
      */
     connection_pool(Source source, const connection_pool_config& config, const ThreadSafety& /*thread_safety*/ = ThreadSafety{})
-    : impl_(config.capacity, config.queue_capacity, config.idle_timeout, config.lifespan),
+    : state_(std::make_shared<state_type>(config)),
       source_(std::move(source)) {}
 
     /**
      * Type of connection depends on connection type of Source. The definition is used to model `ConnectionSource`
      */
-    using connection_type = std::shared_ptr<pooled_connection<yamail::resource_pool::handle<connection_rep_type>>>;
+    using connection_type = std::shared_ptr<pooled_connection<detail::pooled_handle<yamail::resource_pool::handle<connection_rep_type>>>>;
 
     /**
      * Get connection is bound to the given `io_context` object.
@@ -334,32 +463,98 @@ public:
      * @param handler --- #Handler.
      */
     template <typename TimeConstraint, typename Handler>
-    void operator ()(io_context& io, TimeConstraint t, Handler&& handler);
+    void operator ()(io_context& io, TimeConstraint t, Handler&& handler) {
+        (*this)(io, t, connection_priority::normal, std::forward<Handler>(handler));
+    }
 
+    /**
+     * Get connection is bound to the given `io_context` object with the given priority.
+     * If the request has to wait in the pool's queue, it is served before requests
+     * of lower priority.
+     *
+     * @param io --- `io_context` for the connection IO.
+     * @param t --- operation time constraint.
+     * @param priority --- priority of the request.
+     * @param handler --- #Handler.
+     */
+    template <typename TimeConstraint, typename Handler>
+    void operator ()(io_context& io, TimeConstraint t, connection_priority priority, Handler&& handler);
+
+    /**
+     * Get the pool statistics. Idle connections which are kept by the pool
+     * for the selection policy are counted as available.
+     */
     auto stats() const {
-        return impl_.stats();
+        return state_->stats();
     }
 
     auto operator [](io_context& io) {
         return connection_provider(*this, io);
     }
 
+    /**
+     * Get `ConnectionSource` which requests connections from the pool with the given priority.
+     *
+     * ###Example
+     *
+     * @code
+ozo::request(pool.with_priority(ozo::connection_priority::high)[io], query, timeout, ozo::into(result), yield);
+     * @endcode
+     *
+     * @param priority --- priority of the requests.
+     * @return `ozo::prioritized_connection_source` object.
+     */
+    auto with_priority(connection_priority priority) {
+        return prioritized_connection_source<connection_pool>(*this, priority);
+    }
+
 private:
+    static time_traits::time_point queue_deadline(none_t) {
+        return time_traits::time_point::max();
+    }
 
-    auto queue_timeout(time_traits::time_point at) const {
-        return time_left(at);
+    template <typename TimeConstraint>
+    static time_traits::time_point queue_deadline(TimeConstraint t) {
+        return deadline(t);
     }
 
-    auto queue_timeout(time_traits::duration t) const {
-        return t;
+    using state_type = detail::connection_pool_state<connection_rep_type, ThreadSafety>;
+
+    std::shared_ptr<state_type> state_;
+    Source source_;
+};
+
+/**
+ * @brief `ConnectionSource` which requests connections from the pool with a priority
+ *
+ * Is created by `ozo::connection_pool::with_priority()`. The pool should outlive the object.
+ *
+ * @tparam Pool --- `ozo::connection_pool` type.
+ * @ingroup group-connection-types
+ * @models{ConnectionSource}
+ */
+template <typename Pool>
+class prioritized_connection_source {
+public:
+    using connection_type = typename Pool::connection_type;
+
+    prioritized_connection_source(Pool& pool, connection_priority priority)
+    : pool_(std::addressof(pool)), priority_(priority) {}
+
+    template <typename TimeConstraint, typename Handler>
+    void operator ()(io_context& io, TimeConstraint t, Handler&& handler) const {
+        (*pool_)(io, t, priority_, std::forward<Handler>(handler));
     }
 
-    auto queue_timeout(none_t) const {
-        return time_traits::duration(0);
+    auto operator [](io_context& io) const {
+        return connection_provider(*this, io);
     }
 
-    impl_type impl_;
-    Source source_;
+    connection_priority priority() const noexcept { return priority_;}
+
+private:
+    Pool* pool_;
+    connection_priority priority_;
 };
 
 //[[DEPRECATED]] for backward compatibility only
@@ -375,6 +570,8 @@ template <typename ...Ts>
 }
 
 static_assert(ConnectionProvider<decltype(std::declval<connection_pool<connection_info<>>>()[std::declval<io_context&>()])>, "is not a ConnectionProvider");
+static_assert(ConnectionProvider<decltype(std::declval<connection_pool<connection_info<>>>()
+    .with_priority(connection_priority::high)[std::declval<io_context&>()])>, "is not a ConnectionProvider");
 
 template <typename T>
 struct is_connection_pool : std::false_type {};
@@ -1,28 +1,260 @@
 #pragma once
 
+#include <ozo/core/none.h>
 #include <ozo/core/thread_safety.h>
 #include <ozo/detail/stub_mutex.h>
+#include <ozo/time_traits.h>
 
 #include <yamail/resource_pool/async/pool.hpp>
 
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace ozo::detail {
 
-template <typename ConnectionRepType, typename ThreadSafety>
-struct get_connection_pool_impl;
+template <typename ThreadSafety>
+struct get_connection_pool_mutex;
+
+template <>
+struct get_connection_pool_mutex<thread_safety<true>> {
+    using type = std::mutex;
+};
 
-template <typename ConnectionRepType>
-struct get_connection_pool_impl<ConnectionRepType, thread_safety<true>> {
-    using type = yamail::resource_pool::async::pool<ConnectionRepType, std::mutex>;
+template <>
+struct get_connection_pool_mutex<thread_safety<false>> {
+    using type = stub_mutex;
 };
 
-template <typename ConnectionRepType>
-struct get_connection_pool_impl<ConnectionRepType, thread_safety<false>> {
-    using type = yamail::resource_pool::async::pool<ConnectionRepType, stub_mutex>;
+template <typename ThreadSafety>
+using get_connection_pool_mutex_t = typename get_connection_pool_mutex<std::decay_t<ThreadSafety>>::type;
+
+template <typename ConnectionRepType, typename ThreadSafety>
+struct get_connection_pool_impl {
+    using type = yamail::resource_pool::async::pool<ConnectionRepType, get_connection_pool_mutex_t<ThreadSafety>>;
 };
 
 template <typename ConnectionRepType, typename ThreadSafety>
 using get_connection_pool_impl_t = typename get_connection_pool_impl<ConnectionRepType, std::decay_t<ThreadSafety>>::type;
 
+template <typename ConnectionRepType, typename ThreadSafety>
+class connection_pool_state;
+
+/**
+ * Statistics of the connection which is provided by the source of the pool are kept by
+ * the pooled connection representation, so requests on pooled connections update them.
+ * Connections without statistics get `ozo::none_t`.
+ */
+template <typename Connection, typename = std::void_t<>>
+struct get_pooled_statistics {
+    using type = none_t;
+
+    static type apply(const Connection&) noexcept { return {};}
+};
+
+template <typename Connection>
+struct get_pooled_statistics<Connection, std::void_t<decltype(std::declval<const Connection&>().statistics())>> {
+    using type = std::decay_t<decltype(std::declval<const Connection&>().statistics())>;
+
+    static type apply(const Connection& conn) { return conn.statistics();}
+};
+
+template <typename Connection>
+using get_pooled_statistics_t = typename get_pooled_statistics<Connection>::type;
+
+/**
+ * @brief Receiver of the connection handles which are released by users
+ *
+ * @tparam Handle --- connection pool handle type.
+ */
+template <typename Handle>
+class handle_recycler {
+public:
+    /**
+     * Take the handle of the released connection.
+     *
+     * @param handle --- handle of the connection, it is unusable if the connection has been wasted.
+     * @param context --- address of the execution context the connection was used with.
+     * @param usage --- time the connection was used for since it had been provided.
+     */
+    virtual void recycle(Handle&& handle, const void* context, time_traits::duration usage) noexcept = 0;
+
+protected:
+    ~handle_recycler() = default;
+};
+
+/**
+ * @brief Connection pool handle which is returned to the connection pool idle connections
+ *
+ * Wraps the underlying pool handle to return it into `ozo::detail::handle_recycler`
+ * instead of the underlying pool on destruction, so `ozo::connection_pool` may select
+ * idle connections according to its policy. Wasted handles go to the underlying
+ * pool directly, and then the recycler is notified about the freed pool slot.
+ *
+ * @tparam Handle --- underlying connection pool handle type.
+ */
+template <typename Handle>
+class pooled_handle {
+public:
+    using handle_type = Handle;
+    using value_type = typename handle_type::value_type;
+    using recycler_type = handle_recycler<handle_type>;
+
+    pooled_handle() = default;
+
+    pooled_handle(handle_type handle, std::shared_ptr<recycler_type> recycler, const void* context) noexcept
+    : handle_(std::move(handle)), recycler_(std::move(recycler)), context_(context),
+      provided_at_(recycler_ ? time_traits::now() : time_traits::time_point{}) {}
+
+    pooled_handle(pooled_handle&&) = default;
+
+    pooled_handle& operator =(pooled_handle&& other) {
+        recycle();
+        handle_ = std::move(other.handle_);
+        recycler_ = std::move(other.recycler_);
+        context_ = other.context_;
+        provided_at_ = other.provided_at_;
+        return *this;
+    }
+
+    ~pooled_handle() { recycle(); }
+
+    bool empty() const noexcept { return handle_.empty(); }
+
+    void reset(value_type&& value) { handle_.reset(std::move(value)); }
+
+    void waste() {
+        handle_.waste();
+        recycle();
+    }
+
+    value_type& operator *() { return *handle_; }
+    const value_type& operator *() const { return *handle_; }
+    value_type* operator ->() { return std::addressof(*handle_); }
+    const value_type* operator ->() const { return std::addressof(*handle_); }
+
+private:
+    void recycle() noexcept {
+        if (auto recycler = std::move(recycler_)) {
+            recycler->recycle(std::move(handle_), context_, time_traits::now() - provided_at_);
+        }
+    }
+
+    handle_type handle_;
+    std::shared_ptr<recycler_type> recycler_;
+    const void* context_ = nullptr;
+    time_traits::time_point provided_at_;
+};
+
+/**
+ * @brief Cache of the memory blocks of pooled connection objects
+ *
+ * Every pool checkout produces a new `ozo::pooled_connection` object. The cache keeps
+ * memory blocks of destroyed objects to reuse them for the next checkouts, so a
+ * checkout of an idle connection performs no memory allocation. Since all the
+ * objects have the same type only blocks of the first requested size are cached,
+ * other requests are forwarded to the global allocation functions.
+ *
+ * @tparam Mutex --- mutex type to synchronize access to the cache.
+ */
+template <typename Mutex>
+class block_cache {
+public:
+    explicit block_cache(std::size_t capacity) : capacity_(capacity) {
+        blocks_.reserve(capacity_);
+    }
+
+    block_cache(const block_cache&) = delete;
+    block_cache& operator =(const block_cache&) = delete;
+
+    ~block_cache() {
+        for (auto block : blocks_) {
+            ::operator delete(block);
+        }
+    }
+
+    void* allocate(std::size_t size) {
+        {
+            const std::lock_guard<Mutex> lock(mutex_);
+            if (block_size_ == 0) {
+                block_size_ = size;
+            }
+            if (size == block_size_ && !blocks_.empty()) {
+                auto block = blocks_.back();
+                blocks_.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void* block, std::size_t size) noexcept {
+        {
+            const std::lock_guard<Mutex> lock(mutex_);
+            if (size == block_size_ && blocks_.size() < capacity_) {
+                blocks_.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+private:
+    Mutex mutex_;
+    std::size_t capacity_;
+    std::size_t block_size_ = 0;
+    std::vector<void*> blocks_;
+};
+
+/**
+ * @brief Allocator which takes memory from the `ozo::detail::block_cache`
+ *
+ * The allocator is kept by handlers of requests which wait in the pool queue, so it
+ * refers to the cache weakly. If the cache has been destroyed with the pool, memory
+ * is allocated via the global allocation functions, so the blocks are compatible.
+ *
+ * @tparam T --- value type.
+ * @tparam Cache --- cache type.
+ */
+template <typename T, typename Cache>
+struct cached_allocator {
+    using value_type = T;
+
+    std::weak_ptr<Cache> cache_;
+
+    explicit cached_allocator(std::weak_ptr<Cache> cache) noexcept : cache_(std::move(cache)) {}
+
+    template <typename U>
+    cached_allocator(const cached_allocator<U, Cache>& other) noexcept : cache_(other.cache_) {}
+
+    template <typename U>
+    struct rebind {
+        using other = cached_allocator<U, Cache>;
+    };
+
+    T* allocate(std::size_t n) {
+        if (const auto cache = cache_.lock()) {
+            return static_cast<T*>(cache->allocate(sizeof(T) * n));
+        }
+        return static_cast<T*>(::operator new(sizeof(T) * n));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (const auto cache = cache_.lock()) {
+            return cache->deallocate(p, sizeof(T) * n);
+        }
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    friend bool operator ==(const cached_allocator& lhs, const cached_allocator<U, Cache>& rhs) noexcept {
+        return !lhs.cache_.owner_before(rhs.cache_) && !rhs.cache_.owner_before(lhs.cache_);
+    }
+
+    template <typename U>
+    friend bool operator !=(const cached_allocator& lhs, const cached_allocator<U, Cache>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
+
 } // namespace ozo::detail
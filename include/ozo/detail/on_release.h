@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ozo::detail {
+
+template <typename T>
+struct is_std_shared_ptr : std::false_type {};
+
+template <typename T>
+struct is_std_shared_ptr<std::shared_ptr<T>> : std::true_type {};
+
+template <typename Connection, typename Callback>
+class release_guard {
+public:
+    release_guard(Connection conn, Callback callback)
+    : conn_(std::move(conn)), callback_(std::move(callback)) {}
+
+    release_guard(const release_guard&) = delete;
+    release_guard& operator =(const release_guard&) = delete;
+
+    ~release_guard() { callback_(std::as_const(conn_)); }
+
+private:
+    Connection conn_;
+    Callback callback_;
+};
+
+/**
+ * @brief Call a function then a connection is released
+ *
+ * If the connection is `std::shared_ptr` the function returns an aliasing pointer
+ * to the same connection object which keeps the original pointer. The callback is
+ * called with the original connection then all the copies of the returned pointer
+ * are destroyed, i.e. then the user is done with the connection. So a connection
+ * source wrapper may observe the whole connection usage without changing the
+ * connection type. For other connection types the callback is called immediately.
+ *
+ * @param conn --- connection to observe.
+ * @param callback --- function with `void(const Connection&)` signature.
+ * @return Connection --- connection to pass to the user.
+ */
+template <typename Connection, typename Callback>
+inline std::decay_t<Connection> on_release(Connection&& conn, Callback&& callback) {
+    using connection_type = std::decay_t<Connection>;
+    if constexpr (is_std_shared_ptr<connection_type>::value) {
+        auto ptr = conn.get();
+        auto guard = std::make_shared<release_guard<connection_type, std::decay_t<Callback>>>(
+            std::forward<Connection>(conn), std::forward<Callback>(callback));
+        return connection_type(guard, ptr);
+    } else {
+        callback(std::as_const(conn));
+        return std::forward<Connection>(conn);
+    }
+}
+
+} // namespace ozo::detail
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <ozo/asio.h>
+#include <ozo/error.h>
+
+#include <libpq-fe.h>
+
+#include <optional>
+
+namespace ozo::detail {
+
+/**
+ * @brief Connection socket stream which outlives a single pool checkout
+ *
+ * Keeps the connection socket registered within the reactor of an execution
+ * context between checkouts of a pooled connection. The stream is bound to
+ * the descriptor lazily and rebound only if the connection is requested for
+ * an executor of another execution context or the descriptor has changed,
+ * so a typical checkout neither constructs a stream nor registers the
+ * descriptor again.
+ *
+ * The stream never owns the descriptor --- it is released before destruction
+ * since the descriptor is closed by `PQfinish()`.
+ *
+ * @note The execution context the stream is bound to should outlive the object.
+ *
+ * @tparam Executor --- executor type of the pooled connection.
+ */
+template <typename Executor>
+class pooled_stream {
+public:
+    using stream_type = typename connection_stream<Executor>::type;
+
+    pooled_stream() = default;
+
+    pooled_stream(pooled_stream&& other) noexcept
+    : stream_(std::move(other.stream_)), context_(other.context_), fd_(other.fd_) {
+        other.stream_.reset();
+        other.context_ = nullptr;
+        other.fd_ = -1;
+    }
+
+    pooled_stream& operator =(pooled_stream&& other) noexcept {
+        if (this != std::addressof(other)) {
+            release();
+            stream_ = std::move(other.stream_);
+            context_ = other.context_;
+            fd_ = other.fd_;
+            other.stream_.reset();
+            other.context_ = nullptr;
+            other.fd_ = -1;
+        }
+        return *this;
+    }
+
+    ~pooled_stream() { release(); }
+
+    /**
+     * Get the stream registered within the executor's execution context
+     * for the connection descriptor. The registration is reused if possible.
+     *
+     * @param ex --- executor of the connection.
+     * @param handle --- native connection handle to get the descriptor from.
+     * @return stream_type& --- reference on the stream.
+     */
+    template <typename NativeHandle>
+    stream_type& bind(const Executor& ex, NativeHandle handle) {
+        const void* context = std::addressof(ex.context());
+        const int fd = handle ? PQsocket(handle) : -1;
+        if (!stream_ || context_ != context || fd_ != fd) {
+            release();
+            stream_.emplace(get_connection_stream(ex));
+            if (fd != -1) {
+                stream_->assign(fd);
+            }
+            context_ = context;
+            fd_ = fd;
+        }
+        return *stream_;
+    }
+
+    /**
+     * Cancel asynchronous operations of the stream if it is bound. Unlike `bind()`
+     * the function never registers the descriptor, so it does not throw.
+     */
+    void cancel() noexcept {
+        if (stream_) {
+            error_code _;
+            stream_->cancel(_);
+        }
+    }
+
+    /**
+     * Release the descriptor and unregister it from the reactor.
+     * The descriptor is not closed.
+     */
+    void release() noexcept {
+        if (stream_) {
+            if (fd_ != -1) {
+                stream_->release();
+            }
+            stream_.reset();
+        }
+        context_ = nullptr;
+        fd_ = -1;
+    }
+
+private:
+    std::optional<stream_type> stream_;
+    const void* context_ = nullptr;
+    int fd_ = -1;
+};
+
+} // namespace ozo::detail
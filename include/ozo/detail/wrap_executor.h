@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ozo/asio.h>
+#include <ozo/detail/bind.h>
 
 #include <boost/asio/dispatch.hpp>
 
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <ozo/io/binary_query.h>
+#include <ozo/io/size_of.h>
+#include <ozo/type_traits.h>
+
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ozo {
+namespace detail {
+
+/**
+ * Text and serialized parameters of a dynamic query in the form `binary_query` provides them.
+ * Parameter values point into the buffer, so they are updated each time the buffer is reallocated.
+ */
+struct dynamic_query_data {
+    std::string text_;
+    std::vector<char> buffer_;
+    std::vector<oid_t> types_;
+    std::vector<int> formats_;
+    std::vector<int> lengths_;
+    std::vector<std::size_t> offsets_;
+    std::vector<const char*> values_;
+
+    dynamic_query_data() = default;
+
+    dynamic_query_data(const dynamic_query_data& other)
+    : text_(other.text_), buffer_(other.buffer_), types_(other.types_), formats_(other.formats_),
+      lengths_(other.lengths_), offsets_(other.offsets_), values_(other.values_.size()) {
+        update_values();
+    }
+
+    dynamic_query_data& operator =(const dynamic_query_data&) = delete;
+
+    void update_values() noexcept {
+        for (std::size_t i = 0; i < values_.size(); ++i) {
+            values_[i] = lengths_[i] ? std::data(buffer_) + offsets_[i] : nullptr;
+        }
+    }
+
+    void clear() noexcept {
+        text_.clear();
+        buffer_.clear();
+        types_.clear();
+        formats_.clear();
+        lengths_.clear();
+        offsets_.clear();
+        values_.clear();
+    }
+
+    const char* text() const noexcept { return text_.c_str(); }
+    const oid_t* types() const noexcept { return std::data(types_); }
+    const int* formats() const noexcept { return std::data(formats_); }
+    const int* lengths() const noexcept { return std::data(lengths_); }
+    const char* const* values() const noexcept { return std::data(values_); }
+    std::ptrdiff_t params_count() const noexcept { return std::ptrdiff_t(values_.size()); }
+    bool is_prepared() const noexcept { return false; }
+};
+
+} // namespace detail
+
+/**
+ * @brief Query which is built at runtime
+ *
+ * The builder appends SQL text fragments and typed parameters into its buffers. Parameters are
+ * numbered as `$N` automatically and serialized in the binary format right away, so the query
+ * is converted into `ozo::binary_query` without copying of the text or parameters. The query
+ * models `BinaryQueryConvertible`, so it may be passed to `ozo::request()` and `ozo::execute()`.
+ *
+ * The builder may be reused via `reset()` which keeps allocated buffers. A `binary_query` made
+ * from the builder shares its buffers, so the builder modified while the `binary_query` is alive
+ * (e.g. the request is in progress) copies the buffers first.
+ *
+ * @code
+ozo::dynamic_query query;
+query.text("SELECT id, name FROM users WHERE rating > ").param(min_rating);
+if (name) {
+    query.text(" AND name = ").param(*name);
+}
+query.text(" AND id ").any(ids);
+ozo::request(pool[io], query, deadline, ozo::into(result), yield);
+...
+query.reset();
+ * @endcode
+ *
+ * Parameters are serialized with the `OidMap` given on construction, so queries with custom
+ * type parameters should be built with the `OidMap` of the connection source after it is filled
+ * by a connection.
+ *
+ * @tparam OidMap --- #OidMap with custom types used by parameters.
+ * @ingroup group-query-types
+ * @models{BinaryQueryConvertible}
+ */
+template <typename OidMap = empty_oid_map>
+class basic_dynamic_query {
+public:
+    using oid_map_type = OidMap;
+
+    /**
+     * Construct a new empty query.
+     *
+     * @param oid_map --- #OidMap for custom type parameters.
+     */
+    explicit basic_dynamic_query(OidMap oid_map = OidMap{})
+    : oid_map_(std::move(oid_map)), data_(std::make_shared<detail::dynamic_query_data>()) {}
+
+    /**
+     * Append SQL text fragment.
+     */
+    basic_dynamic_query& text(std::string_view value) {
+        mutable_data().text_.append(value);
+        return *this;
+    }
+
+    /**
+     * Append a parameter placeholder `$N` and the parameter value.
+     *
+     * @param value --- parameter value of a type which is supported by the type system.
+     */
+    template <typename T>
+    basic_dynamic_query& param(const T& value) {
+        auto& data = mutable_data();
+        append_placeholder(data);
+        append_value(data, value);
+        return *this;
+    }
+
+    /**
+     * Append `= ANY($N)` with the array parameter. It replaces `IN ($1, $2, ...)` list
+     * with a single parameter, so the query text does not depend on the number of values.
+     *
+     * @param values --- array of values, should model `Array` concept.
+     */
+    template <typename T>
+    basic_dynamic_query& any(const T& values) {
+        static_assert(Array<T>, "values should model Array concept");
+        auto& data = mutable_data();
+        data.text_.append("= ANY(");
+        append_placeholder(data);
+        data.text_.push_back(')');
+        append_value(data, values);
+        return *this;
+    }
+
+    /**
+     * Clear the text and parameters. Allocated buffers are reused by the next query.
+     */
+    void reset() {
+        if (data_.use_count() > 1) {
+            data_ = std::make_shared<detail::dynamic_query_data>();
+        } else {
+            data_->clear();
+        }
+    }
+
+    /**
+     * Query text built so far.
+     */
+    std::string_view get_text() const noexcept { return data_->text_; }
+
+    /**
+     * Number of parameters.
+     */
+    std::size_t params_count() const noexcept { return data_->values_.size(); }
+
+    /**
+     * #OidMap which is used for parameters serialization.
+     */
+    const oid_map_type& oid_map() const noexcept { return oid_map_; }
+
+    /**
+     * Query data which is shared with `ozo::binary_query`.
+     */
+    std::shared_ptr<const detail::dynamic_query_data> data() const noexcept { return data_; }
+
+private:
+    detail::dynamic_query_data& mutable_data() {
+        if (data_.use_count() > 1) {
+            data_ = std::make_shared<detail::dynamic_query_data>(*data_);
+        }
+        return *data_;
+    }
+
+    void append_placeholder(detail::dynamic_query_data& data) const {
+        char number[24];
+        const auto result = std::to_chars(std::begin(number), std::end(number), data.values_.size() + 1);
+        data.text_.push_back('$');
+        data.text_.append(number, result.ptr);
+    }
+
+    template <typename T>
+    void append_value(detail::dynamic_query_data& data, const T& value) {
+        const auto buffer = std::data(data.buffer_);
+        const auto offset = data.buffer_.size();
+        ozo::ostream os(data.buffer_);
+        send(os, oid_map_, value);
+        data.types_.push_back(type_oid(oid_map_, value));
+        data.formats_.push_back(1);
+        data.lengths_.push_back(std::max(0, size_of(value)));
+        data.offsets_.push_back(offset);
+        data.values_.push_back(data.lengths_.back() ? std::data(data.buffer_) + offset : nullptr);
+        if (buffer != std::data(data.buffer_)) {
+            data.update_values();
+        }
+    }
+
+    oid_map_type oid_map_;
+    std::shared_ptr<detail::dynamic_query_data> data_;
+};
+
+/**
+ * @brief Query which is built at runtime with built-in type parameters
+ * @ingroup group-query-types
+ */
+using dynamic_query = basic_dynamic_query<>;
+
+template <typename OidMap>
+struct to_binary_query_impl<basic_dynamic_query<OidMap>> {
+    template <typename OtherOidMap, typename Alloc>
+    static binary_query apply(const basic_dynamic_query<OidMap>& query, const OtherOidMap&, const Alloc& allocator) {
+        return binary_query(query.data(), allocator);
+    }
+};
+
+} // namespace ozo
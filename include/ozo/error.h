@@ -96,6 +96,9 @@ enum code {
     bad_composite_size, //!< a composite's fields number received does not equal to the expected or not supported by the type
     pq_cancel_failed, //!< libpq PQcancel function call failed, see `get_error_context()` for more information
     pq_get_cancel_failed, //!< libpq PQgetCancel function call failed, see `get_error_context()` for more information
+    circuit_open, //!< circuit breaker of the connection source is open - the host is considered unavailable, no connection attempt has been made
+    pg_pipeline_failed, //!< libpq pipeline mode function failed, see `get_error_context()` for more information
+    bad_result_process_after_commit, //!< error while processing or converting result of a statement which has been committed (or whose savepoint has been released) anyway
 };
 
 /**
@@ -493,6 +496,12 @@ public:
                 return "libpq PQcancel function call failed";
             case pq_get_cancel_failed:
                 return "libpq PQgetCancel function call failed";
+            case circuit_open:
+                return "circuit_open - circuit breaker of the connection source is open";
+            case pg_pipeline_failed:
+                return "pg_pipeline_failed - libpq pipeline mode function failed";
+            case bad_result_process_after_commit:
+                return "bad_result_process_after_commit - error while processing or converting result of committed statements";
         }
         return "no message for value: " + std::to_string(value);
     }
@@ -885,7 +894,9 @@ struct codes_for_condition<connection_error> {
         ozo::error::pg_send_query_params_failed,
         ozo::error::pg_consume_input_failed,
         ozo::error::pg_set_nonblocking_failed,
-        ozo::error::pg_flush_failed
+        ozo::error::pg_flush_failed,
+        ozo::error::circuit_open,
+        ozo::error::pg_pipeline_failed
     );
 };
 
@@ -898,6 +909,7 @@ template <>
 struct codes_for_condition<introspection_error> {
     constexpr static auto value = hana::make_tuple(
         ozo::error::bad_result_process,
+        ozo::error::bad_result_process_after_commit,
         ozo::error::bad_object_size,
         ozo::error::bad_array_size,
         ozo::error::bad_array_dimension,
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <ozo/connection.h>
+#include <ozo/time_traits.h>
+#include <ozo/detail/on_release.h>
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <vector>
+
+/**
+ * @defgroup group-failover-balanced Load-Balanced Connection Source
+ * @ingroup group-failover
+ * @brief Latency-aware load balancing between several connection sources
+ *
+ * A role of `ozo::failover::role_based_connection_source` is backed by a single `ConnectionSource`.
+ * If a role is served by several hosts, e.g. replicas, `ozo::failover::balanced_connection_source`
+ * combines their sources into one. For each request it picks two random sources and uses one of them
+ * with the lower load (the power of two choices). The load of a source is estimated as exponentially
+ * weighted moving average of its latency multiplied by number of its requests in progress. So the traffic
+ * drifts away from a host which becomes slow, e.g. due to vacuum or replication lag, and returns back
+ * then the host recovers.
+ *
+ * @code
+auto conn_source = ozo::failover::make_role_based_connection_source(
+    ozo::failover::master=ozo::connection_info(cfg.master_connstr),
+    ozo::failover::replica=ozo::failover::make_balanced_connection_source(
+        ozo::connection_info(cfg.replica1_connstr),
+        ozo::connection_info(cfg.replica2_connstr),
+        ozo::connection_info(cfg.replica3_connstr)
+    )
+);
+ * @endcode
+ */
+
+namespace ozo::failover {
+
+/**
+ * @brief Configuration of the `ozo::failover::balanced_connection_source`
+ * @ingroup group-failover-balanced
+ */
+struct balanced_connection_source_config {
+    double smoothing = 0.2; //!< weight of a new latency sample in the moving average, a value in range (0, 1]
+    time_traits::duration error_penalty = std::chrono::seconds(1); //!< minimum latency accounted for a failed connection request
+};
+
+namespace detail {
+
+/**
+ * Load statistics of a single source of the `ozo::failover::balanced_connection_source`.
+ * Updates are lock-free, concurrent samples may be lost which is acceptable for an estimation.
+ */
+class balanced_source_load {
+public:
+    using rep = time_traits::duration::rep;
+
+    void begin() noexcept { in_flight_.fetch_add(1, std::memory_order_relaxed); }
+
+    void end(time_traits::duration latency, double smoothing) noexcept {
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        const auto sample = static_cast<double>(latency.count());
+        const auto old = latency_.load(std::memory_order_relaxed);
+        const auto estimate = old == 0 ? sample : old + smoothing * (sample - static_cast<double>(old));
+        latency_.store(static_cast<rep>(estimate), std::memory_order_relaxed);
+    }
+
+    time_traits::duration latency() const noexcept {
+        return time_traits::duration(latency_.load(std::memory_order_relaxed));
+    }
+
+    std::size_t in_flight() const noexcept { return in_flight_.load(std::memory_order_relaxed); }
+
+    /**
+     * Load estimation. Sources without samples have zero latency estimation, so they are
+     * preferred until the first sample and are compared by number of requests in progress.
+     */
+    double cost() const noexcept {
+        return (static_cast<double>(latency().count()) + 1.0) * static_cast<double>(in_flight() + 1);
+    }
+
+private:
+    std::atomic<rep> latency_{0};
+    std::atomic<std::size_t> in_flight_{0};
+};
+
+template <typename Source>
+struct balanced_source_state {
+    struct node {
+        Source source;
+        balanced_source_load load;
+
+        explicit node(Source s) : source(std::move(s)) {}
+    };
+
+    std::vector<std::unique_ptr<node>> nodes;
+    balanced_connection_source_config config;
+
+    node& pick() {
+        if (nodes.size() == 1) {
+            return *nodes.front();
+        }
+        thread_local std::minstd_rand random{std::random_device{}()};
+        std::uniform_int_distribution<std::size_t> distribution(0, nodes.size() - 1);
+        const auto first = distribution(random);
+        auto second = distribution(random);
+        if (second == first) {
+            second = (first + 1) % nodes.size();
+        }
+        auto& a = *nodes[first];
+        auto& b = *nodes[second];
+        return b.load.cost() < a.load.cost() ? b : a;
+    }
+};
+
+template <typename Handler, typename State>
+struct balanced_connection_handler {
+    Handler handler_;
+    std::shared_ptr<State> state_;
+    balanced_source_load* load_;
+    time_traits::time_point started_at_;
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection&& conn) {
+        const auto latency = time_traits::now() - started_at_;
+        if (ec) {
+            load_->end(std::max(latency, state_->config.error_penalty), state_->config.smoothing);
+            return handler_(std::move(ec), std::forward<Connection>(conn));
+        }
+        // The latency includes the whole operation the connection is used for
+        // if the connection type allows to observe its release.
+        handler_(std::move(ec), ozo::detail::on_release(std::forward<Connection>(conn),
+            [state = std::move(state_), load = load_, started_at = started_at_] (const auto&) {
+                load->end(time_traits::now() - started_at, state->config.smoothing);
+            }));
+    }
+
+    using executor_type = decltype(asio::get_associated_executor(handler_));
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = decltype(asio::get_associated_allocator(handler_));
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Load-balanced connection source
+ *
+ * `ConnectionSource` which dispatches requests for a connection between several sources
+ * of the same type using the power of two choices over the sources load. The load is estimated
+ * via moving average of the latency and number of requests in progress.
+ *
+ * If the source provides connections as `std::shared_ptr` (like `ozo::connection_info` and
+ * `ozo::connection_pool` do) the latency is measured from the connection request until the
+ * connection release, so it includes the latency of the whole operation. Otherwise only the
+ * latency of the connection request is accounted. A failed connection request is accounted
+ * with latency not less than `balanced_connection_source_config::error_penalty`.
+ *
+ * Copies of the object share sources and their statistics.
+ *
+ * @tparam Source --- `ConnectionSource` implementation.
+ * @ingroup group-failover-balanced
+ * @models{ConnectionSource}
+ */
+template <typename Source>
+class balanced_connection_source {
+    static_assert(ozo::ConnectionSource<Source>, "Source should model a ConnectionSource concept");
+
+    using state_type = detail::balanced_source_state<Source>;
+    std::shared_ptr<state_type> state_;
+
+public:
+    /**
+     * `Connection` implementation type according to `ConnectionSource` requirements.
+     * Specifies the `Connection` implementation type which can be obtained from this source.
+     */
+    using connection_type = typename connection_source_traits<Source>::connection_type;
+
+    /**
+     * Construct a new `balanced_connection_source` object.
+     *
+     * @param sources --- sources to balance between, should not be empty.
+     * @param config --- balancing configuration.
+     */
+    explicit balanced_connection_source(std::vector<Source> sources, balanced_connection_source_config config = {})
+    : state_(std::make_shared<state_type>()) {
+        if (sources.empty()) {
+            throw std::invalid_argument("balanced_connection_source: sources should not be empty");
+        }
+        state_->config = config;
+        state_->nodes.reserve(sources.size());
+        for (auto& source : sources) {
+            state_->nodes.push_back(std::make_unique<typename state_type::node>(std::move(source)));
+        }
+    }
+
+    /**
+     * Number of sources balanced between.
+     */
+    std::size_t size() const noexcept { return state_->nodes.size(); }
+
+    /**
+     * Latency estimation of the source.
+     *
+     * @param n --- index of the source in order of construction.
+     */
+    time_traits::duration latency(std::size_t n) const { return state_->nodes.at(n)->load.latency(); }
+
+    /**
+     * Number of requests in progress for the source.
+     *
+     * @param n --- index of the source in order of construction.
+     */
+    std::size_t in_flight(std::size_t n) const { return state_->nodes.at(n)->load.in_flight(); }
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (io_context& io, TimeConstraint t, Handler&& handler) const {
+        static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+        auto& node = state_->pick();
+        node.load.begin();
+        node.source(io, std::move(t), detail::balanced_connection_handler<std::decay_t<Handler>, state_type>{
+            std::forward<Handler>(handler), state_, std::addressof(node.load), time_traits::now()});
+    }
+
+    auto operator [](io_context& io) const {
+        return connection_provider(*this, io);
+    }
+};
+
+/**
+ * Creates connection source which balances requests between given connection sources.
+ *
+ * @param source --- the first source.
+ * @param sources --- other sources of the same type.
+ * @return `ozo::failover::balanced_connection_source` specialization.
+ *
+ * @sa `ozo::failover::balanced_connection_source`
+ * @ingroup group-failover-balanced
+ */
+template <typename Source, typename ...Sources>
+inline auto make_balanced_connection_source(Source source, Sources ...sources) {
+    static_assert((std::is_same_v<Source, Sources> && ...), "all the sources should be of the same type");
+    std::vector<Source> v;
+    v.reserve(1 + sizeof...(sources));
+    v.push_back(std::move(source));
+    (v.push_back(std::move(sources)), ...);
+    return balanced_connection_source<Source>(std::move(v));
+}
+
+} // namespace ozo::failover
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <ozo/failover/strategy.h>
+#include <ozo/connection.h>
+#include <ozo/error.h>
+#include <ozo/detail/bind.h>
+#include <ozo/detail/on_release.h>
+
+#include <boost/asio/post.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @defgroup group-failover-circuit_breaker Circuit Breaker
+ * @ingroup group-failover
+ * @brief Skip known-bad hosts without connection attempts
+ *
+ * If a host is down every request still pays for a connection attempt and its timeout before
+ * a failover strategy moves on. `ozo::failover::circuit_breaker_source` wraps a `ConnectionSource`
+ * of a host and tracks results of its connections. If too many of them fail or are too slow
+ * the circuit opens, and the source fails requests immediately with `ozo::error::circuit_open`
+ * without touching the host. After a timeout the circuit becomes half-open and lets a limited
+ * number of probe requests through: a successful probe closes the circuit, a failed one opens
+ * it again.
+ *
+ * `ozo::error::circuit_open` belongs to `ozo::errc::connection_error` condition, so
+ * `ozo::failover::retry_strategy` and the roles of `ozo::failover::role_based_strategy` treat
+ * it as a connection error. Besides the role-based strategy skips a fallback role with an open
+ * circuit, see `ozo::failover::is_available()`.
+ *
+ * @code
+auto conn_source = ozo::failover::make_role_based_connection_source(
+    ozo::failover::master=ozo::failover::circuit_breaker_source(ozo::connection_info(cfg.master_connstr)),
+    ozo::failover::replica=ozo::failover::circuit_breaker_source(ozo::connection_info(cfg.replica_connstr))
+);
+
+auto fallback = ozo::failover::role_based(ozo::failover::master, ozo::failover::replica);
+ozo::request[fallback](conn_source[io], query, .5s, out, yield);
+ * @endcode
+ */
+
+namespace ozo::failover {
+
+/**
+ * @brief State of a circuit breaker
+ * @ingroup group-failover-circuit_breaker
+ */
+enum class circuit_state {
+    closed, //!< requests go to the host, results are tracked
+    open, //!< requests fail immediately
+    half_open, //!< a limited number of probe requests go to the host
+};
+
+/**
+ * @brief Configuration of the `ozo::failover::circuit_breaker`
+ * @ingroup group-failover-circuit_breaker
+ */
+struct circuit_breaker_config {
+    std::size_t window = 20; //!< number of the latest request results to calculate failure rate from
+    std::size_t min_requests = 10; //!< minimum number of results in the window to open the circuit
+    double failure_rate = 0.5; //!< failure rate to open the circuit, a value in range (0, 1]
+    time_traits::duration slow_request = time_traits::duration::max(); //!< a request which uses a connection longer is counted as failed
+    time_traits::duration open_timeout = std::chrono::seconds(5); //!< time to keep the circuit open before probing the host
+    std::size_t half_open_probes = 1; //!< maximum number of probe requests in progress in the half-open state
+};
+
+/**
+ * @brief Circuit breaker state machine
+ *
+ * Thread-safe state machine of a circuit breaker. A request should obtain a permit
+ * via `try_acquire()` and report its result via `release()`.
+ *
+ * @ingroup group-failover-circuit_breaker
+ */
+class circuit_breaker {
+public:
+    /**
+     * Request permit.
+     */
+    struct permit {
+        bool granted = false; //!< request may go to the host
+        bool probe = false; //!< request is a probe of the half-open state
+    };
+
+    /**
+     * Result of a request.
+     */
+    enum class result {
+        success, //!< host has served the request
+        failure, //!< host has failed the request or served it too slow
+        ignored, //!< the request says nothing about the host, e.g. it has been rejected by a local queue
+    };
+
+    explicit circuit_breaker(circuit_breaker_config config = {})
+    : config_(config), results_(std::max<std::size_t>(config.window, 1)) {}
+
+    const circuit_breaker_config& config() const noexcept { return config_; }
+
+    /**
+     * Get a permit for a request.
+     *
+     * @param now --- current time.
+     * @return permit --- permit with `granted` flag set if the request may go to the host.
+     */
+    permit try_acquire(time_traits::time_point now = time_traits::now()) {
+        std::lock_guard lock(mutex_);
+        update(now);
+        switch (state_) {
+            case circuit_state::closed:
+                return {true, false};
+            case circuit_state::half_open:
+                if (probes_ < config_.half_open_probes) {
+                    ++probes_;
+                    return {true, true};
+                }
+                return {};
+            case circuit_state::open:
+                return {};
+        }
+        return {};
+    }
+
+    /**
+     * Report result of a request which has got a permit.
+     *
+     * @param p --- permit of the request.
+     * @param r --- result of the request.
+     * @param now --- current time.
+     */
+    void release(permit p, result r, time_traits::time_point now = time_traits::now()) {
+        if (!p.granted) {
+            return;
+        }
+        std::lock_guard lock(mutex_);
+        if (p.probe) {
+            --probes_;
+            if (state_ != circuit_state::half_open || r == result::ignored) {
+                return;
+            }
+            if (r == result::success) {
+                close();
+            } else {
+                open(now);
+            }
+            return;
+        }
+        if (state_ != circuit_state::closed || r == result::ignored) {
+            return;
+        }
+        add(r == result::failure);
+        if (count_ >= std::max<std::size_t>(config_.min_requests, 1)
+                && static_cast<double>(failures_) >= config_.failure_rate * static_cast<double>(count_)) {
+            open(now);
+        }
+    }
+
+    /**
+     * Current state of the circuit.
+     *
+     * @param now --- current time.
+     */
+    circuit_state state(time_traits::time_point now = time_traits::now()) const {
+        std::lock_guard lock(mutex_);
+        if (state_ == circuit_state::open && now - opened_at_ >= config_.open_timeout) {
+            return circuit_state::half_open;
+        }
+        return state_;
+    }
+
+    /**
+     * Indicates if a request would get a permit now.
+     *
+     * @param now --- current time.
+     */
+    bool is_available(time_traits::time_point now = time_traits::now()) const {
+        std::lock_guard lock(mutex_);
+        switch (state_) {
+            case circuit_state::closed:
+                return true;
+            case circuit_state::half_open:
+                return probes_ < config_.half_open_probes;
+            case circuit_state::open:
+                return now - opened_at_ >= config_.open_timeout;
+        }
+        return false;
+    }
+
+private:
+    void update(time_traits::time_point now) {
+        if (state_ == circuit_state::open && now - opened_at_ >= config_.open_timeout) {
+            state_ = circuit_state::half_open;
+        }
+    }
+
+    void open(time_traits::time_point now) {
+        state_ = circuit_state::open;
+        opened_at_ = now;
+    }
+
+    void close() {
+        state_ = circuit_state::closed;
+        count_ = failures_ = next_ = 0;
+    }
+
+    void add(bool failure) {
+        if (count_ == results_.size()) {
+            failures_ -= results_[next_];
+        } else {
+            ++count_;
+        }
+        results_[next_] = failure;
+        failures_ += failure;
+        next_ = (next_ + 1) % results_.size();
+    }
+
+    mutable std::mutex mutex_;
+    circuit_breaker_config config_;
+    circuit_state state_ = circuit_state::closed;
+    time_traits::time_point opened_at_;
+    std::size_t probes_ = 0;
+    std::vector<std::size_t> results_;
+    std::size_t count_ = 0;
+    std::size_t failures_ = 0;
+    std::size_t next_ = 0;
+};
+
+namespace detail {
+
+template <typename Handler>
+struct circuit_breaker_handler {
+    Handler handler_;
+    std::shared_ptr<circuit_breaker> breaker_;
+    circuit_breaker::permit permit_;
+    time_traits::time_point started_at_;
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection&& conn) {
+        using result = circuit_breaker::result;
+        if (ec) {
+            breaker_->release(permit_, ec == errc::connection_error ? result::failure : result::ignored);
+            return handler_(std::move(ec), std::forward<Connection>(conn));
+        }
+        handler_(std::move(ec), ozo::detail::on_release(std::forward<Connection>(conn),
+            [breaker = std::move(breaker_), permit = permit_, started_at = started_at_] (const auto& conn) {
+                const auto now = time_traits::now();
+                const bool failed = ozo::connection_bad(conn) || now - started_at > breaker->config().slow_request;
+                breaker->release(permit, failed ? result::failure : result::success, now);
+            }));
+    }
+
+    using executor_type = decltype(asio::get_associated_executor(handler_));
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = decltype(asio::get_associated_allocator(handler_));
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Connection source guarded by a circuit breaker
+ *
+ * `ConnectionSource` wrapper which consults `ozo::failover::circuit_breaker` before
+ * each connection request. If the circuit is open the request fails immediately with
+ * `ozo::error::circuit_open`.
+ *
+ * A request is counted as failed if the connection request fails with an error of
+ * `ozo::errc::connection_error` condition, if the connection is bad on release, or if
+ * the connection has been used longer than `circuit_breaker_config::slow_request`.
+ * Connection release is observed for `std::shared_ptr` connections (like `ozo::connection_info`
+ * and `ozo::connection_pool` provide), for other types only the connection request is accounted.
+ *
+ * Copies of the object share the circuit breaker.
+ *
+ * @tparam Source --- `ConnectionSource` implementation.
+ * @ingroup group-failover-circuit_breaker
+ * @models{ConnectionSource}
+ */
+template <typename Source>
+class circuit_breaker_source {
+    static_assert(ozo::ConnectionSource<Source>, "Source should model a ConnectionSource concept");
+
+    Source source_;
+    std::shared_ptr<circuit_breaker> breaker_;
+
+public:
+    /**
+     * `Connection` implementation type according to `ConnectionSource` requirements.
+     * Specifies the `Connection` implementation type which can be obtained from this source.
+     */
+    using connection_type = typename connection_source_traits<std::decay_t<Source>>::connection_type;
+
+    /**
+     * Construct a new `circuit_breaker_source` object.
+     *
+     * @param source --- `ConnectionSource` of a host.
+     * @param config --- circuit breaker configuration.
+     */
+    template <typename T>
+    explicit circuit_breaker_source(T&& source, circuit_breaker_config config = {})
+    : source_(std::forward<T>(source)), breaker_(std::make_shared<circuit_breaker>(config)) {}
+
+    /**
+     * Construct a new `circuit_breaker_source` object with a shared circuit breaker.
+     *
+     * @param source --- `ConnectionSource` of a host.
+     * @param breaker --- circuit breaker of the host, should not be null.
+     */
+    template <typename T>
+    circuit_breaker_source(T&& source, std::shared_ptr<circuit_breaker> breaker)
+    : source_(std::forward<T>(source)), breaker_(std::move(breaker)) {}
+
+    /**
+     * Circuit breaker of the source.
+     */
+    const std::shared_ptr<circuit_breaker>& breaker() const noexcept { return breaker_; }
+
+    /**
+     * Indicates if the circuit allows a request, see `ozo::failover::is_available()`.
+     */
+    bool is_available() const { return breaker_->is_available(); }
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (io_context& io, TimeConstraint t, Handler&& handler) const {
+        static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+        const auto permit = breaker_->try_acquire();
+        if (!permit.granted) {
+            return asio::post(io.get_executor(), ozo::detail::bind(std::forward<Handler>(handler),
+                error_code{error::circuit_open}, connection_type{}));
+        }
+        ozo::unwrap(source_)(io, std::move(t), detail::circuit_breaker_handler<std::decay_t<Handler>>{
+            std::forward<Handler>(handler), breaker_, permit, time_traits::now()});
+    }
+
+    auto operator [](io_context& io) const {
+        return connection_provider(*this, io);
+    }
+};
+
+template <typename T>
+circuit_breaker_source(T&& source, circuit_breaker_config config = {}) -> circuit_breaker_source<std::decay_t<T>>;
+
+template <typename T>
+circuit_breaker_source(T&& source, std::shared_ptr<circuit_breaker>) -> circuit_breaker_source<std::decay_t<T>>;
+
+} // namespace ozo::failover
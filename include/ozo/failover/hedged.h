@@ -0,0 +1,596 @@
+#pragma once
+
+#include <ozo/failover/strategy.h>
+#include <ozo/core/options.h>
+#include <ozo/cancel.h>
+
+#include <boost/hana/tuple.hpp>
+#include <boost/hana/unpack.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @defgroup group-failover-hedged Hedged Requests
+ * @ingroup group-failover
+ * @brief Failover operation by hedged requests
+ *
+ * Retry and role-based strategies start the next try only after the previous one has
+ * failed, so a single slow host makes an operation wait for the whole try time constraint.
+ * The hedged strategy starts the second try of an operation (a hedge) if the first one
+ * has not completed within a delay. The delay may be a fixed duration or an observed
+ * latency percentile. The first successful try completes the operation, the other one
+ * is canceled via `ozo::cancel()`.
+ *
+ * The hedge uses the same `ConnectionProvider` as the first try, so a connection source
+ * which spreads connections over several hosts gives the hedge another host. The hedge
+ * may be bound to an other role of `ozo::failover::role_based_connection_provider`
+ * via `ozo::failover::hedged_strategy::to()`.
+ */
+
+namespace ozo::failover {
+
+/**
+ * @brief Options for hedged requests
+ *
+ * These options can be used with `ozo::failover::hedged_strategy`.
+ * @ingroup group-failover-hedged
+ */
+struct hedged_options {
+    class delay_tag;
+    class role_tag;
+    class on_hedge_tag;
+    class close_connection_tag;
+    class cancel_tag;
+
+    constexpr static option<delay_tag> delay{}; //!< Set delay of the hedge, `time_traits::duration` or `std::shared_ptr<ozo::failover::latency_percentile>`.
+    constexpr static option<role_tag> role{}; //!< Set role to bind the hedge's `ConnectionProvider` to, see `ozo::failover::role_based_connection_provider::rebind_role()`.
+    constexpr static option<on_hedge_tag> on_hedge{}; //!< Set handler for hedge event with signature `void()`, may be useful for logging.
+    constexpr static option<close_connection_tag> close_connection{}; //!< Set close connection policy for a failed or a lost try, possible values `true`(default), `false`.
+    constexpr static option<cancel_tag> cancel{}; //!< Set handler to cancel a lost try with signature `void(const Connection&)`, default one uses `ozo::cancel()` limited by the operation time constraint.
+};
+
+/**
+ * @brief Latency percentile tracker for hedge delay
+ *
+ * Keeps a sliding window of latencies of operation tries and provides the specified percentile
+ * of them. A hedged operation samples each successful try and the first try even if it fails
+ * or loses, so slow first tries are not left out. Until the window has got enough samples
+ * the initial value is provided.
+ * The object is thread-safe and is intended to be shared between operations via
+ * `std::shared_ptr`.
+ *
+ * ### Example
+ *
+ * Send a hedge if a request takes more time than 95% of previous requests.
+ *
+ * @code
+auto p95 = std::make_shared<ozo::failover::latency_percentile>(0.95, 50ms);
+
+ozo::request[ozo::failover::hedge(p95)](pool[io], query, .5s, out, yield);
+ * @endcode
+ * @ingroup group-failover-hedged
+ */
+class latency_percentile {
+public:
+    /**
+     * Construct a new latency percentile object.
+     *
+     * @param percentile --- percentile to provide, a value in range (0, 1].
+     * @param initial --- value to provide until the window has got enough samples.
+     * @param window --- number of the latest samples to calculate percentile from.
+     */
+    latency_percentile(double percentile, time_traits::duration initial, std::size_t window = 1024)
+    : percentile_(std::clamp(percentile, 0.0, 1.0)), value_(initial),
+      refresh_(std::max<std::size_t>(window / 16, 1)) {
+        samples_.reserve(std::max<std::size_t>(window, 1));
+    }
+
+    /**
+     * Add latency sample.
+     *
+     * @param sample --- observed latency of an operation try.
+     */
+    void update(time_traits::duration sample) {
+        std::lock_guard lock(mutex_);
+        if (samples_.size() < samples_.capacity()) {
+            samples_.push_back(sample);
+        } else {
+            samples_[next_] = sample;
+            next_ = (next_ + 1) % samples_.size();
+        }
+        if (++updates_ >= refresh_ && samples_.size() >= min_samples()) {
+            updates_ = 0;
+            recalculate();
+        }
+    }
+
+    /**
+     * Current percentile value.
+     *
+     * @return time_traits::duration --- percentile of the latest samples or initial value.
+     */
+    time_traits::duration get() const {
+        std::lock_guard lock(mutex_);
+        return value_;
+    }
+
+private:
+    std::size_t min_samples() const {
+        return std::min<std::size_t>(samples_.capacity(), 16);
+    }
+
+    void recalculate() {
+        sorted_.assign(samples_.begin(), samples_.end());
+        const auto n = static_cast<std::size_t>(percentile_ * static_cast<double>(sorted_.size() - 1));
+        std::nth_element(sorted_.begin(), sorted_.begin() + n, sorted_.end());
+        value_ = sorted_[n];
+    }
+
+    mutable std::mutex mutex_;
+    double percentile_;
+    time_traits::duration value_;
+    std::size_t refresh_;
+    std::size_t updates_ = 0;
+    std::size_t next_ = 0;
+    std::vector<time_traits::duration> samples_;
+    std::vector<time_traits::duration> sorted_;
+};
+
+namespace detail {
+
+inline time_traits::duration get_hedge_delay(time_traits::duration delay) { return delay; }
+
+inline time_traits::duration get_hedge_delay(const std::shared_ptr<latency_percentile>& p) {
+    return p ? p->get() : time_traits::duration::max();
+}
+
+inline void update_hedge_latency(time_traits::duration, time_traits::duration) {}
+
+inline void update_hedge_latency(const std::shared_ptr<latency_percentile>& p, time_traits::duration latency) {
+    if (p) {
+        p->update(latency);
+    }
+}
+
+template <typename TimeConstraint>
+inline bool hedge_fits(TimeConstraint t, time_traits::duration delay) {
+    if constexpr (t == none) {
+        return delay != time_traits::duration::max();
+    } else {
+        return delay < time_left(t);
+    }
+}
+
+/**
+ * Default cancel of a lost try. Waiting for the cancel operation is limited by the rest
+ * of the operation time constraint and performed on the `io_context` of the connection,
+ * so a cancel request to an unreachable host does not outlive the operation.
+ */
+template <typename TimeConstraint>
+struct cancel_try {
+    TimeConstraint time_constraint;
+
+    template <typename Connection, typename Handler>
+    void operator() (const Connection& conn, Handler&& handler) const {
+        if constexpr (std::is_same_v<TimeConstraint, none_t>) {
+            ozo::cancel(get_cancel_handle(conn), std::forward<Handler>(handler));
+        } else {
+            ozo::cancel(get_cancel_handle(conn), ozo::get_executor(conn).context(),
+                time_constraint, std::forward<Handler>(handler));
+        }
+    }
+
+    template <typename Connection>
+    void operator() (const Connection& conn) const {
+        (*this)(conn, [](error_code, std::string){});
+    }
+};
+
+/**
+ * Number of tries of a hedged operation: the first one and the hedge.
+ */
+constexpr std::size_t hedged_tries = 2;
+
+/**
+ * Part of a hedged operation state which is independent on the completion handler.
+ * It tracks connections of tries in progress to cancel the lost one.
+ */
+template <typename Connection>
+struct hedged_race {
+    std::mutex mutex_;
+    bool done_ = false;
+    std::array<std::optional<Connection>, hedged_tries> conns_;
+
+    /**
+     * Remember the connection of the try to cancel it if the try is lost.
+     *
+     * @return true --- if the race is not over yet.
+     * @return false --- if the try has already lost.
+     */
+    bool track(std::size_t n, const Connection& conn) {
+        std::lock_guard lock(mutex_);
+        if (!done_) {
+            conns_[n].emplace(conn);
+        }
+        return !done_;
+    }
+};
+
+template <typename Handler, typename Race>
+struct hedged_connection_handler {
+    Handler handler_;
+    std::shared_ptr<Race> race_;
+    std::size_t n_;
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection&& conn) {
+        if (!ec && !race_->track(n_, conn)) {
+            ec = asio::error::operation_aborted;
+        }
+        race_.reset();
+        handler_(std::move(ec), std::forward<Connection>(conn));
+    }
+
+    using executor_type = decltype(asio::get_associated_executor(handler_));
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = decltype(asio::get_associated_allocator(handler_));
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+/**
+ * `ConnectionProvider` of a single hedged try. It tells the race about a connection
+ * obtained for the try and fails the try if the race is already over.
+ */
+template <typename Provider, typename Race>
+struct hedged_connection_provider {
+    Provider provider_;
+    std::shared_ptr<Race> race_;
+    std::size_t n_;
+
+    using connection_type = ozo::connection_type<Provider>;
+
+    template <typename TimeConstraint, typename Handler>
+    void async_get_connection(TimeConstraint t, Handler&& h) const {
+        ozo::async_get_connection(provider_, t,
+            hedged_connection_handler<std::decay_t<Handler>, Race>{std::forward<Handler>(h), race_, n_});
+    }
+};
+
+template <typename Options, typename Provider>
+inline auto get_hedge_provider(const Options& options, const Provider& provider) {
+    if constexpr (decltype(hana::contains(options, hedged_options::role))::value) {
+        return ozo::unwrap(provider).rebind_role(options[hedged_options::role]);
+    } else {
+        return provider;
+    }
+}
+
+template <typename Handler, typename Options, typename Operation, typename Context>
+class hedged_operation;
+
+template <typename Handler, typename Options, typename Operation, typename Provider, typename TimeConstraint, typename ...Args>
+class hedged_operation<Handler, Options, Operation, basic_context<Provider, TimeConstraint, Args...>>
+        : public hedged_race<ozo::connection_type<Provider>>,
+          public std::enable_shared_from_this<hedged_operation<Handler, Options, Operation, basic_context<Provider, TimeConstraint, Args...>>> {
+    using opt = hedged_options;
+    using connection_type = ozo::connection_type<Provider>;
+    using race_type = hedged_race<connection_type>;
+    using context_type = basic_context<Provider, TimeConstraint, Args...>;
+    using hedge_provider_type = decltype(get_hedge_provider(std::declval<const Options&>(), std::declval<const Provider&>()));
+
+    static_assert(std::is_same_v<connection_type, ozo::connection_type<hedge_provider_type>>,
+        "hedge should provide the same connection type as the first try");
+
+    struct try_handler {
+        std::shared_ptr<hedged_operation> self_;
+        std::size_t n_;
+
+        template <typename Connection>
+        void operator() (error_code ec, Connection&& conn) {
+            auto self = std::move(self_);
+            self->complete(n_, std::move(ec), std::forward<Connection>(conn));
+        }
+
+        using executor_type = asio::associated_executor_t<Handler>;
+
+        executor_type get_executor() const noexcept { return self_->executor_; }
+
+        using allocator_type = asio::associated_allocator_t<Handler>;
+
+        allocator_type get_allocator() const noexcept { return self_->allocator_; }
+    };
+
+public:
+    hedged_operation(Handler handler, Options options, const Operation& op, context_type ctx)
+    : options_(std::move(options)), op_(op), ctx_(std::move(ctx)),
+      hedge_provider_(get_hedge_provider(options_, ctx_.provider)),
+      executor_(asio::get_associated_executor(handler)),
+      allocator_(asio::get_associated_allocator(handler)),
+      timer_(executor_),
+      handler_(std::move(handler)) {}
+
+    void start() {
+        const auto delay = get_hedge_delay(get_option(options_, opt::delay));
+        if (hedge_fits(ctx_.time_constraint, delay)) {
+            timer_.expires_after(delay);
+            timer_.async_wait([self = this->weak_from_this()] (error_code ec) {
+                if (auto locked = self.lock(); locked && !ec) {
+                    locked->hedge();
+                }
+            });
+        }
+        start_try(0, ctx_.provider);
+    }
+
+private:
+    template <typename P>
+    void start_try(std::size_t n, const P& provider) {
+        started_at_[n] = time_traits::now();
+        hana::unpack(ctx_.args, [&](const auto& ...args) {
+            ozo::get_operation_initiator(op_)(
+                try_handler{this->shared_from_this(), n},
+                hedged_connection_provider<P, race_type>{provider, this->shared_from_this(), n},
+                ctx_.time_constraint, args...
+            );
+        });
+    }
+
+    bool begin_hedge() {
+        std::lock_guard lock(this->mutex_);
+        if (this->done_ || hedged_) {
+            return false;
+        }
+        hedged_ = true;
+        ++pending_;
+        return true;
+    }
+
+    void hedge() {
+        if (begin_hedge()) {
+            get_option(options_, opt::on_hedge, [](auto&&...){})();
+            start_try(1, hedge_provider_);
+        }
+    }
+
+    void stop_timer() {
+        asio::dispatch(timer_.get_executor(), [self = this->shared_from_this()] {
+            self->timer_.cancel();
+        });
+    }
+
+    template <typename Connection>
+    void discard(const error_code& ec, Connection& conn) {
+        auto guard = defer_close_connection(
+            ec && get_option(options_, opt::close_connection, true) ? std::addressof(conn) : nullptr);
+    }
+
+    template <typename Connection>
+    void complete(std::size_t n, error_code ec, Connection&& conn) {
+        // A failed or lost first try took at least the elapsed time, so it is sampled too
+        // to not let the percentile drift below the real latency of a first try.
+        if (!ec || n == 0) {
+            update_hedge_latency(get_option(options_, opt::delay), time_traits::now() - started_at_[n]);
+        }
+
+        std::unique_lock lock(this->mutex_);
+        this->conns_[n].reset();
+
+        if (this->done_) {
+            lock.unlock();
+            return discard(ec, conn);
+        }
+
+        --pending_;
+
+        if (!ec) {
+            this->done_ = true;
+            auto losers = std::move(this->conns_);
+            lock.unlock();
+
+            stop_timer();
+            for (auto& loser : losers) {
+                if (loser) {
+                    get_option(options_, opt::cancel, cancel_try<TimeConstraint>{ctx_.time_constraint})(std::as_const(*loser));
+                }
+            }
+            return finish(std::move(ec), std::forward<Connection>(conn));
+        }
+
+        if (pending_ > 0) {
+            lock.unlock();
+            return discard(ec, conn);
+        }
+
+        if (!hedged_ && !expired(ctx_.time_constraint)) {
+            lock.unlock();
+            stop_timer();
+            discard(ec, conn);
+            return hedge();
+        }
+
+        this->done_ = true;
+        lock.unlock();
+        stop_timer();
+        finish(std::move(ec), std::forward<Connection>(conn));
+    }
+
+    template <typename Connection>
+    void finish(error_code ec, Connection&& conn) {
+        auto handler = std::move(*handler_);
+        handler_.reset();
+        handler(std::move(ec), std::forward<Connection>(conn));
+    }
+
+    static constexpr bool expired(none_t) { return false; }
+    static bool expired(time_traits::time_point t) { return ozo::expired(t); }
+
+    Options options_;
+    Operation op_;
+    context_type ctx_;
+    hedge_provider_type hedge_provider_;
+    asio::associated_executor_t<Handler> executor_;
+    asio::associated_allocator_t<Handler> allocator_;
+    asio::steady_timer timer_;
+    std::optional<Handler> handler_;
+    std::array<time_traits::time_point, hedged_tries> started_at_;
+    std::size_t pending_ = 1;
+    bool hedged_ = false;
+};
+
+template <typename Options, typename Operation>
+struct hedged_operation_initiator {
+    Options options_;
+    Operation op_;
+
+    constexpr hedged_operation_initiator(Options options, const Operation& op)
+    : options_(std::move(options)), op_(op) {}
+
+    template <typename Handler, typename Provider, typename TimeConstraint, typename ...Args>
+    void operator() (Handler&& handler, Provider&& provider, TimeConstraint t, Args&& ...args) const {
+        static_assert(!ozo::Connection<Provider>, "hedged operation needs a ConnectionProvider which is not a Connection");
+
+        using context_type = basic_context<Provider, decltype(ozo::deadline(t)), Args...>;
+        using operation_type = hedged_operation<std::decay_t<Handler>, Options, Operation, context_type>;
+
+        const auto alloc = asio::get_associated_allocator(handler);
+        auto op = std::allocate_shared<operation_type>(alloc,
+            std::forward<Handler>(handler), options_, op_,
+            context_type{std::forward<Provider>(provider), ozo::deadline(t), std::forward<Args>(args)...});
+        op->start();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Hedged requests strategy
+ *
+ * The strategy starts an operation and, if it has not completed within a delay, starts
+ * the second try of the operation. The first successful try completes the operation,
+ * the other one is canceled via `ozo::cancel()` and its connection is closed. If a try
+ * fails the operation waits for the other one; if the hedge has not been started yet it
+ * is started immediately. The operation completes with an error only if both tries fail.
+ *
+ * Both tries share the operation time constraint. The hedge is not started if the delay
+ * exceeds the time left.
+ *
+ * The hedge delay timer runs on the executor associated with the operation completion handler.
+ *
+ * This class is an options' factory (see `ozo::options_factory_base`).
+ *
+ * @ingroup group-failover-hedged
+ */
+template <typename Options = decltype(hana::make_map())>
+class hedged_strategy : public ozo::options_factory_base<hedged_strategy<Options>, Options> {
+    using opt = hedged_options;
+
+    friend class ozo::options_factory_base<hedged_strategy<Options>, Options>;
+    using base = ozo::options_factory_base<hedged_strategy<Options>, Options>;
+
+    template <typename OtherOptions>
+    constexpr static auto rebind_options(OtherOptions&& options) {
+        return hedged_strategy<std::decay_t<OtherOptions>>(std::forward<OtherOptions>(options));
+    }
+
+public:
+    /**
+     * @brief Construct a new hedged strategy object
+     *
+     * @param options --- `boost::hana::map` of `ozo::failover::hedged_options` and values.
+     */
+    constexpr hedged_strategy(Options options = Options{}) : base(std::move(options)) {
+        static_assert(decltype(hana::is_a<hana::map_tag>(options))::value, "Options should be boost::hana::map");
+    }
+
+    /**
+     * @brief Bind the hedge to a role
+     *
+     * The hedge gets connection from the operation `ConnectionProvider` rebound to the role,
+     * so the provider should support `rebind_role()`, e.g. `ozo::failover::role_based_connection_provider`.
+     *
+     * @param role --- role for the hedge.
+     * @return `hedged_strategy` specialization object
+     *
+     * ###Example
+     *
+     * Send the request to a replica host if the master does not respond in 20 milliseconds.
+     *
+     * @code
+auto conn_info = ozo::failover::make_role_based_connection_source(
+    ozo::failover::master=ozo::connection_info(cfg.master_connstr),
+    ozo::failover::replica=ozo::connection_info(cfg.replica_connstr)
+);
+
+ozo::request[ozo::failover::hedge(20ms).to(ozo::failover::replica)](conn_info[io], query, .5s, out, yield);
+     * @endcode
+     */
+    template <typename Role>
+    constexpr decltype(auto) to(Role role) const & { return this->set(opt::role, role);}
+    template <typename Role>
+    constexpr decltype(auto) to(Role role) && { return std::move(*this).set(opt::role, role);}
+
+    /**
+     * @brief Hedge delay of the strategy
+     *
+     * @return delay value setted for this strategy.
+     */
+    constexpr decltype(auto) get_delay() const { return this->get(opt::delay); }
+
+    template <typename Operation>
+    auto make_initiator(const Operation& op) const {
+        static_assert(decltype(this->has(opt::delay))::value, "hedge delay should be specified");
+        return detail::hedged_operation_initiator{this->options(), op};
+    }
+};
+
+/**
+ * Start the second try of an operation if the first one has not completed within the delay.
+ *
+ * @param delay --- `time_traits::duration` or `std::shared_ptr<ozo::failover::latency_percentile>`
+ *                  to take the delay from.
+ * @return `ozo::failover::hedged_strategy` specialization.
+ *
+ * ###Example
+ *
+ * Send the request to an other host of the pool if the first one does not respond in 20 milliseconds.
+ *
+ * @code
+ozo::request[ozo::failover::hedge(20ms)](pool[io], query, .5s, out, yield);
+ * @endcode
+ *
+ * @sa `ozo::failover::hedged_strategy`, `ozo::failover::latency_percentile`
+ * @ingroup group-failover-hedged
+ */
+template <typename Rep, typename Period>
+inline auto hedge(std::chrono::duration<Rep, Period> delay) {
+    return hedged_strategy{}.set(hedged_options::delay = std::chrono::duration_cast<time_traits::duration>(delay));
+}
+
+inline auto hedge(std::shared_ptr<latency_percentile> delay) {
+    return hedged_strategy{}.set(hedged_options::delay = std::move(delay));
+}
+
+} // namespace ozo::failover
+
+namespace ozo {
+
+template <typename ...Ts, typename Op>
+struct construct_initiator_impl<failover::hedged_strategy<Ts...>, Op> {
+    static auto apply(const failover::hedged_strategy<Ts...>& strategy, const Op& op) {
+        return strategy.make_initiator(op);
+    }
+};
+
+} // namespace ozo
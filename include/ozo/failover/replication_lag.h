@@ -0,0 +1,423 @@
+#pragma once
+
+#include <ozo/connection.h>
+#include <ozo/connector.h>
+#include <ozo/request.h>
+#include <ozo/shortcuts.h>
+#include <ozo/pg/types/integer.h>
+#include <ozo/pg/types/interval.h>
+#include <ozo/ext/std/optional.h>
+
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @defgroup group-failover-replication_lag Replication Lag Aware Routing
+ * @ingroup group-failover
+ * @brief Route reads to replicas which have replayed enough of the write-ahead log
+ *
+ * Read-your-writes consistency needs a replica which has replayed the changes made by a
+ * transaction on the master. `ozo::failover::lag_aware_connection_source` tracks replay position
+ * (LSN) and lag of each replica by periodic polling and routes a request to a replica
+ * which satisfies the `ozo::failover::read_consistency` requirement of the request. If there
+ * is no such replica the request goes to the master.
+ *
+ * LSN values are represented as `std::int64_t` offsets, e.g. the LSN of a committed write
+ * can be obtained from the master via
+ * `SELECT (pg_current_wal_lsn() - '0/0'::pg_lsn)::bigint`.
+ *
+ * @code
+auto source = ozo::failover::lag_aware_connection_source(
+    ozo::connection_info(cfg.master_connstr),
+    {ozo::connection_info(cfg.replica1_connstr), ozo::connection_info(cfg.replica2_connstr)}
+);
+source.start_monitoring(io, 100ms);
+
+// After a write with LSN `lsn` read own changes
+ozo::request(source.min_lsn(lsn)[io], query, .5s, out, yield);
+
+// Read data not older than 1 second
+ozo::request(source.max_staleness(1s)[io], query, .5s, out, yield);
+ * @endcode
+ *
+ * The source may be used as a role source of `ozo::failover::role_based_connection_source`
+ * as well, e.g. for the `ozo::failover::replica` role. Copies of the source are cheap and share
+ * the replicas state, so a role-based source may be constructed per request with the
+ * requirement of the request.
+ */
+
+namespace ozo::failover {
+
+/**
+ * @brief Replay position of a replica
+ * @ingroup group-failover-replication_lag
+ */
+struct replica_position {
+    bool known = false; //!< the position has been obtained by the latest poll of the replica or `update()`
+    std::int64_t lsn = 0; //!< the last replayed LSN
+    time_traits::duration lag = time_traits::duration::zero(); //!< replay lag at the moment of update
+    time_traits::time_point updated_at{}; //!< time of the update
+
+    /**
+     * Staleness of the replica data, i.e. the replay lag plus the age of the position.
+     *
+     * @param now --- current time.
+     */
+    time_traits::duration staleness(time_traits::time_point now) const {
+        return lag + (now > updated_at ? now - updated_at : time_traits::duration::zero());
+    }
+};
+
+/**
+ * @brief Consistency requirement of a read request
+ *
+ * By default there are no requirements and any replica may serve a request.
+ *
+ * @ingroup group-failover-replication_lag
+ */
+struct read_consistency {
+    std::int64_t min_lsn = 0; //!< minimum LSN a replica should have replayed
+    time_traits::duration max_staleness = time_traits::duration::max(); //!< maximum staleness of a replica data
+
+    /**
+     * Indicates if the requirement has no constraints.
+     */
+    bool unconstrained() const noexcept {
+        return min_lsn <= 0 && max_staleness == time_traits::duration::max();
+    }
+
+    /**
+     * Indicates if a replica at the position satisfies the requirement.
+     *
+     * @param pos --- position of the replica.
+     * @param now --- current time.
+     */
+    bool satisfied_by(const replica_position& pos, time_traits::time_point now) const {
+        if (unconstrained()) {
+            return true;
+        }
+        return pos.known && pos.lsn >= min_lsn && pos.staleness(now) <= max_staleness;
+    }
+};
+
+namespace detail {
+
+template <typename Source>
+struct lag_aware_source_state {
+    struct replica {
+        Source source;
+        replica_position position;
+        std::optional<asio::strand<io_context::executor_type>> strand;
+        std::optional<asio::steady_timer> timer;
+        std::optional<connection_type<Source>> poll_connection;
+
+        explicit replica(Source s) : source(std::move(s)) {}
+    };
+
+    Source master;
+    std::vector<std::unique_ptr<replica>> replicas;
+    mutable std::mutex mutex;
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> monitoring{false};
+    std::atomic<std::size_t> generation{0};
+
+    explicit lag_aware_source_state(Source m) : master(std::move(m)) {}
+
+    const Source* pick(const read_consistency& requirement, time_traits::time_point now) {
+        const auto size = replicas.size();
+        const auto offset = next.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard lock(mutex);
+        for (std::size_t i = 0; i < size; ++i) {
+            auto& r = *replicas[(offset + i) % size];
+            if (requirement.satisfied_by(r.position, now)) {
+                return std::addressof(r.source);
+            }
+        }
+        return nullptr;
+    }
+
+    void update(std::size_t n, std::int64_t lsn, time_traits::duration lag, time_traits::time_point now) {
+        std::lock_guard lock(mutex);
+        replicas.at(n)->position = replica_position{true, lsn, lag, now};
+    }
+
+    void invalidate(std::size_t n, time_traits::time_point now) {
+        std::lock_guard lock(mutex);
+        replicas.at(n)->position = replica_position{false, 0, time_traits::duration::zero(), now};
+    }
+
+    replica_position position(std::size_t n) const {
+        std::lock_guard lock(mutex);
+        return replicas.at(n)->position;
+    }
+};
+
+inline auto make_replay_position_query() {
+    return ozo::make_query(
+        "SELECT (pg_last_wal_replay_lsn() - '0/0'::pg_lsn)::bigint, "
+        "CASE WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN '0'::interval "
+        "ELSE now() - pg_last_xact_replay_timestamp() END"
+    );
+}
+
+/**
+ * Polling loop of a replica replay position. The loop keeps a weak reference to the
+ * source state and stops then the state is destroyed or the monitoring generation changes,
+ * i.e. the monitoring is stopped. All the timer operations are performed via the replica strand.
+ *
+ * The connection of a successful poll is kept in the replica state and reused by the next
+ * poll while it is good, a new connection is obtained from the replica source only after
+ * an error. The connection is accessed via the replica strand as well.
+ *
+ * A failed poll or a NULL replay position, i.e. the replica is not in recovery anymore,
+ * makes the replica position unknown, so constrained requests are not routed to it.
+ */
+template <typename State>
+struct replica_poll_op {
+    using rows_type = ozo::rows_of<std::optional<std::int64_t>, std::optional<pg::interval>>;
+
+    std::weak_ptr<State> state_;
+    std::size_t n_;
+    std::size_t generation_;
+    io_context* io_;
+    time_traits::duration interval_;
+    time_traits::duration timeout_;
+
+    bool active(const State& state) const {
+        return state.generation.load() == generation_;
+    }
+
+    void perform() const {
+        auto state = state_.lock();
+        if (!state || !active(*state)) {
+            return;
+        }
+        auto& replica = *state->replicas[n_];
+        auto rows = std::make_shared<rows_type>();
+        auto handler = asio::bind_executor(*replica.strand, [op = *this, rows] (error_code ec, auto conn) {
+            op.on_response(ec, *rows, std::move(conn));
+        });
+        auto conn = std::move(replica.poll_connection);
+        replica.poll_connection.reset();
+        if (conn && connection_good(*conn)) {
+            return ozo::request(std::move(*conn), make_replay_position_query(), timeout_,
+                ozo::into(*rows), std::move(handler));
+        }
+        ozo::request(connection_provider(replica.source, *io_), make_replay_position_query(), timeout_,
+            ozo::into(*rows), std::move(handler));
+    }
+
+    template <typename Connection>
+    void on_response(error_code ec, const rows_type& rows, Connection&& conn) const {
+        auto state = state_.lock();
+        if (!state || !active(*state)) {
+            return;
+        }
+        if (!ec) {
+            state->replicas[n_]->poll_connection.emplace(std::forward<Connection>(conn));
+        }
+        if (!ec && !rows.empty() && std::get<0>(rows.front())) {
+            const auto& [lsn, lag] = rows.front();
+            state->update(n_, *lsn, std::max(time_traits::duration::zero(),
+                std::chrono::duration_cast<time_traits::duration>(lag.value_or(pg::interval::zero()))),
+                time_traits::now());
+        } else {
+            state->invalidate(n_, time_traits::now());
+        }
+        auto& timer = *state->replicas[n_]->timer;
+        timer.expires_after(interval_);
+        timer.async_wait([op = *this] (error_code ec) {
+            if (!ec) {
+                op.perform();
+            }
+        });
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Connection source which routes requests to replicas according to their replication lag
+ *
+ * `ConnectionSource` of a master and its replicas. A request is served by a replica which
+ * satisfies the `ozo::failover::read_consistency` requirement of the source object (the replicas
+ * are examined in round-robin order), or by the master if there is no such replica.
+ *
+ * The replicas positions are updated via `start_monitoring()` or `update()`. A replica with an
+ * unknown position satisfies only an unconstrained requirement. The position becomes unknown
+ * if a poll of the replica fails or the replica is not in recovery anymore, see `invalidate()`.
+ *
+ * Copies of the object share the master, the replicas and their positions, the requirement is
+ * a property of a particular copy, see `with()`, `min_lsn()`, `max_staleness()`.
+ *
+ * @tparam Source --- `ConnectionSource` implementation of the master and the replicas.
+ * @ingroup group-failover-replication_lag
+ * @models{ConnectionSource}
+ */
+template <typename Source>
+class lag_aware_connection_source {
+    static_assert(ozo::ConnectionSource<Source>, "Source should model a ConnectionSource concept");
+
+    using state_type = detail::lag_aware_source_state<Source>;
+    std::shared_ptr<state_type> state_;
+    read_consistency requirement_;
+
+public:
+    /**
+     * `Connection` implementation type according to `ConnectionSource` requirements.
+     * Specifies the `Connection` implementation type which can be obtained from this source.
+     */
+    using connection_type = typename connection_source_traits<Source>::connection_type;
+
+    /**
+     * Construct a new `lag_aware_connection_source` object.
+     *
+     * @param master --- source of the master connections.
+     * @param replicas --- sources of the replicas connections.
+     */
+    lag_aware_connection_source(Source master, std::vector<Source> replicas)
+    : state_(std::make_shared<state_type>(std::move(master))) {
+        state_->replicas.reserve(replicas.size());
+        for (auto& replica : replicas) {
+            state_->replicas.push_back(std::make_unique<typename state_type::replica>(std::move(replica)));
+        }
+    }
+
+    /**
+     * Number of replicas.
+     */
+    std::size_t size() const noexcept { return state_->replicas.size(); }
+
+    /**
+     * Current replay position of the replica.
+     *
+     * @param n --- index of the replica in order of construction.
+     */
+    replica_position position(std::size_t n) const { return state_->position(n); }
+
+    /**
+     * Update replay position of the replica. The position replaces the previous one, so a replica
+     * which has been rewound is not considered to have replayed the previous LSN.
+     *
+     * @param n --- index of the replica in order of construction.
+     * @param lsn --- replayed LSN.
+     * @param lag --- replay lag.
+     * @param now --- time of the position.
+     */
+    void update(std::size_t n, std::int64_t lsn, time_traits::duration lag,
+            time_traits::time_point now = time_traits::now()) {
+        state_->update(n, lsn, lag, now);
+    }
+
+    /**
+     * Make replay position of the replica unknown, e.g. if the replica is unreachable.
+     *
+     * @param n --- index of the replica in order of construction.
+     * @param now --- time of the invalidation.
+     */
+    void invalidate(std::size_t n, time_traits::time_point now = time_traits::now()) {
+        state_->invalidate(n, now);
+    }
+
+    /**
+     * Consistency requirement of the source object.
+     */
+    const read_consistency& requirement() const noexcept { return requirement_; }
+
+    /**
+     * Get a copy of the source with the consistency requirement.
+     *
+     * @param requirement --- consistency requirement of requests.
+     */
+    lag_aware_connection_source with(read_consistency requirement) const {
+        auto copy = *this;
+        copy.requirement_ = requirement;
+        return copy;
+    }
+
+    /**
+     * Get a copy of the source which requires a replica to replay the LSN.
+     *
+     * @param lsn --- minimum replayed LSN.
+     */
+    lag_aware_connection_source min_lsn(std::int64_t lsn) const {
+        return with(read_consistency{lsn, requirement_.max_staleness});
+    }
+
+    /**
+     * Get a copy of the source which requires a replica data to be not older than the duration.
+     *
+     * @param staleness --- maximum staleness of a replica data.
+     */
+    lag_aware_connection_source max_staleness(time_traits::duration staleness) const {
+        return with(read_consistency{requirement_.min_lsn, staleness});
+    }
+
+    /**
+     * Start polling of the replicas replay positions via `pg_last_wal_replay_lsn()`. Each replica
+     * is polled with a separate connection from its source which is kept between the polls
+     * and replaced after an error. The polling stops on `stop_monitoring()`
+     * call or then all the copies of the source are destroyed. All the calls should use the same `io`.
+     *
+     * @param io --- `io_context` to perform the polling on.
+     * @param interval --- interval between polls of a replica.
+     * @param timeout --- time constraint of a poll request.
+     */
+    void start_monitoring(io_context& io, time_traits::duration interval,
+            time_traits::duration timeout = std::chrono::seconds(1)) {
+        if (state_->monitoring.exchange(true)) {
+            return;
+        }
+        const auto generation = ++state_->generation;
+        for (std::size_t n = 0; n < state_->replicas.size(); ++n) {
+            auto& replica = *state_->replicas[n];
+            if (!replica.timer) {
+                replica.strand.emplace(io.get_executor());
+                replica.timer.emplace(*replica.strand);
+            }
+            asio::post(*replica.strand, [op = detail::replica_poll_op<state_type>{state_, n, generation, &io, interval, timeout}] {
+                op.perform();
+            });
+        }
+    }
+
+    /**
+     * Stop polling of the replicas replay positions. Known positions are kept, connections
+     * used for the polling are closed.
+     */
+    void stop_monitoring() {
+        if (!state_->monitoring.exchange(false)) {
+            return;
+        }
+        ++state_->generation;
+        for (auto& replica : state_->replicas) {
+            asio::post(*replica->strand, [state = state_, r = replica.get()] {
+                r->timer->cancel();
+                r->poll_connection.reset();
+            });
+        }
+    }
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (io_context& io, TimeConstraint t, Handler&& handler) const {
+        static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+        if (auto replica = state_->pick(requirement_, time_traits::now())) {
+            return (*replica)(io, std::move(t), std::forward<Handler>(handler));
+        }
+        state_->master(io, std::move(t), std::forward<Handler>(handler));
+    }
+
+    auto operator [](io_context& io) const {
+        return connection_provider(*this, io);
+    }
+};
+
+} // namespace ozo::failover
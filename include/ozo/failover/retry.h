@@ -2,11 +2,34 @@
 
 #include <ozo/failover/strategy.h>
 #include <ozo/core/options.h>
+#include <ozo/ext/std/shared_ptr.h>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <random>
 
 /**
  * @defgroup group-failover-retry Retry
  * @ingroup group-failover
  * @brief Failover by simple retry operation
+ *
+ * Immediate and unlimited retries amplify the load on a database which is already in trouble.
+ * So the retry strategy supports a delay between tries (see `ozo::failover::retry_options::backoff`
+ * and `ozo::failover::exponential_backoff`) and a budget which limits the number of retries
+ * relative to the number of operations (see `ozo::failover::retry_options::budget` and
+ * `ozo::failover::retry_budget`).
+ *
+ * @code
+auto budget = std::make_shared<ozo::failover::retry_budget>(0.1);
+
+auto retry = ozo::failover::retry(ozo::errc::connection_error)*3;
+ozo::request[retry.set(
+    ozo::failover::retry_options::backoff=ozo::failover::exponential_backoff{10ms, 100ms},
+    ozo::failover::retry_options::budget=budget
+)](pool, query, .5s, out, yield);
+ * @endcode
  */
 
 namespace ozo::failover {
@@ -29,8 +52,133 @@ constexpr auto make_errcs_tuple(ErrorConditions ...errcs) {
     return hana::make_tuple(errcs...);
 }
 
+/**
+ * `ConnectionProvider` wrapper which waits for the backoff delay before getting a connection.
+ * The timer runs on the executor associated with the handler, i.e. on the operation executor.
+ * The delay is bounded by the try time constraint.
+ */
+template <typename Provider>
+struct backoff_connection_provider {
+    Provider provider_;
+    time_traits::duration delay_;
+
+    using connection_type = ozo::connection_type<Provider>;
+
+    template <typename TimeConstraint, typename Handler>
+    void async_get_connection(TimeConstraint t, Handler&& h) const {
+        if (delay_ <= time_traits::duration::zero()) {
+            return ozo::async_get_connection(provider_, t, std::forward<Handler>(h));
+        }
+        const auto deadline = ozo::deadline(t);
+        auto delay = delay_;
+        if constexpr (!std::is_same_v<TimeConstraint, none_t>) {
+            delay = std::min(delay, time_left(deadline));
+        }
+        auto timer = std::make_shared<asio::steady_timer>(asio::get_associated_executor(h));
+        timer->expires_after(delay);
+        timer->async_wait([timer, provider = provider_, deadline, h = std::forward<Handler>(h)] (error_code) mutable {
+            ozo::async_get_connection(provider, deadline, std::move(h));
+        });
+    }
+};
+
 } // namespace detail
 
+/**
+ * @brief Exponential backoff with full jitter
+ *
+ * Delay before the n<small>th</small> retry is a random value uniformly distributed
+ * in range [0, min(`cap`, `base` * 2<small>n</small>)]. The randomization spreads retries
+ * of many clients in time, so they do not hit the database at once.
+ *
+ * @ingroup group-failover-retry
+ */
+struct exponential_backoff {
+    time_traits::duration base; //!< upper bound of the first retry delay
+    time_traits::duration cap; //!< maximum upper bound of a retry delay
+
+    /**
+     * Delay before a retry.
+     *
+     * @param n --- retry number starting from 0.
+     * @return time_traits::duration --- delay before the retry.
+     */
+    time_traits::duration operator() (int n) const {
+        const auto shift = std::clamp(n, 0, 30);
+        const auto limit = base.count() > cap.count() >> shift ? cap : std::min(cap, base * (1 << shift));
+        if (limit <= time_traits::duration::zero()) {
+            return time_traits::duration::zero();
+        }
+        thread_local std::minstd_rand random{std::random_device{}()};
+        std::uniform_int_distribution<time_traits::duration::rep> distribution(0, limit.count());
+        return time_traits::duration(distribution(random));
+    }
+};
+
+/**
+ * @brief Retry budget
+ *
+ * Thread-safe token bucket which limits the number of retries relative to the number of
+ * operations. Each operation deposits `ratio` tokens, each retry withdraws one token. A retry
+ * is not performed if there are no tokens left. So during an outage the number of retries is
+ * bounded by `ratio` of the operations number plus the `reserve`. The bucket holds no more
+ * than `reserve` tokens and is full initially.
+ *
+ * The budget should be shared between operations which go to the same database, e.g. it may
+ * be created per `ozo::connection_pool` and passed via `ozo::failover::retry_options::budget`
+ * as `std::shared_ptr`.
+ *
+ * @ingroup group-failover-retry
+ */
+class retry_budget {
+public:
+    /**
+     * Construct a new `retry_budget` object.
+     *
+     * @param ratio --- number of retries allowed per an operation, e.g. 0.1 for 10%.
+     * @param reserve --- capacity of the bucket, i.e. the number of retries allowed in a burst.
+     */
+    explicit retry_budget(double ratio = 0.1, double reserve = 10)
+    : ratio_(ratio), reserve_(std::max(reserve, 1.0)), tokens_(reserve_) {}
+
+    /**
+     * Account an operation.
+     */
+    void deposit() {
+        std::lock_guard lock(mutex_);
+        tokens_ = std::min(reserve_, tokens_ + ratio_);
+    }
+
+    /**
+     * Get a token for a retry.
+     *
+     * @return true --- the retry is allowed.
+     * @return false --- the budget is exhausted.
+     */
+    bool try_withdraw() {
+        std::lock_guard lock(mutex_);
+        if (tokens_ < 1.0) {
+            return false;
+        }
+        tokens_ -= 1.0;
+        return true;
+    }
+
+    /**
+     * Number of tokens in the bucket.
+     */
+    double tokens() const {
+        std::lock_guard lock(mutex_);
+        return tokens_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    const double ratio_;
+    const double reserve_;
+    double tokens_;
+};
+
 /**
  * @brief Options for retry
  *
@@ -42,11 +190,15 @@ struct retry_options {
     class close_connection_tag;
     class tries_tag;
     class conditions_tag;
+    class backoff_tag;
+    class budget_tag;
 
     constexpr static option<on_retry_tag> on_retry{}; //!< Set handler for retry event, may be useful for logging.
     constexpr static option<close_connection_tag> close_connection{}; //!< Set close connection policy on retry, possible values `true`(default), `false`.
     constexpr static option<tries_tag> tries{}; //!< Set number of tries, see `ozo::retry_strategy::tries()` for more information.
     constexpr static option<conditions_tag> conditions{}; //!< Set error conditions to retry
+    constexpr static option<backoff_tag> backoff{}; //!< Set delay before a retry, function with signature `time_traits::duration(int n)` there `n` is the retry number starting from 0, e.g. `ozo::failover::exponential_backoff`; the delay is a part of the try time constraint.
+    constexpr static option<budget_tag> budget{}; //!< Set retry budget shared between operations, `std::shared_ptr` or `std::reference_wrapper` of `ozo::failover::retry_budget`.
 };
 
 /**
@@ -92,7 +244,7 @@ public:
      */
     auto get_context() const {
         return hana::concat(
-            hana::make_tuple(ozo::unwrap(ctx_).provider, time_constraint()),
+            hana::make_tuple(get_provider(), time_constraint()),
             ozo::unwrap(ctx_).args
         );
     }
@@ -115,9 +267,12 @@ public:
 
         std::optional<basic_try> retval;
         adjust_tries_remain();
-        if (can_retry(ec)) {
+        if (can_retry(ec) && withdraw_budget()) {
             get_option(options(), op::on_retry, [](auto&&...){})(ec, conn);
+            const auto delay = get_delay();
             retval.emplace(basic_try{std::move(options_), std::move(ctx_)});
+            retval->retries_ = retries_ + 1;
+            retval->delay_ = delay;
         }
 
         return retval;
@@ -144,7 +299,40 @@ public:
         return detail::get_try_time_constraint(ozo::unwrap(ctx_).time_constraint, tries_remain());
     }
 
+    /**
+     * @brief Delay before the try
+     *
+     * @return time_traits::duration --- delay calculated via `ozo::failover::retry_options::backoff`,
+     *                                    zero for the first try.
+     */
+    time_traits::duration delay() const { return delay_; }
+
 private:
+    auto get_provider() const {
+        if constexpr (decltype(hana::contains(options(), op::backoff))::value) {
+            using provider_type = std::decay_t<decltype(ozo::unwrap(ctx_).provider)>;
+            return detail::backoff_connection_provider<provider_type>{ozo::unwrap(ctx_).provider, delay_};
+        } else {
+            return ozo::unwrap(ctx_).provider;
+        }
+    }
+
+    time_traits::duration get_delay() const {
+        if constexpr (decltype(hana::contains(options(), op::backoff))::value) {
+            return options()[op::backoff](retries_);
+        } else {
+            return time_traits::duration::zero();
+        }
+    }
+
+    bool withdraw_budget() const {
+        if constexpr (decltype(hana::contains(options(), op::budget))::value) {
+            return ozo::unwrap(options()[op::budget]).try_withdraw();
+        } else {
+            return true;
+        }
+    }
+
     void adjust_tries_remain() {
         options_[op::tries] = std::max(0, tries_remain() - 1);
     }
@@ -161,6 +349,9 @@ private:
         }
     }
     constexpr static const auto no_conditions_ = hana::make_tuple();
+
+    int retries_ = 0;
+    time_traits::duration delay_ = time_traits::duration::zero();
 };
 
 
@@ -211,6 +402,10 @@ public:
 
         static_assert(decltype(this->has(op::tries))::value, "number of tries should be specified");
 
+        if constexpr (decltype(this->has(op::budget))::value) {
+            ozo::unwrap(this->get(op::budget)).deposit();
+        }
+
         return basic_try {
             this->options(),
             basic_context{
@@ -42,6 +42,9 @@
  * which bind the provider to a specific role. Such a mechanism allows to switch between roles
  * and get connections to their hosts during the execution of the strategy.
  *
+ * A fallback role is skipped if its source is known to be unavailable (see `ozo::failover::is_available()`),
+ * e.g. if its host is guarded by `ozo::failover::circuit_breaker_source` with an open circuit.
+ *
  * The example of the strategy use can be found in `examples/role_based_request.cpp` .
  *
  * @include examples/role_based_request.cpp
@@ -300,6 +303,11 @@ public:
         return rebind_type{ozo::unwrap(std::forward<Source>(source_)).rebind_role(r), io_};
     }
 
+    /**
+     * Indicates if the source is available, see `ozo::failover::is_available()`.
+     */
+    bool is_available() const { return failover::is_available(source_); }
+
     template <typename TimeConstraint, typename Handler>
     void async_get_connection(TimeConstraint t, Handler&& h) const & {
         static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
@@ -368,6 +376,11 @@ struct role_based_connection_source {
         return {std::move(sources_), r};
     }
 
+    /**
+     * Indicates if the source of the current role is available, see `ozo::failover::is_available()`.
+     */
+    bool is_available() const { return failover::is_available(sources_[role_]); }
+
     template <typename TimeConstraint, typename Handler>
     constexpr void operator() (io_context& io, TimeConstraint t, Handler&& h) const & {
         sources_[role_](io, std::move(t), std::forward<Handler>(h));
@@ -499,6 +512,16 @@ public:
         return get_option(options(), opt::roles);
     }
 
+    /**
+     * Indicates if the connection source of the try's role is available, see `ozo::failover::is_available()`.
+     *
+     * @return true --- the try may be initiated.
+     * @return false --- the try should be skipped.
+     */
+    bool is_available() const {
+        return failover::is_available(ozo::unwrap(ctx_).provider.rebind_role(role()));
+    }
+
     /**
      * Tries left after this try
      *
@@ -526,7 +549,7 @@ public:
             using fallback_try = role_based_try<Options, Context, decltype(role_index() + hana::size_c<1>)>;
             fallback_try fallback{std::move(options_), std::move(ctx_)};
 
-            if (can_recover(fallback.role(), ec)) {
+            if (can_recover(fallback.role(), ec) && fallback.is_available()) {
                 get_option(fallback.options(), opt::on_fallback, [](auto&&...){})(ec, conn, std::as_const(fallback));
                 init(std::move(fallback));
             } else {
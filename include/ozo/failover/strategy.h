@@ -4,6 +4,7 @@
 #include <ozo/asio.h>
 #include <ozo/deadline.h>
 #include <ozo/connection.h>
+#include <ozo/io/binary_query.h>
 
 #include <tuple>
 
@@ -138,6 +139,10 @@ namespace hana = boost::hana;
 /**
  * @brief Basic operation context
  *
+ * Arguments which are converted to `ozo::binary_query` by an operation, i.e. queries,
+ * are stored as `ozo::cached_binary_query`. So the query of an operation is serialized
+ * once and all the tries send the same binary representation.
+ *
  * @tparam ConnectionProvider --- connection provider type.
  * @tparam TimeConstraint --- operation #TimeConstraint type.
  * @tparam Args --- other operation arguments' type.
@@ -153,7 +158,7 @@ struct basic_context {
 
     std::decay_t<ConnectionProvider> provider; //!< connection provider for an operation, typically deduced from operation's 1st argument.
     TimeConstraint time_constraint; //!< #TimeConstraint for an operation, typically deduced from operation's 2nd argument.
-    hana::tuple<std::decay_t<Args>...> args; //!< Other arguments of an operation except #CompletionToken.
+    hana::tuple<cache_binary_query_t<Args>...> args; //!< Other arguments of an operation except #CompletionToken.
 
     /**
      * Construct a new basic context object
@@ -165,7 +170,7 @@ struct basic_context {
     basic_context(ConnectionProvider p, TimeConstraint t, Args ...args)
     : provider(std::forward<ConnectionProvider>(p)),
       time_constraint(t),
-      args(std::forward<Args>(args)...) {}
+      args(cache_binary_query(std::forward<Args>(args))...) {}
 };
 
 template <typename FailoverStrategy, typename Operation>
@@ -362,6 +367,40 @@ inline auto initiate_next_try(Try& a_try, const error_code& ec, Connection& conn
     return detail::apply<initiate_next_try_impl>(ozo::unwrap(a_try), ec, conn, std::forward<Initiator>(init));
 }
 
+template <typename Source, typename = hana::when<true>>
+struct is_available_impl {
+    static constexpr bool apply(const Source&) { return true; }
+};
+
+template <typename Source>
+struct is_available_impl<Source, hana::when_valid<decltype(std::declval<const Source&>().is_available())>> {
+    static bool apply(const Source& source) { return source.is_available(); }
+};
+
+/**
+ * @brief Determines if a connection source is available
+ *
+ * Failover strategies use this function to skip a `ConnectionSource` or a `ConnectionProvider`
+ * which is known to be unavailable, e.g. due to an open circuit breaker (see
+ * `ozo::failover::circuit_breaker_source`), instead of paying for a connection attempt.
+ * By default it calls `source.is_available()` if there is such member function,
+ * otherwise the source is considered available.
+ *
+ * @param source --- `ConnectionSource` or `ConnectionProvider` to examine.
+ * @return true --- the source may be used for an operation try.
+ * @return false --- the source is known to be unavailable.
+ *
+ * ###Customization Point
+ *
+ * This function may be customized for a source via specialization
+ * of `ozo::failover::is_available_impl`.
+ * @ingroup group-failover-strategy
+ */
+template <typename Source>
+inline bool is_available(const Source& source) {
+    return is_available_impl<std::decay_t<decltype(ozo::unwrap(source))>>::apply(ozo::unwrap(source));
+}
+
 namespace detail {
 
 template <template<typename...> typename Template, typename Allocator, typename ...Ts>
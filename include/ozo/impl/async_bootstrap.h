@@ -0,0 +1,222 @@
+#pragma once
+
+#include <ozo/impl/request_oid_map.h>
+#include <ozo/impl/io.h>
+#include <ozo/io/recv.h>
+#include <ozo/connection.h>
+#include <ozo/oid_map_cache.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ozo::impl {
+
+using session_statements = std::shared_ptr<const std::vector<std::string>>;
+
+/**
+ * Connection bootstrap operation. Executes session initialization statements (e.g. `SET`)
+ * and the oid map request of a new connection.
+ *
+ * If libpq supports the pipeline mode, all the statements and the oid map request are sent
+ * at once and take a single round trip. Otherwise the statements are sent as one multi-statement
+ * simple query, and the oid map is requested then.
+ */
+template <typename Connection, typename Handler>
+struct async_bootstrap_op {
+    struct context {
+        Connection conn;
+        Handler handler;
+        session_statements statements;
+        oids_result oids;
+        bool request_oids = false;
+        std::size_t queries = 0;
+        std::size_t finished = 0;
+        error_code ec;
+        std::string error_context;
+        bool reading = false;
+
+        context(Connection conn, Handler handler, session_statements statements)
+        : conn(std::move(conn)), handler(std::move(handler)), statements(std::move(statements)) {}
+    };
+
+    std::shared_ptr<context> ctx_;
+
+    async_bootstrap_op(Connection conn, Handler handler, session_statements statements) {
+        auto allocator = asio::get_associated_allocator(handler);
+        ctx_ = std::allocate_shared<context>(allocator, std::move(conn), std::move(handler), std::move(statements));
+    }
+
+    auto& connection() const noexcept { return unwrap_connection(ctx_->conn); }
+
+    void perform() {
+        auto& conn = connection();
+        if (auto ec = set_nonblocking(conn)) {
+            return done(ec);
+        }
+#ifdef LIBPQ_HAS_PIPELINING
+        auto& oid_map = conn.oid_map();
+        ctx_->request_oids = !ozo::empty(oid_map) && !oid_map_cache::instance().get(oid_map_cache_key(ctx_->conn, *ctx_->statements), oid_map);
+        if (!PQenterPipelineMode(get_native_handle(conn))) {
+            return done(error::pg_pipeline_failed, "PQenterPipelineMode failed");
+        }
+        for (const auto& statement : *ctx_->statements) {
+            if (!PQsendQueryParams(get_native_handle(conn), statement.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1)) {
+                return done(error::pg_send_query_params_failed, statement);
+            }
+            ++ctx_->queries;
+        }
+        if (ctx_->request_oids) {
+            ctx_->oids.reserve(hana::length(oid_map.impl));
+            const auto query = to_binary_query(make_oids_query(oid_map), oid_map, asio::get_associated_allocator(ctx_->handler));
+            if (!send_query_params(conn, query)) {
+                return done(error::pg_send_query_params_failed, "oid map request");
+            }
+            ++ctx_->queries;
+        }
+        if (!PQpipelineSync(get_native_handle(conn))) {
+            return done(error::pg_pipeline_failed, "PQpipelineSync failed");
+        }
+#else
+        std::string query;
+        for (const auto& statement : *ctx_->statements) {
+            query += statement;
+            query += ";\n";
+        }
+        if (!PQsendQuery(get_native_handle(conn), query.c_str())) {
+            return done(error::pg_send_query_params_failed, "session statements");
+        }
+        ctx_->queries = 1;
+#endif
+        (*this)();
+    }
+
+    void operator() (error_code ec = error_code{}, std::size_t = 0) {
+        if (ec) {
+            return done(ec, ctx_->reading ? "error while get bootstrap result" : "error while send bootstrap queries");
+        }
+        if (!ctx_->reading) {
+            switch (flush_output(connection())) {
+                case query_state::error:
+                    return done(error::pg_flush_failed);
+                case query_state::send_in_progress:
+                    return connection().async_wait_write(std::move(*this));
+                case query_state::send_finish:
+                    ctx_->reading = true;
+                    return read();
+            }
+        }
+        if (auto err = consume_input(connection())) {
+            return done(err);
+        }
+        read();
+    }
+
+    void read() {
+        auto& conn = connection();
+        while (true) {
+            if (is_busy(conn)) {
+                return conn.async_wait_read(std::move(*this));
+            }
+            auto res = get_result(conn);
+            if (!res) {
+                // Each query results are terminated with null result
+                if (++ctx_->finished > ctx_->queries) {
+                    return done(error::result_status_unexpected, "unexpected end of bootstrap results");
+                }
+#ifndef LIBPQ_HAS_PIPELINING
+                return finish();
+#else
+                continue;
+#endif
+            }
+            switch (result_status(*res)) {
+#ifdef LIBPQ_HAS_PIPELINING
+                case PGRES_PIPELINE_SYNC:
+                    if (!PQexitPipelineMode(get_native_handle(conn))) {
+                        return done(error::pg_pipeline_failed, "PQexitPipelineMode failed");
+                    }
+                    return finish();
+                case PGRES_PIPELINE_ABORTED:
+                    break;
+#endif
+                case PGRES_TUPLES_OK:
+                    if (is_oids_result()) try {
+                        ozo::recv_result(ozo::make_result(std::move(res)), conn.oid_map(), std::back_inserter(ctx_->oids));
+                    } catch (const std::exception& e) {
+                        set_error(error::oid_request_failed, e.what());
+                    }
+                    break;
+                case PGRES_COMMAND_OK:
+                    break;
+                case PGRES_FATAL_ERROR:
+                    set_error(result_error(*res), PQresultErrorMessage(res.get()));
+                    break;
+                default:
+                    set_error(error::result_status_unexpected, get_result_status_name(result_status(*res)));
+                    break;
+            }
+        }
+    }
+
+    bool is_oids_result() const noexcept {
+        return ctx_->request_oids && ctx_->finished + 1 == ctx_->queries;
+    }
+
+    void set_error(error_code ec, std::string context) {
+        if (!ctx_->ec) {
+            ctx_->ec = std::move(ec);
+            ctx_->error_context = std::move(context);
+        }
+    }
+
+    void finish() {
+        if (ctx_->ec) {
+            return done(ctx_->ec, std::move(ctx_->error_context));
+        }
+        auto& oid_map = connection().oid_map();
+        if (ctx_->request_oids) {
+            try {
+                set_oid_map(oid_map, ctx_->oids);
+            } catch (const std::exception& e) {
+                return done(error::oid_request_failed, e.what());
+            }
+            oid_map_cache::instance().put(oid_map_cache_key(ctx_->conn, *ctx_->statements), oid_map);
+        }
+#ifndef LIBPQ_HAS_PIPELINING
+        if (!ozo::empty(oid_map) && !oid_map_cache::instance().get(oid_map_cache_key(ctx_->conn, *ctx_->statements), oid_map)) {
+            request_oid_map_op op{std::move(ctx_->handler)};
+            return op.perform(std::move(ctx_->conn));
+        }
+#endif
+        std::move(ctx_->handler)(error_code{}, std::move(ctx_->conn));
+    }
+
+    void done(error_code ec, std::string context = {}) {
+        if (!context.empty()) {
+            connection().set_error_context(std::move(context));
+        }
+        std::move(ctx_->handler)(std::move(ec), std::move(ctx_->conn));
+    }
+
+    using executor_type = asio::associated_executor_t<Handler>;
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(ctx_->handler);
+    }
+
+    using allocator_type = asio::associated_allocator_t<Handler>;
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(ctx_->handler);
+    }
+};
+
+template <typename Connection, typename Handler>
+inline void async_bootstrap(Connection&& conn, session_statements statements, Handler&& handler) {
+    async_bootstrap_op<std::decay_t<Connection>, std::decay_t<Handler>> op{
+        std::forward<Connection>(conn), std::forward<Handler>(handler), std::move(statements)};
+    op.perform();
+}
+
+} // namespace ozo::impl
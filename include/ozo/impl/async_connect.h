@@ -5,8 +5,10 @@
 #include <ozo/detail/deadline.h>
 #include <ozo/impl/io.h>
 #include <ozo/impl/request_oid_map.h>
+#include <ozo/impl/async_bootstrap.h>
 #include <ozo/time_traits.h>
 #include <ozo/connection.h>
+#include <ozo/statistics.h>
 
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/steady_timer.hpp>
@@ -16,23 +18,123 @@
 namespace ozo {
 namespace impl {
 
+template <typename Connection, typename = std::void_t<>>
+struct has_connect_phase_hook : std::false_type {};
+
+template <typename Connection>
+struct has_connect_phase_hook<Connection, std::void_t<decltype(
+    unwrap_connection(std::declval<Connection&>()).statistics().on_connect_phase(
+        std::declval<connect_phase>(), std::declval<time_traits::duration>())
+)>> : std::true_type {};
+
+template <typename Connection>
+inline void on_connect_phase([[maybe_unused]] Connection& conn, [[maybe_unused]] connect_phase phase,
+        [[maybe_unused]] time_traits::duration duration) {
+    if constexpr (has_connect_phase_hook<Connection>::value) {
+        unwrap_connection(conn).statistics().on_connect_phase(phase, duration);
+    }
+}
+
+inline connect_phase get_connect_phase(ConnStatusType status, connect_phase current) noexcept {
+    switch (status) {
+        case CONNECTION_STARTED:
+        case CONNECTION_MADE:
+            return connect_phase::connect;
+        case CONNECTION_SSL_STARTUP:
+            return connect_phase::tls;
+        case CONNECTION_AWAITING_RESPONSE:
+            return connect_phase::authentication;
+        case CONNECTION_OK:
+        case CONNECTION_BAD:
+            return current;
+        default:
+            break;
+    }
+    // Statuses after authentication, some of them are not supported by older libpq
+    return connect_phase::startup;
+}
+
+/**
+* Handler wrapper which reports duration of the connection bootstrap phase
+*/
+template <typename Handler>
+struct connect_phase_handler {
+    Handler handler_;
+    time_traits::time_point started_at_;
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection&& conn) {
+        on_connect_phase(conn, connect_phase::bootstrap, time_traits::now() - started_at_);
+        handler_(std::move(ec), std::forward<Connection>(conn));
+    }
+
+    using executor_type = asio::associated_executor_t<Handler>;
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = asio::associated_allocator_t<Handler>;
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+template <typename Connection, typename Handler>
+inline auto apply_bootstrap_phase_timing(Handler&& handler) {
+    if constexpr (has_connect_phase_hook<std::decay_t<Connection>>::value) {
+        return connect_phase_handler<std::decay_t<Handler>>{std::forward<Handler>(handler), time_traits::now()};
+    } else {
+        return std::forward<Handler>(handler);
+    }
+}
+
 /**
 * Asynchronous connection operation
+*
+* If the connection statistics provides `on_connect_phase()` hook the operation reports
+* duration of each `ozo::connect_phase`. A phase is determined by the connection status
+* after each `PQconnectPoll()` call.
 */
 template <typename Connection, typename Handler>
 struct async_connect_op {
     Connection connection_;
     Handler handler_;
+    connect_phase phase_ = connect_phase::resolve;
+    time_traits::time_point phase_started_at_;
+
+    static constexpr bool report_phases = has_connect_phase_hook<Connection>::value;
 
     auto& connection() noexcept {
         return unwrap_connection(connection_);
     }
 
+    void set_phase(connect_phase phase) {
+        if constexpr (report_phases) {
+            if (phase != phase_) {
+                const auto now = time_traits::now();
+                on_connect_phase(connection_, phase_, now - phase_started_at_);
+                phase_ = phase;
+                phase_started_at_ = now;
+            }
+        }
+    }
+
+    void update_phase() {
+        if constexpr (report_phases) {
+            set_phase(get_connect_phase(PQstatus(get_native_handle(connection_)), phase_));
+        }
+    }
+
     async_connect_op(Connection conn, Handler handler)
     : connection_(std::move(conn)), handler_(std::move(handler)) {
     }
 
     void perform(const std::string& conninfo) {
+        if constexpr (report_phases) {
+            phase_started_at_ = time_traits::now();
+        }
         auto handle = start_connection(connection(), conninfo);
         if (!handle) {
             return done(error::pq_connection_start_failed);
@@ -47,6 +149,7 @@ struct async_connect_op {
             return done(ec);
         }
 
+        update_phase();
         return connection().async_wait_write(std::move(*this));
     }
 
@@ -58,7 +161,9 @@ struct async_connect_op {
             return done(ec);
         }
 
-        switch (connect_poll(connection())) {
+        const auto status = connect_poll(connection());
+        update_phase();
+        switch (status) {
             case PGRES_POLLING_OK:
                 return done();
 
@@ -77,6 +182,9 @@ struct async_connect_op {
     }
 
     void done(error_code ec = error_code {}) {
+        if constexpr (report_phases) {
+            on_connect_phase(connection_, phase_, time_traits::now() - phase_started_at_);
+        }
         handler_(std::move(ec), std::move(connection_));
     }
 
@@ -98,6 +206,9 @@ async_connect_op(Connection, Handler) -> async_connect_op<Connection, Handler>;
 
 template <typename Connection, typename Handler>
 inline void request_oid_map(Connection&& conn, Handler&& handler) {
+    if (oid_map_cache::instance().get(oid_map_cache_key(conn), ozo::unwrap_connection(conn).oid_map())) {
+        return handler(error_code{}, std::forward<Connection>(conn));
+    }
     ozo::impl::request_oid_map_op op{std::forward<Handler>(handler)};
     op.perform(std::forward<Connection>(conn));
 }
@@ -113,7 +224,8 @@ struct request_oid_map_handler {
         if (ec) {
             handler_(std::move(ec), std::forward<Connection>(conn));
         } else {
-            request_oid_map(std::forward<Connection>(conn), std::move(handler_));
+            auto handler = apply_bootstrap_phase_timing<Connection>(std::move(handler_));
+            request_oid_map(std::forward<Connection>(conn), std::move(handler));
         }
     }
 
@@ -145,6 +257,37 @@ constexpr auto apply_oid_map_request(Handler&& handler) {
     }
 }
 
+template <typename Handler>
+struct session_bootstrap_handler {
+    Handler handler_;
+    session_statements statements_;
+
+    session_bootstrap_handler(Handler handler, session_statements statements)
+    : handler_(std::move(handler)), statements_(std::move(statements)) {}
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection&& conn) {
+        if (ec) {
+            handler_(std::move(ec), std::forward<Connection>(conn));
+        } else {
+            auto handler = apply_bootstrap_phase_timing<Connection>(std::move(handler_));
+            async_bootstrap(std::forward<Connection>(conn), std::move(statements_), std::move(handler));
+        }
+    }
+
+    using executor_type = asio::associated_executor_t<Handler>;
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = asio::associated_allocator_t<Handler>;
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
 template <typename TimeConstraint, typename Connection, typename Handler>
 inline auto apply_time_constaint(const TimeConstraint& t, [[maybe_unused]] Connection& conn, Handler&& handler) {
     if constexpr (IsNone<TimeConstraint>) {
@@ -171,5 +314,25 @@ inline void async_connect(std::string conninfo, const TimeConstraint& t,
     op.perform(conninfo);
 }
 
+/**
+* Connect and execute session initialization statements together with the oid map request,
+* see `ozo::impl::async_bootstrap_op`.
+*/
+template <typename Connection, typename TimeConstraint, typename Handler>
+inline void async_connect(std::string conninfo, const TimeConstraint& t,
+        Connection&& conn, session_statements statements, Handler&& handler) {
+    if (!statements || statements->empty()) {
+        return async_connect(std::move(conninfo), t, std::forward<Connection>(conn), std::forward<Handler>(handler));
+    }
+    static_assert(ozo::Connection<Connection>, "conn should model Connection concept");
+
+    auto wrapped_handler = session_bootstrap_handler {
+        apply_time_constaint(t, conn, std::forward<Handler>(handler)),
+        std::move(statements)
+    };
+    auto op = async_connect_op {std::forward<Connection>(conn), std::move(wrapped_handler)};
+    op.perform(conninfo);
+}
+
 } // namespace impl
 } // namespace ozo
@@ -4,14 +4,19 @@
 #include <ozo/detail/timeout_handler.h>
 #include <ozo/detail/wrap_executor.h>
 #include <ozo/impl/io.h>
+#include <ozo/impl/request_statistics.h>
 #include <ozo/io/binary_query.h>
 #include <ozo/connection.h>
 #include <ozo/query_builder.h>
 #include <ozo/deadline.h>
+#include <ozo/oid_map_cache.h>
 
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/coroutine.hpp>
 
+#include <string>
+#include <vector>
+
 namespace ozo {
 namespace impl {
 
@@ -20,6 +25,7 @@ struct request_operation_context {
     std::decay_t<Connection> conn;
     std::decay_t<Handler> handler;
     query_state state = query_state::send_in_progress;
+    time_traits::time_point started {};
 
     request_operation_context(Connection conn, Handler handler)
       : conn(std::forward<Connection>(conn)),
@@ -60,6 +66,7 @@ auto& get_handler(const request_operation_context_ptr<Ts ...>& context) noexcept
 
 template <typename ...Ts>
 inline void done(const request_operation_context_ptr<Ts...>& ctx, error_code ec) {
+    update_request_statistics(get_connection(ctx), get_request_error_category(ec), std::uint64_t(1));
     set_query_state(ctx, query_state::error);
     get_connection(ctx).cancel();
     std::move(get_handler(ctx))(std::move(ec), ctx->conn);
@@ -70,6 +77,41 @@ inline void done(const request_operation_context_ptr<Ts...>& ctx) {
     std::move(get_handler(ctx))(error_code {}, ctx->conn);
 }
 
+template <typename ...Ts>
+inline void start_request_statistics(const request_operation_context_ptr<Ts...>& ctx) {
+    using connection_type = std::decay_t<decltype(get_connection(ctx))>;
+    update_request_statistics(get_connection(ctx), request_counter::requests, std::uint64_t(1));
+    if constexpr (collects_request_timings<connection_type>) {
+        ctx->started = time_traits::now();
+    }
+}
+
+template <typename ...Ts>
+inline void update_request_phase(const request_operation_context_ptr<Ts...>& ctx, [[maybe_unused]] request_phase phase) {
+    using connection_type = std::decay_t<decltype(get_connection(ctx))>;
+    if constexpr (collects_request_timings<connection_type>) {
+        update_request_statistics(get_connection(ctx), phase, time_traits::now() - ctx->started);
+    }
+}
+
+/**
+ * Passes the result to the result processor and updates the rows and bytes statistics.
+ * Rows are counted as decoded only if the processor has succeeded.
+ */
+template <typename Context, typename ResultProcessor, typename Result, typename ...Args>
+inline void process_result(const Context& ctx, ResultProcessor& process, Result&& res, Args&& ...args) {
+    using connection_type = std::decay_t<decltype(get_connection(ctx))>;
+    if constexpr (has_request_statistics<connection_type, request_counter, std::uint64_t>::value) {
+        const std::uint64_t rows = ntuples(*res);
+        update_request_statistics(get_connection(ctx), request_counter::bytes_received, get_result_size(*res));
+        process(std::forward<Args>(args)..., std::forward<Result>(res), get_connection(ctx));
+        update_request_statistics(get_connection(ctx), request_counter::rows_decoded, rows);
+    } else {
+        process(std::forward<Args>(args)..., std::forward<Result>(res), get_connection(ctx));
+    }
+    update_request_phase(ctx, request_phase::decode);
+}
+
 template <typename Context>
 struct async_send_query_params_op {
     Context ctx_;
@@ -87,6 +129,7 @@ struct async_send_query_params_op {
         if (!send_query_params(conn, query_)) {
             return done(ctx_, error::pg_send_query_params_failed);
         }
+        update_request_statistics(conn, request_counter::bytes_sent, get_query_size(query_));
 
         (*this)();
     }
@@ -116,6 +159,7 @@ struct async_send_query_params_op {
                 break;
             case query_state::send_finish:
                 set_query_state(ctx_, query_state::send_finish);
+                update_request_phase(ctx_, request_phase::send);
                 break;
         }
     }
@@ -200,9 +244,12 @@ struct async_get_result_op : boost::asio::coroutine {
             result_ = get_result(get_connection(ctx_));
 
             if (!result_) {
+                update_request_phase(ctx_, request_phase::last_result);
                 return done();
             }
 
+            update_request_phase(ctx_, request_phase::first_byte);
+
             if (result_status(*result_) != PGRES_SINGLE_TUPLE) {
                 do {
                     while (is_busy(get_connection(ctx_))) {
@@ -212,6 +259,7 @@ struct async_get_result_op : boost::asio::coroutine {
                         }
                     }
                 } while (get_result(get_connection(ctx_)));
+                update_request_phase(ctx_, request_phase::last_result);
             }
 
             handle_result();
@@ -239,6 +287,10 @@ struct async_get_result_op : boost::asio::coroutine {
             case PGRES_COPY_IN:
             case PGRES_COPY_BOTH:
             case PGRES_NONFATAL_ERROR:
+#ifdef LIBPQ_HAS_PIPELINING
+            case PGRES_PIPELINE_SYNC:
+            case PGRES_PIPELINE_ABORTED:
+#endif
                 break;
         }
 
@@ -249,7 +301,14 @@ struct async_get_result_op : boost::asio::coroutine {
     template <typename Result>
     void process_and_done(Result&& res) noexcept {
         try {
-            process_(std::forward<Result>(res), get_connection(ctx_));
+            process_result(ctx_, process_, std::forward<Result>(res));
+        } catch (const system_error& e) {
+            if (e.code() == error::oid_type_mismatch) {
+                // Oids of the server may be changed, so it is better to request them again
+                oid_map_cache::instance().invalidate(oid_map_cache_key(get_connection(ctx_)));
+            }
+            get_connection(ctx_).set_error_context(e.what());
+            return done(error::bad_result_process);
         } catch (const std::exception& e) {
             get_connection(ctx_).set_error_context(e.what());
             return done(error::bad_result_process);
@@ -281,26 +340,301 @@ inline void async_get_result(Context&& ctx, ResultProcessor&& p) {
     op.perform();
 }
 
+/**
+ * Pipeline operation. Sends the statements and passes result of each statement to the result
+ * processor together with the statement index.
+ *
+ * If libpq supports the pipeline mode, all the statements are sent at once followed by a sync
+ * point and take a single round trip. Otherwise each statement is sent after the results of
+ * the previous one have been received.
+ *
+ * The operation completes with the error of the first failed statement. The following statements
+ * are not executed (the server aborts them in the pipeline mode) and the error context names the
+ * failed statement. All the results are read anyway, so the connection stays usable.
+ *
+ * A failure of the result processor does not stop the statements: in the pipeline mode they are
+ * on the server already, so they are executed in the fallback mode as well. The operation completes
+ * with `ozo::error::bad_result_process` only if all the statements have succeeded, otherwise the error
+ * of the failed statement is reported.
+ */
+template <typename Context, typename ResultProcessor>
+struct async_pipeline_op {
+    Context ctx_;
+    std::vector<binary_query> statements_;
+    ResultProcessor process_;
+    std::size_t sent_ = 0;
+    std::size_t finished_ = 0;
+    error_code ec_;
+    std::string error_context_;
+    bool process_failed_ = false;
+    bool reading_ = false;
+    bool received_ = false;
+
+    async_pipeline_op(Context ctx, std::vector<binary_query> statements, ResultProcessor process)
+    : ctx_(std::move(ctx)), statements_(std::move(statements)), process_(std::move(process)) {}
+
+    void perform() {
+        decltype(auto) conn = get_connection(ctx_);
+        if (auto ec = set_nonblocking(conn)) {
+            return done(ctx_, ec);
+        }
+#ifdef LIBPQ_HAS_PIPELINING
+        if (!enter_pipeline_mode(conn)) {
+            return fail(error::pg_pipeline_failed, "PQenterPipelineMode failed");
+        }
+        while (sent_ < statements_.size()) {
+            if (!send_next()) {
+                return;
+            }
+        }
+        if (!pipeline_sync(conn)) {
+            return fail(error::pg_pipeline_failed, "PQpipelineSync failed");
+        }
+#else
+        if (!send_next()) {
+            return;
+        }
+#endif
+        write();
+    }
+
+    void operator() (error_code ec = error_code{}, std::size_t = 0) {
+        if (ec) {
+            // Bad descriptor error can occur here if the connection
+            // has been closed by user during processing.
+            if (ec == asio::error::bad_descriptor) {
+                ec = asio::error::operation_aborted;
+            }
+            return fail(ec, reading_ ? "error while get pipeline result" : "error while send pipeline statements");
+        }
+        if (!reading_) {
+            return write();
+        }
+        if (auto err = consume_input(get_connection(ctx_))) {
+            return fail(err);
+        }
+        read();
+    }
+
+    bool send_next() {
+        if (!send_query_params(get_connection(ctx_), statements_[sent_])) {
+            fail(error::pg_send_query_params_failed, statement_context(sent_));
+            return false;
+        }
+        update_request_statistics(get_connection(ctx_), request_counter::bytes_sent, get_query_size(statements_[sent_]));
+        ++sent_;
+        return true;
+    }
+
+    void write() {
+        switch (flush_output(get_connection(ctx_))) {
+            case query_state::error:
+                return fail(error::pg_flush_failed);
+            case query_state::send_in_progress:
+                return get_connection(ctx_).async_wait_write(std::move(*this));
+            case query_state::send_finish:
+                if (!reading_ && finished_ == 0) {
+                    update_request_phase(ctx_, request_phase::send);
+                }
+                reading_ = true;
+                return read();
+        }
+    }
+
+    void read() {
+        decltype(auto) conn = get_connection(ctx_);
+        while (true) {
+            if (is_busy(conn)) {
+                return conn.async_wait_read(std::move(*this));
+            }
+            auto res = get_result(conn);
+            if (!res) {
+                // Each statement results are terminated with null result
+                if (++finished_ > statements_.size()) {
+                    return fail(error::result_status_unexpected, "unexpected end of pipeline results");
+                }
+#ifdef LIBPQ_HAS_PIPELINING
+                continue;
+#else
+                if ((ec_ && !process_failed_) || finished_ == statements_.size()) {
+                    return finish();
+                }
+                if (!send_next()) {
+                    return;
+                }
+                reading_ = false;
+                return write();
+#endif
+            }
+            if (!received_) {
+                received_ = true;
+                update_request_phase(ctx_, request_phase::first_byte);
+            }
+            const auto status = result_status(*res);
+            switch (status) {
+#ifdef LIBPQ_HAS_PIPELINING
+                case PGRES_PIPELINE_SYNC:
+                    if (!exit_pipeline_mode(conn)) {
+                        return fail(error::pg_pipeline_failed, "PQexitPipelineMode failed");
+                    }
+                    return finish();
+                case PGRES_PIPELINE_ABORTED:
+                    break;
+#endif
+                case PGRES_TUPLES_OK:
+                case PGRES_COMMAND_OK:
+                    if (!ec_) {
+                        process(std::move(res));
+                    }
+                    break;
+                case PGRES_BAD_RESPONSE:
+                    set_error(error::result_status_bad_response);
+                    break;
+                case PGRES_EMPTY_QUERY:
+                    set_error(error::result_status_empty_query);
+                    break;
+                case PGRES_FATAL_ERROR:
+                    set_error(result_error(*res));
+                    break;
+                default:
+                    set_error(error::result_status_unexpected, get_result_status_name(status));
+                    break;
+            }
+        }
+    }
+
+    template <typename Result>
+    void process(Result&& res) noexcept {
+        try {
+            process_result(ctx_, process_, std::forward<Result>(res), finished_);
+        } catch (const system_error& e) {
+            if (e.code() == error::oid_type_mismatch) {
+                // Oids of the server may be changed, so it is better to request them again
+                oid_map_cache::instance().invalidate(oid_map_cache_key(get_connection(ctx_)));
+            }
+            set_process_error(e.what());
+        } catch (const std::exception& e) {
+            set_process_error(e.what());
+        }
+    }
+
+    std::string statement_context(std::size_t index) const {
+        return std::string("error in pipeline statement: ") + statements_[index].text();
+    }
+
+    void set_error(error_code ec, std::string context = {}) {
+        if (!ec_ || process_failed_) {
+            ec_ = std::move(ec);
+            error_context_ = context.empty() ? statement_context(finished_) : std::move(context);
+            process_failed_ = false;
+        }
+    }
+
+    // Statement errors take precedence since the statements are executed anyway
+    void set_process_error(std::string context) {
+        if (!ec_) {
+            ec_ = error::bad_result_process;
+            error_context_ = std::move(context);
+            process_failed_ = true;
+        }
+    }
+
+    void finish() {
+        update_request_phase(ctx_, request_phase::last_result);
+        if (ec_) {
+            return fail(ec_, std::move(error_context_));
+        }
+        done(ctx_);
+    }
+
+    void fail(error_code ec, std::string context = {}) {
+        if (!context.empty()) {
+            get_connection(ctx_).set_error_context(std::move(context));
+        }
+        done(ctx_, std::move(ec));
+    }
+
+    using executor_type = std::decay_t<decltype(asio::get_associated_executor(get_handler(ctx_)))>;
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(get_handler(ctx_));
+    }
+
+    using allocator_type = std::decay_t<decltype(asio::get_associated_allocator(get_handler(ctx_)))>;
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(get_handler(ctx_));
+    }
+};
+
+template <typename Context, typename ResultProcessor>
+async_pipeline_op(Context, std::vector<binary_query>, ResultProcessor) -> async_pipeline_op<Context, ResultProcessor>;
+
+template <typename Context, typename ResultProcessor>
+inline void async_pipeline(Context&& ctx, std::vector<binary_query> statements, ResultProcessor&& p) {
+    async_pipeline_op op{std::forward<Context>(ctx), std::move(statements), std::forward<ResultProcessor>(p)};
+    op.perform();
+}
+
+/**
+ * Statements which should be sent in front of the next request on the connection.
+ * Only `ozo::transaction` may have such statements, see `ozo::transaction::defer_statement()`.
+ */
+template <typename Connection>
+inline std::vector<std::string> take_deferred_statements(Connection&) noexcept {
+    return {};
+}
+
+/**
+ * Result processor of the request which is sent as a part of pipeline: passes the result
+ * of the request statement to the request output handler and ignores other statements results.
+ */
+template <typename OutHandler>
+struct pipeline_request_processor {
+    OutHandler out;
+    std::size_t index;
+
+    template <typename Result, typename Conn>
+    void operator() (std::size_t i, Result&& res, Conn& conn) {
+        if (i == index) {
+            out(std::forward<Result>(res), conn);
+        }
+    }
+};
+
+template <typename OutHandler>
+pipeline_request_processor(OutHandler, std::size_t) -> pipeline_request_processor<OutHandler>;
+
+/**
+ * Wraps the request operation handler to be invoked via the connection strand and, if the time
+ * constraint is given, to cancel the connection I/O on the deadline.
+ */
+template <typename Connection, typename TimeConstraint, typename Handler>
+auto wrap_request_handler(Connection& conn, TimeConstraint t, Handler&& handler) {
+    auto wrapped = detail::wrap_executor {
+        detail::make_strand_executor(ozo::get_executor(conn)),
+        std::forward<Handler>(handler)
+    };
+    if constexpr (IsNone<TimeConstraint>) {
+        return wrapped;
+    } else {
+        return detail::io_deadline_handler<std::decay_t<decltype(unwrap_connection(conn))>, decltype(wrapped), Connection> {
+            unwrap_connection(conn), t, std::move(wrapped)
+        };
+    }
+}
+
 template <typename OutHandler, typename Query, typename TimeConstraint, typename Handler>
 struct async_request_op {
     OutHandler out_;
     Query query_;
     TimeConstraint time_constraint_;
     Handler handler_;
+    std::string epilogue_;
 
-    async_request_op(Query query, TimeConstraint time_constrain, OutHandler out, Handler handler)
-    : out_(std::move(out)), query_(std::move(query)), time_constraint_(time_constrain), handler_(std::move(handler)) {}
-
-    template <typename Connection, typename SourceHandler>
-    auto apply_time_constaint_or_strand (Connection& conn, SourceHandler&& handler) const {
-        if constexpr (IsNone<TimeConstraint>) {
-            return std::forward<SourceHandler>(handler);
-        } else {
-            return detail::io_deadline_handler<std::decay_t<decltype(unwrap_connection(conn))>, std::decay_t<SourceHandler>, Connection> {
-                unwrap_connection(conn), time_constraint_, std::forward<SourceHandler>(handler)
-            };
-        }
-    }
+    async_request_op(Query query, TimeConstraint time_constrain, OutHandler out, Handler handler, std::string epilogue = {})
+    : out_(std::move(out)), query_(std::move(query)), time_constraint_(time_constrain), handler_(std::move(handler)),
+      epilogue_(std::move(epilogue)) {}
 
     template <typename Connection>
     void operator() (error_code ec, Connection conn) {
@@ -308,15 +642,32 @@ struct async_request_op {
             return handler_(ec, std::move(conn));
         }
 
-        auto handler = apply_time_constaint_or_strand(conn, detail::wrap_executor {
-            detail::make_strand_executor(ozo::get_executor(conn)),
-            std::move(handler_)
-        });
+        auto handler = wrap_request_handler(conn, time_constraint_, std::move(handler_));
 
+        auto prologue = take_deferred_statements(conn);
         auto ctx = make_request_operation_context(std::move(conn), std::move(handler));
+        start_request_statistics(ctx);
+
+        if (prologue.empty() && epilogue_.empty()) {
+            async_send_query_params(ctx, std::move(query_));
+            return async_get_result(std::move(ctx), std::move(out_));
+        }
 
-        async_send_query_params(ctx, std::move(query_));
-        async_get_result(std::move(ctx), std::move(out_));
+        // Deferred statements (e.g. BEGIN of a pipelined transaction) and the epilogue
+        // (e.g. COMMIT) are sent together with the query within a single pipeline.
+        const auto& oid_map = get_connection(ctx).oid_map();
+        const auto allocator = asio::get_associated_allocator(get_handler(ctx));
+        std::vector<binary_query> statements;
+        statements.reserve(prologue.size() + 2);
+        for (auto& statement : prologue) {
+            statements.push_back(to_binary_query(make_query(std::move(statement)), oid_map, allocator));
+        }
+        const auto index = statements.size();
+        statements.push_back(to_binary_query(std::move(query_), oid_map, allocator));
+        if (!epilogue_.empty()) {
+            statements.push_back(to_binary_query(make_query(std::move(epilogue_)), oid_map, allocator));
+        }
+        async_pipeline(std::move(ctx), std::move(statements), pipeline_request_processor{std::move(out_), index});
     }
 
     using executor_type = std::decay_t<decltype(asio::get_associated_executor(handler_))>;
@@ -335,6 +686,9 @@ struct async_request_op {
 template <typename OutHandler, typename Query, typename TimeConstraint, typename Handler>
 async_request_op(Query, TimeConstraint, OutHandler, Handler) -> async_request_op<OutHandler, Query, TimeConstraint, Handler>;
 
+template <typename OutHandler, typename Query, typename TimeConstraint, typename Handler>
+async_request_op(Query, TimeConstraint, OutHandler, Handler, std::string) -> async_request_op<OutHandler, Query, TimeConstraint, Handler>;
+
 template <typename T>
 struct async_request_out_handler {
     T out;
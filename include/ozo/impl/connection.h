@@ -8,6 +8,8 @@
 #include <string>
 #include <sstream>
 
+#include <poll.h>
+
 namespace ozo {
 
 namespace detail {
@@ -22,6 +24,42 @@ inline bool connection_status_ok(NativeHandle handle) noexcept {
     return handle && PQstatus(handle) == CONNECTION_OK;
 }
 
+/**
+ * Check without a round trip to the server if an idle connection is alive.
+ *
+ * The connection socket is polled for readability with zero timeout. An idle
+ * connection socket should not be readable, otherwise there is pending input like
+ * a server termination message which is consumed via `PQconsumeInput()` and parsed
+ * via `PQisBusy()`, so libpq updates the connection status. A hung up socket means
+ * the connection is closed by the peer.
+ *
+ * @param handle --- native connection handle.
+ * @return true --- connection seems to be alive.
+ * @return false --- connection is broken.
+ */
+template <typename NativeHandle>
+inline bool connection_alive(NativeHandle handle) noexcept {
+    if (connection_status_bad(handle)) {
+        return false;
+    }
+    pollfd fd {PQsocket(handle), POLLIN, 0};
+    if (fd.fd == -1) {
+        return false;
+    }
+    const int rc = ::poll(std::addressof(fd), 1, 0);
+    if (rc <= 0) {
+        return true;
+    }
+    if (fd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        return false;
+    }
+    if (!PQconsumeInput(handle)) {
+        return false;
+    }
+    PQisBusy(handle);
+    return !connection_status_bad(handle);
+}
+
 template <typename NativeHandleType>
 inline auto connection_error_message(NativeHandleType handle) {
     std::string_view v(PQerrorMessage(handle));
@@ -5,16 +5,464 @@
 #include <ozo/asio.h>
 #include <ozo/ext/std/shared_ptr.h>
 #include <ozo/detail/make_copyable.h>
+#include <ozo/detail/bind.h>
+#include <ozo/deadline.h>
 
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/circular_buffer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <list>
+#include <optional>
 
 namespace ozo::detail {
 
+/**
+ * @brief Idle connections of the connection pool
+ *
+ * Keeps handles of idle connections in order of their release and provides
+ * them according to the `ozo::connection_selection` policy. The storage is
+ * preallocated for the pool capacity, so parking and picking a connection
+ * perform no memory allocation.
+ *
+ * Handles of all the expired connections are wasted on each park and pick, so
+ * connections which are never selected by the policy (e.g. the oldest ones with
+ * `ozo::connection_selection::lifo` under a steady load) still expire.
+ *
+ * @tparam Handle --- underlying connection pool handle type.
+ */
+template <typename Handle>
+class idle_connections {
+public:
+    using handle_type = Handle;
+
+    explicit idle_connections(std::size_t capacity) : items_(capacity) {}
+
+    std::size_t size() const noexcept { return items_.size(); }
+
+    bool empty() const noexcept { return items_.empty(); }
+
+    /**
+     * Park the handle of the idle connection.
+     *
+     * @param handle --- handle of the connection.
+     * @param context --- address of the execution context the connection was used with.
+     * @param expires_at --- time point after which the connection should not be provided.
+     * @param now --- current time.
+     * @return true --- the handle is parked.
+     * @return false --- the storage is full, the handle is left untouched.
+     */
+    bool park(handle_type& handle, const void* context, time_traits::time_point expires_at,
+            time_traits::time_point now) {
+        waste_expired(now);
+        if (items_.full()) {
+            return false;
+        }
+        items_.push_back(item{std::move(handle), context, expires_at});
+        return true;
+    }
+
+    /**
+     * Pick the handle of the idle connection. Handles of expired connections
+     * are wasted.
+     *
+     * @param selection --- selection policy.
+     * @param context --- address of the execution context the connection is requested for.
+     * @param now --- current time.
+     * @return std::optional<handle_type> --- handle if there is an alive idle connection.
+     */
+    std::optional<handle_type> pick(connection_selection selection, const void* context,
+            time_traits::time_point now) {
+        waste_expired(now);
+        if (items_.empty()) {
+            return std::nullopt;
+        }
+        const auto i = find(selection, context);
+        auto handle = std::move(i->handle);
+        items_.erase(i);
+        return {std::move(handle)};
+    }
+
+private:
+    struct item {
+        handle_type handle;
+        const void* context;
+        time_traits::time_point expires_at;
+    };
+
+    using items_type = boost::circular_buffer<item>;
+
+    // Expiration time does not follow the release order due to the lifespan limit,
+    // so all the items are checked. Alive items keep their order.
+    void waste_expired(time_traits::time_point now) {
+        auto alive = items_.begin();
+        for (auto i = items_.begin(); i != items_.end(); ++i) {
+            if (i->expires_at <= now) {
+                i->handle.waste();
+            } else {
+                if (alive != i) {
+                    *alive = std::move(*i);
+                }
+                ++alive;
+            }
+        }
+        items_.erase(alive, items_.end());
+    }
+
+    typename items_type::iterator find(connection_selection selection, const void* context) {
+        switch (selection) {
+            case connection_selection::fifo:
+                return items_.begin();
+            case connection_selection::affinity: {
+                const auto i = std::find_if(items_.rbegin(), items_.rend(),
+                    [&] (const item& v) { return v.context == context; });
+                if (i != items_.rend()) {
+                    return std::prev(i.base());
+                }
+                break;
+            }
+            case connection_selection::lifo:
+                break;
+        }
+        return std::prev(items_.end());
+    }
+
+    items_type items_;
+};
+
+/**
+ * @brief Handler of the underlying pool which wraps provided handle into `ozo::detail::pooled_handle`
+ *
+ * Handles of failed requests are not returned to the recycler since they do not hold a pool slot.
+ * The handler is kept by the pool state while the request waits for a connection, so it refers
+ * to the state weakly to let the state be destroyed with the pool.
+ */
+template <typename State, typename Handler>
+struct pooled_handle_handler {
+    using handle_type = typename State::handle_type;
+
+    std::weak_ptr<State> state_;
+    const void* context_;
+    Handler handler_;
+
+    void operator ()(error_code ec, handle_type&& handle) {
+        if (ec) {
+            return handler_(std::move(ec), pooled_handle<handle_type>{std::move(handle), nullptr, context_});
+        }
+        handler_(std::move(ec), pooled_handle<handle_type>{std::move(handle), state_.lock(), context_});
+    }
+
+    using executor_type = decltype(asio::get_associated_executor(handler_));
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = decltype(asio::get_associated_allocator(handler_));
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+/**
+ * @brief Shared state of the connection pool
+ *
+ * Owns the underlying connection pool, idle connections which are provided
+ * according to the selection policy, the queue of requests waiting for a
+ * connection and the cache of memory blocks of pooled connection objects.
+ *
+ * Requests which can not be served immediately wait in the queue ordered by
+ * `ozo::connection_priority` and by arrival within the same priority. A released
+ * connection is passed to the first waiting request directly, a wasted one frees
+ * a slot of the underlying pool for a new connection of the first waiting request.
+ * Without waiting requests handles of released connections are parked here unless
+ * there are requests waiting in the underlying pool queue --- then they are returned
+ * to the underlying pool to serve the queue.
+ *
+ * With `connection_pool_config::deadline_admission` enabled the state keeps an exponentially
+ * weighted moving average of the time connections are used for and rejects requests which
+ * are unlikely to get a connection and complete before their deadlines.
+ *
+ * The state lives while there is the pool or a connection provided by it. Requests which
+ * are still waiting in the queue on the state destruction are completed with the
+ * `boost::asio::error::operation_aborted` error.
+ *
+ * @tparam ConnectionRepType --- connection representation type.
+ * @tparam ThreadSafety --- thread safety of the pool.
+ */
+template <typename ConnectionRepType, typename ThreadSafety>
+class connection_pool_state
+    : public handle_recycler<typename get_connection_pool_impl_t<ConnectionRepType, ThreadSafety>::handle>,
+      public std::enable_shared_from_this<connection_pool_state<ConnectionRepType, ThreadSafety>> {
+public:
+    using impl_type = get_connection_pool_impl_t<ConnectionRepType, ThreadSafety>;
+    using handle_type = typename impl_type::handle;
+    using mutex_type = get_connection_pool_mutex_t<ThreadSafety>;
+    using block_cache_type = block_cache<mutex_type>;
+
+    template <typename Config>
+    explicit connection_pool_state(const Config& config)
+    : impl_(config.capacity, config.queue_capacity, config.idle_timeout, config.lifespan),
+      block_cache_(config.capacity),
+      idle_(config.capacity),
+      capacity_(config.capacity),
+      queue_capacity_(config.queue_capacity),
+      queue_quota_(config.queue_quota),
+      idle_timeout_(config.idle_timeout),
+      lifespan_(config.lifespan),
+      selection_(config.selection),
+      deadline_admission_(config.deadline_admission) {}
+
+    ~connection_pool_state() {
+        for (auto& queue : waiters_) {
+            for (auto& w : queue) {
+                w->queued = false;
+                if (w->timer) {
+                    error_code _;
+                    w->timer->cancel(_);
+                }
+                complete(*w, asio::error::operation_aborted, handle_type{});
+            }
+        }
+    }
+
+    block_cache_type& get_block_cache() noexcept { return block_cache_;}
+
+    /**
+     * Request a connection handle for the execution context.
+     *
+     * @param io --- execution context of the request.
+     * @param at --- deadline of the request.
+     * @param priority --- priority of the request.
+     * @param handler --- handler with `void(error_code, ozo::detail::pooled_handle<handle_type>)` signature.
+     */
+    template <typename Handler>
+    void get(io_context& io, time_traits::time_point at, connection_priority priority, Handler&& handler) {
+        const void* context = std::addressof(io);
+        std::unique_lock<mutex_type> lock(mutex_);
+
+        if (auto handle = idle_.pick(selection_, context, time_traits::now())) {
+            lock.unlock();
+            return asio::post(io, detail::bind(std::forward<Handler>(handler), error_code{},
+                pooled_handle<handle_type>{std::move(*handle), this->shared_from_this(), context}));
+        }
+
+        auto wrapped = pooled_handle_handler<connection_pool_state, std::decay_t<Handler>>{
+            this->weak_from_this(), context, std::forward<Handler>(handler)};
+
+        if (waiters_count_ == 0 && has_room()) {
+            lock.unlock();
+            return impl_.get_auto_recycle(io, std::move(wrapped), queue_timeout(at));
+        }
+
+        if (!can_meet_deadline(priority, at, time_traits::now())) {
+            lock.unlock();
+            return asio::post(io, detail::bind(std::move(wrapped),
+                error_code(yamail::resource_pool::error::get_resource_timeout), handle_type{}));
+        }
+
+        auto& queue = waiters_[index(priority)];
+        if (waiters_count_ >= queue_capacity_ || queue.size() >= queue_quota_[index(priority)]) {
+            lock.unlock();
+            return asio::post(io, detail::bind(std::move(wrapped),
+                error_code(yamail::resource_pool::error::request_queue_overflow), handle_type{}));
+        }
+
+        auto executor = asio::executor(asio::get_associated_executor(wrapped, io.get_executor()));
+        auto w = std::make_shared<waiter>(waiter{
+            std::addressof(io), std::move(executor), std::move(wrapped), at, priority, {}, {}, true});
+        w->pos = queue.insert(queue.end(), w);
+        ++waiters_count_;
+
+        if (at != time_traits::time_point::max()) {
+            w->timer.emplace(io, at);
+            w->timer->async_wait([weak = this->weak_from_this(), w] (error_code ec) {
+                if (ec == asio::error::operation_aborted) {
+                    return;
+                }
+                if (auto self = weak.lock()) {
+                    self->expire(w);
+                }
+            });
+        }
+    }
+
+    void recycle(handle_type&& handle, const void* context, time_traits::duration usage) noexcept override {
+        try {
+            recycle_handle(std::move(handle), context, usage);
+        } catch (const std::exception&) {
+            // There is no one to report the error to since the handle is released by a destructor.
+            // The handle is returned to the underlying pool by its own destructor then.
+        }
+    }
+
+    /**
+     * Get statistics of the underlying pool with the parked idle connections
+     * counted as available and the waiting requests counted as queued.
+     */
+    auto stats() const {
+        const std::lock_guard<mutex_type> lock(mutex_);
+        auto result = impl_.stats();
+        result.available += idle_.size();
+        result.used -= std::min(result.used, idle_.size());
+        result.queue_size += waiters_count_;
+        return result;
+    }
+
+private:
+    void recycle_handle(handle_type&& handle, const void* context, time_traits::duration usage) {
+        auto owned = std::move(handle);
+        const auto now = time_traits::now();
+        std::unique_lock<mutex_type> lock(mutex_);
+
+        if (!owned.empty() && !owned.unusable()) {
+            update_usage_estimate(usage);
+            const auto expires_at = std::min(deadline(idle_timeout_, now), deadline(lifespan_, owned->created_at()));
+            if (expires_at > now) {
+                if (auto w = pop_waiter(now)) {
+                    lock.unlock();
+                    return complete(*w, error_code{}, std::move(owned));
+                }
+                if (impl_.stats().queue_size == 0) {
+                    idle_.park(owned, context, expires_at, now);
+                }
+                return;
+            }
+            lock.unlock();
+            owned.waste();
+            lock.lock();
+        } else if (!owned.unusable()) {
+            lock.unlock();
+            owned = handle_type{};
+            lock.lock();
+        }
+
+        // The handle does not hold a slot of the underlying pool anymore,
+        // so the first waiting request may get a new connection.
+        if (auto w = pop_waiter(now)) {
+            lock.unlock();
+            impl_.get_auto_recycle(*w->io, asio::bind_executor(w->executor, std::exchange(w->handler, waiter_handler{})),
+                queue_timeout(w->deadline));
+        }
+    }
+
+    struct waiter;
+
+    using waiter_ptr = std::shared_ptr<waiter>;
+    using waiters_queue = std::list<waiter_ptr>;
+    using waiter_handler = std::function<void(error_code, handle_type&&)>;
+
+    struct waiter {
+        io_context* io;
+        asio::executor executor;
+        waiter_handler handler;
+        time_traits::time_point deadline;
+        connection_priority priority;
+        std::optional<asio::steady_timer> timer;
+        typename waiters_queue::iterator pos;
+        bool queued = true;
+    };
+
+    static constexpr std::size_t index(connection_priority priority) noexcept {
+        return static_cast<std::size_t>(priority);
+    }
+
+    static time_traits::duration queue_timeout(time_traits::time_point at) {
+        return at == time_traits::time_point::max() ? time_traits::duration(0) : time_left(at);
+    }
+
+    bool has_room() const {
+        const auto stats = impl_.stats();
+        return stats.available > 0 || stats.size < capacity_;
+    }
+
+    waiter_ptr pop_waiter(time_traits::time_point now) {
+        for (auto i = waiters_.rbegin(); i != waiters_.rend(); ++i) {
+            while (!i->empty()) {
+                auto w = std::move(i->front());
+                i->pop_front();
+                --waiters_count_;
+                w->queued = false;
+                if (w->timer) {
+                    error_code _;
+                    w->timer->cancel(_);
+                }
+                if (deadline_admission_ && usage_estimate_.count() && time_left(w->deadline, now) < usage_estimate_) {
+                    complete(*w, yamail::resource_pool::error::get_resource_timeout, handle_type{});
+                    continue;
+                }
+                return w;
+            }
+        }
+        return {};
+    }
+
+    void update_usage_estimate(time_traits::duration usage) noexcept {
+        if (usage_estimate_.count() == 0) {
+            usage_estimate_ = usage;
+        } else {
+            usage_estimate_ += (usage - usage_estimate_) / 8;
+        }
+    }
+
+    // The request is expected to wait for the connections used by the requests of the same or
+    // higher priority queued before it, and then to use its own connection for the estimated time.
+    bool can_meet_deadline(connection_priority priority, time_traits::time_point at,
+            time_traits::time_point now) const noexcept {
+        if (!deadline_admission_ || usage_estimate_.count() == 0 || at == time_traits::time_point::max()) {
+            return true;
+        }
+        std::size_t ahead = 1;
+        for (auto i = index(priority); i < waiters_.size(); ++i) {
+            ahead += waiters_[i].size();
+        }
+        const auto wait = usage_estimate_ * ahead / std::max<std::size_t>(capacity_, 1);
+        return time_left(at, now) >= wait + usage_estimate_;
+    }
+
+    void expire(const waiter_ptr& w) {
+        std::unique_lock<mutex_type> lock(mutex_);
+        if (!w->queued) {
+            return;
+        }
+        waiters_[index(w->priority)].erase(w->pos);
+        --waiters_count_;
+        w->queued = false;
+        lock.unlock();
+        complete(*w, yamail::resource_pool::error::get_resource_timeout, handle_type{});
+    }
+
+    static void complete(waiter& w, error_code ec, handle_type&& handle) {
+        asio::post(*w.io, asio::bind_executor(w.executor,
+            detail::bind(std::exchange(w.handler, waiter_handler{}), std::move(ec), std::move(handle))));
+    }
+
+    mutable mutex_type mutex_;
+    impl_type impl_;
+    block_cache_type block_cache_;
+    idle_connections<handle_type> idle_;
+    std::array<waiters_queue, connection_priorities_count> waiters_;
+    std::size_t waiters_count_ = 0;
+    std::size_t capacity_;
+    std::size_t queue_capacity_;
+    connection_queue_quota queue_quota_;
+    time_traits::duration idle_timeout_;
+    time_traits::duration lifespan_;
+    connection_selection selection_;
+    bool deadline_admission_;
+    time_traits::duration usage_estimate_ {0};
+};
+
 template <typename Allocator, typename Executor, typename Rep>
 auto create_pooled_connection(const Allocator& alloc, const Executor& ex, Rep&& rep) {
     return std::allocate_shared<pooled_connection<std::decay_t<Rep>, Executor>>(alloc, ex, std::forward<Rep>(rep));
 }
 
-template <typename Source, typename Handler, typename TimeConstraint>
+template <typename Source, typename Handler, typename TimeConstraint, typename Allocator>
 struct pooled_connection_wrapper {
     using connection_ptr = typename connection_pool<Source>::connection_type;
     using connection = typename connection_ptr::element_type;
@@ -24,10 +472,12 @@ struct pooled_connection_wrapper {
     Source source_;
     detail::make_copyable_t<Handler> handler_;
     TimeConstraint time_constrain_;
+    Allocator connection_allocator_;
 
     struct wrapper {
         Handler handler_;
         handle_type handle_;
+        Allocator connection_allocator_;
 
         template <typename Conn>
         void operator () (error_code ec, Conn&& conn) {
@@ -36,9 +486,10 @@ struct pooled_connection_wrapper {
             if (!is_null(conn)) {
                 auto& target = ozo::unwrap_connection(conn);
 
-                handle_.reset({target.release(), target.oid_map(), target.get_error_context()});
+                using statistics = get_pooled_statistics<std::decay_t<decltype(target)>>;
+                handle_.reset({target.release(), target.oid_map(), target.get_error_context(), statistics::apply(target)});
                 auto res = create_pooled_connection(
-                    get_allocator(), target.get_executor(), std::move(handle_)
+                    connection_allocator_, target.get_executor(), std::move(handle_)
                 );
 
                 handler_(std::move(ec), std::move(res));
@@ -65,12 +516,13 @@ struct pooled_connection_wrapper {
             return handler_(std::move(ec), connection_ptr{});
         }
 
-        if (!handle.empty() && !connection_status_bad(handle->safe_native_handle().get())) {
-            auto conn = create_pooled_connection(get_allocator(), io_executor_, std::move(handle));
+        if (!handle.empty() && connection_alive(handle->safe_native_handle().get())) {
+            auto conn = create_pooled_connection(connection_allocator_, io_executor_, std::move(handle));
             return handler_(std::move(ec), std::move(conn));
         }
 
-        source_(io_executor_.context(), time_constrain_, wrapper{std::move(handler_), std::move(handle)});
+        source_(io_executor_.context(), time_constrain_,
+            wrapper{std::move(handler_), std::move(handle), connection_allocator_});
     }
 
     using executor_type = decltype(asio::get_associated_executor(handler_));
@@ -86,15 +538,22 @@ struct pooled_connection_wrapper {
     }
 };
 
-template <typename Source, typename Executor, typename TimeConstraint, typename Handler>
-auto wrap_pooled_connection_handler(const Executor& ex, Source&& source, TimeConstraint t, Handler&& handler) {
+template <typename Source, typename Executor, typename TimeConstraint, typename Handler, typename Allocator>
+auto wrap_pooled_connection_handler(const Executor& ex, Source&& source, TimeConstraint t, Handler&& handler,
+        const Allocator& connection_allocator) {
     static_assert(ConnectionSource<Source>, "is not a ConnectionSource");
 
-    return pooled_connection_wrapper<std::decay_t<Source>, std::decay_t<Handler>, TimeConstraint> {
-        ex, std::forward<Source>(source), std::forward<Handler>(handler), t
+    return pooled_connection_wrapper<std::decay_t<Source>, std::decay_t<Handler>, TimeConstraint, Allocator> {
+        ex, std::forward<Source>(source), std::forward<Handler>(handler), t, connection_allocator
     };
 }
 
+template <typename Source, typename Executor, typename TimeConstraint, typename Handler>
+auto wrap_pooled_connection_handler(const Executor& ex, Source&& source, TimeConstraint t, Handler&& handler) {
+    auto allocator = asio::get_associated_allocator(handler);
+    return wrap_pooled_connection_handler(ex, std::forward<Source>(source), t, std::forward<Handler>(handler), allocator);
+}
+
 } // namespace ozo::detail
 
 namespace ozo {
@@ -107,28 +566,38 @@ struct unwrap_impl<yamail::resource_pool::handle<V>> {
     }
 };
 
+template <typename H>
+struct unwrap_impl<detail::pooled_handle<H>> {
+    template <typename T>
+    static constexpr decltype(auto) apply(T&& handle) {
+        return *handle;
+    }
+};
+
 template <typename Source, typename ThreadSafety>
 template <typename TimeConstraint, typename Handler>
-void connection_pool<Source, ThreadSafety>::operator ()(io_context& io, TimeConstraint t, Handler&& handler) {
+void connection_pool<Source, ThreadSafety>::operator ()(io_context& io, TimeConstraint t,
+        connection_priority priority, Handler&& handler) {
     static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
-    impl_.get_auto_recycle(
-        io,
+    using block_cache_type = typename state_type::block_cache_type;
+
+    state_->get(io, queue_deadline(t), priority,
         detail::wrap_pooled_connection_handler(
             io.get_executor(),
             source_,
             t,
-            std::forward<Handler>(handler)
-        ),
-        queue_timeout(t)
+            std::forward<Handler>(handler),
+            detail::cached_allocator<void, block_cache_type>{
+                std::shared_ptr<block_cache_type>(state_, std::addressof(state_->get_block_cache()))
+            }
+        )
     );
 }
 
 template <typename Rep, typename Executor>
 pooled_connection<Rep, Executor>::pooled_connection(const Executor& ex, Rep&& rep)
-: rep_(std::move(rep)), ex_(ex), stream_(get_executor().context()) {
-    if (auto fd = PQsocket(native_handle()); fd != -1) {
-        stream_.assign(fd);
-    }
+: rep_(std::move(rep)), ex_(ex) {
+    stream();
 }
 
 template <typename Rep, typename Executor>
@@ -143,26 +612,25 @@ pooled_connection<Rep, Executor>::native_handle() const noexcept {
 template <typename Rep, typename Executor>
 template <typename WaitHandler>
 void pooled_connection<Rep, Executor>::async_wait_write(WaitHandler&& h) {
-    stream_.async_write_some(asio::null_buffers(), std::forward<WaitHandler>(h));
+    stream().async_write_some(asio::null_buffers(), std::forward<WaitHandler>(h));
 }
 
 template <typename Rep, typename Executor>
 template <typename WaitHandler>
 void pooled_connection<Rep, Executor>::async_wait_read(WaitHandler&& h) {
-    stream_.async_read_some(asio::null_buffers(), std::forward<WaitHandler>(h));
+    stream().async_read_some(asio::null_buffers(), std::forward<WaitHandler>(h));
 }
 
 template <typename Rep, typename Executor>
 error_code pooled_connection<Rep, Executor>::close() noexcept {
-    stream_.release();
+    ozo::unwrap(rep_).release_stream();
     ozo::unwrap(rep_).safe_native_handle().reset();
     return error_code{};
 }
 
 template <typename Rep, typename Executor>
 void pooled_connection<Rep, Executor>::cancel() noexcept {
-    error_code _;
-    stream_.cancel(_);
+    ozo::unwrap(rep_).cancel_stream();
 }
 
 template <typename Rep, typename Executor>
@@ -172,7 +640,6 @@ bool pooled_connection<Rep, Executor>::is_bad() const noexcept {
 
 template <typename Rep, typename Executor>
 pooled_connection<Rep, Executor>::~pooled_connection() {
-    stream_.release();
     if (!rep_.empty() && (is_bad() || get_transaction_status(*this) != transaction_status::idle)) {
         rep_.waste();
     }
@@ -51,6 +51,16 @@ inline int connect_poll(T& conn) {
 template <typename T>
 inline int send_query_params(T& conn, const binary_query& q) noexcept {
     static_assert(Connection<T>, "T must be a Connection");
+    if (q.is_prepared()) {
+        return PQsendQueryPrepared(get_native_handle(conn),
+                    q.text(),
+                    q.params_count(),
+                    q.values(),
+                    q.lengths(),
+                    q.formats(),
+                    int(result_format::binary)
+                );
+    }
     return PQsendQueryParams(get_native_handle(conn),
                 q.text(),
                 q.params_count(),
@@ -62,6 +72,26 @@ inline int send_query_params(T& conn, const binary_query& q) noexcept {
             );
 }
 
+#ifdef LIBPQ_HAS_PIPELINING
+template <typename T>
+inline bool enter_pipeline_mode(T& conn) noexcept {
+    static_assert(Connection<T>, "T must be a Connection");
+    return PQenterPipelineMode(get_native_handle(conn));
+}
+
+template <typename T>
+inline bool pipeline_sync(T& conn) noexcept {
+    static_assert(Connection<T>, "T must be a Connection");
+    return PQpipelineSync(get_native_handle(conn));
+}
+
+template <typename T>
+inline bool exit_pipeline_mode(T& conn) noexcept {
+    static_assert(Connection<T>, "T must be a Connection");
+    return PQexitPipelineMode(get_native_handle(conn));
+}
+#endif
+
 template <typename T>
 inline error_code set_nonblocking(T& conn) noexcept {
     static_assert(Connection<T>, "T must be a Connection");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ozo/impl/async_request.h>
+#include <ozo/oid_map_cache.h>
 #include <ozo/time_traits.h>
 
 namespace ozo::impl {
@@ -78,6 +79,7 @@ struct request_oid_map_op {
     void operator() (error_code ec, Connection&& conn) {
         if (!ec) try {
             set_oid_map(ozo::unwrap_connection(conn).oid_map(), ctx_->res_);
+            oid_map_cache::instance().put(oid_map_cache_key(conn), ozo::unwrap_connection(conn).oid_map());
         } catch (const std::exception& e) {
             unwrap_connection(conn).set_error_context(e.what());
             ec = error::oid_request_failed;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ozo/connection.h>
+#include <ozo/error.h>
+#include <ozo/impl/result.h>
+#include <ozo/io/binary_query.h>
+#include <ozo/statistics.h>
+
+#include <cstring>
+
+namespace ozo::impl {
+
+template <typename Connection, typename Key, typename Value, typename = std::void_t<>>
+struct has_request_statistics : std::false_type {};
+
+template <typename Connection, typename Key, typename Value>
+struct has_request_statistics<Connection, Key, Value, std::void_t<decltype(
+    unwrap_connection(std::declval<Connection&>()).statistics()
+)>> : detail::has_statistics_update<
+    std::remove_reference_t<decltype(unwrap_connection(std::declval<Connection&>()).statistics())>, Key, Value> {};
+
+/**
+ * Timing points are measured only if the connection statistics accept them, so there is
+ * no clock reading for connections without statistics.
+ */
+template <typename Connection>
+constexpr bool collects_request_timings = has_request_statistics<Connection, request_phase, time_traits::duration>::value;
+
+template <typename Connection, typename Key, typename Value>
+inline void update_request_statistics([[maybe_unused]] Connection& conn, [[maybe_unused]] const Key& key,
+        [[maybe_unused]] Value value) noexcept {
+    if constexpr (has_request_statistics<Connection, Key, Value>::value) {
+        ozo::update_statistics(unwrap_connection(conn).statistics(), key, std::move(value));
+    }
+}
+
+inline request_error_category get_request_error_category(const error_code& ec) noexcept {
+    if (ec == asio::error::operation_aborted || ec == asio::error::timed_out) {
+        return request_error_category::timeout;
+    }
+    if (ec == errc::connection_error) {
+        return request_error_category::connection;
+    }
+    if (ec.category() == sqlstate::category()) {
+        return request_error_category::sql;
+    }
+    if (ec == errc::introspection_error || ec == errc::type_mismatch || ec == errc::protocol_error) {
+        return request_error_category::result;
+    }
+    return request_error_category::other;
+}
+
+/**
+ * Number of bytes of the query text and parameters which are sent to the server.
+ */
+inline std::uint64_t get_query_size(const binary_query& query) noexcept {
+    std::uint64_t size = std::strlen(query.text());
+    for (std::ptrdiff_t i = 0; i < query.params_count(); ++i) {
+        size += static_cast<std::uint64_t>(query.lengths()[i]);
+    }
+    return size;
+}
+
+/**
+ * Number of bytes of the result values which are received from the server.
+ */
+template <typename T>
+inline std::uint64_t get_result_size(const T& res) noexcept {
+    std::uint64_t size = 0;
+    const int rows = ntuples(res);
+    const int fields = nfields(res);
+    for (int row = 0; row < rows; ++row) {
+        for (int field = 0; field < fields; ++field) {
+            size += get_length(res, row, field);
+        }
+    }
+    return size;
+}
+
+} // namespace ozo::impl
@@ -37,26 +37,66 @@ static_assert(std::is_same_v<
 
 namespace detail {
 
+template <typename T>
+struct transaction_nesting_level : std::integral_constant<std::size_t, 0> {};
+
+template <typename Connection, typename Options>
+struct transaction_nesting_level<transaction<Connection, Options>>
+    : std::integral_constant<std::size_t, transaction_nesting_level<Connection>::value + 1> {};
+
+/**
+ * Name of the savepoint of a transaction nested into the `Outer` transaction. Savepoints of
+ * transactions on the same nesting level have the same name since they can not coexist.
+ */
+template <typename Outer>
+inline std::string savepoint_name() {
+    return "ozo_savepoint_" + std::to_string(transaction_nesting_level<Outer>::value);
+}
+
 template <typename Handler, typename Options>
 struct async_start_transaction_op {
     Handler handler;
     Options options;
+    std::string deferred_begin {};
 
     template <typename T, typename Query, typename TimeConstraint>
     void perform(T&& provider, Query&& query, TimeConstraint t) {
         static_assert(ConnectionProvider<T>, "T is not a ConnectionProvider");
         static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
-        async_execute(std::forward<T>(provider), std::forward<Query>(query),
-            t, std::move(*this));
+        if constexpr (is_transaction<std::decay_t<T>>::value) {
+            static_assert(!std::is_lvalue_reference_v<T>, "outer transaction should be moved into the nested one");
+            // SAVEPOINT is sent in front of the next request on the nested transaction
+            return async_get_connection(std::forward<T>(provider), deadline(t), std::move(*this));
+        } else {
+            if (get_option(options, transaction_options::pipelined, false)) {
+                // BEGIN is sent in front of the first request on the transaction
+                const std::decay_t<decltype(get_query_text(query))> text = get_query_text(query);
+                deferred_begin = to_const_char(text);
+                return async_get_connection(std::forward<T>(provider), deadline(t), std::move(*this));
+            }
+            async_execute(std::forward<T>(provider), std::forward<Query>(query),
+                t, std::move(*this));
+        }
     }
 
     template <typename Connection>
     void operator ()(error_code ec, Connection&& connection) {
+        std::vector<std::string> statements;
+        if constexpr (is_transaction<std::decay_t<Connection>>::value) {
+            statements = take_deferred_statements(connection);
+            statements.push_back("SAVEPOINT " + savepoint_name<std::decay_t<Connection>>());
+        } else if (!ec && !deferred_begin.empty()) {
+            statements.push_back(std::move(deferred_begin));
+        }
+        ozo::transaction transaction(std::forward<Connection>(connection), std::move(options));
+        for (auto& statement : statements) {
+            transaction.defer_statement(std::move(statement));
+        }
         asio::dispatch(
             detail::bind(
                 std::move(handler),
                 std::move(ec),
-                ozo::transaction(std::forward<Connection>(connection), std::move(options))
+                std::move(transaction)
             )
         );
     }
@@ -93,6 +133,10 @@ struct async_end_transaction_op {
 
     template <typename Connection, typename Options>
     void operator ()(error_code ec, transaction<Connection, Options> transaction) {
+        if (ec == error::bad_result_process) {
+            // Only the last request output of `ozo::commit()` may fail after the COMMIT statement
+            ec = error::bad_result_process_after_commit;
+        }
         asio::dispatch(
             detail::bind(
                 std::move(handler),
@@ -115,10 +159,108 @@ Require<ConnectionProvider<T>> async_end_transaction(T&& provider, Query&& query
         .perform(std::forward<T>(provider), std::forward<Query>(query), t);
 }
 
+/**
+ * Nested transaction end operation. Statements which end the savepoint are deferred to the next
+ * request on the outer transaction, so the operation performs no I/O. If the savepoint has not been
+ * sent yet, i.e. there were no requests on the nested transaction, no statements are needed at all.
+ * If the operation has been completed with an error, the savepoint is rolled back.
+ */
+template <typename Handler>
+struct async_end_nested_transaction_op {
+    enum class savepoint_action {
+        release, //!< RELEASE the savepoint
+        rollback, //!< ROLLBACK TO and RELEASE the savepoint
+        none, //!< the savepoint has been released already by the last request
+    };
+
+    Handler handler;
+    savepoint_action action;
+
+    template <typename Connection, typename Options>
+    void operator ()(error_code ec, transaction<Connection, Options> nested) {
+        // The savepoint of the last request has been released already, only its output has failed
+        const bool released = action == savepoint_action::none && ec == error::bad_result_process;
+        if (released) {
+            ec = error::bad_result_process_after_commit;
+        }
+        const auto name = savepoint_name<Connection>();
+        auto statements = take_deferred_statements(nested);
+        auto outer = release_connection(std::move(nested));
+        const bool savepoint_sent = statements.empty() || statements.back() != "SAVEPOINT " + name;
+        if (!savepoint_sent) {
+            statements.pop_back();
+        }
+        for (auto& statement : statements) {
+            outer.defer_statement(std::move(statement));
+        }
+        if (savepoint_sent && !released) {
+            if (ec || action == savepoint_action::rollback) {
+                outer.defer_statement("ROLLBACK TO SAVEPOINT " + name);
+            }
+            if (ec || action != savepoint_action::none) {
+                outer.defer_statement("RELEASE SAVEPOINT " + name);
+            }
+        }
+        asio::dispatch(
+            detail::bind(
+                std::move(handler),
+                std::move(ec),
+                std::move(outer)
+            )
+        );
+    }
+};
+
+template <typename Handler, typename Action>
+auto make_async_end_nested_transaction_op(Handler&& handler, Action action) {
+    return async_end_nested_transaction_op<std::decay_t<Handler>> {std::forward<Handler>(handler), action};
+}
+
+template <typename T, typename Handler>
+void async_end_nested_transaction(T&& nested, bool commit, Handler&& handler) {
+    static_assert(is_transaction<std::decay_t<T>>::value, "T is not a transaction");
+    using action = typename async_end_nested_transaction_op<std::decay_t<Handler>>::savepoint_action;
+    make_async_end_nested_transaction_op(std::forward<Handler>(handler), commit ? action::release : action::rollback)
+        (error_code {}, std::forward<T>(nested));
+}
+
+template <typename T, typename TimeConstraint, typename LastQuery, typename Out, typename Handler>
+Require<ConnectionProvider<T>> async_end_transaction(T&& provider, TimeConstraint t,
+        LastQuery&& last_query, Out&& out, Handler&& handler) {
+    static_assert(Connection<T>, "T is not a Connection");
+    static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+    using handle_type = typename std::decay_t<T>::handle_type;
+    if constexpr (is_transaction<handle_type>::value) {
+        // The savepoint is released with the last query. In case of an error it is rolled back
+        // by the end operation, so the outer transaction may be continued.
+        async_get_connection(std::forward<T>(provider), deadline(t), ozo::impl::async_request_op{
+            std::forward<LastQuery>(last_query),
+            deadline(t),
+            ozo::impl::async_request_out_handler{std::forward<Out>(out)},
+            make_async_end_nested_transaction_op(std::forward<Handler>(handler),
+                async_end_nested_transaction_op<std::decay_t<Handler>>::savepoint_action::none),
+            "RELEASE SAVEPOINT " + savepoint_name<handle_type>()
+        });
+    } else {
+        async_get_connection(std::forward<T>(provider), deadline(t), ozo::impl::async_request_op{
+            std::forward<LastQuery>(last_query),
+            deadline(t),
+            ozo::impl::async_request_out_handler{std::forward<Out>(out)},
+            make_async_end_transaction_op(std::forward<Handler>(handler)),
+            std::string("COMMIT")
+        });
+    }
+}
+
 template <typename Handler, typename ...Args>
 constexpr void initiate_async_end_transaction::operator()(Handler&& h, Args&& ...args) const {
     async_end_transaction(std::forward<Args>(args)..., std::forward<Handler>(h));
 }
 
+template <typename Handler, typename ...Args>
+constexpr void initiate_async_end_nested_transaction::operator()(Handler&& h, Args&& ...args) const {
+    async_end_nested_transaction(std::forward<Args>(args)..., std::forward<Handler>(h));
+}
+
 } // namespace detail
 } // namespace ozo
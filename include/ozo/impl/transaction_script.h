@@ -0,0 +1,166 @@
+#pragma once
+
+#include <ozo/impl/async_execute.h>
+#include <ozo/impl/async_request.h>
+#include <ozo/transaction.h>
+#include <ozo/transaction_status.h>
+
+#include <tuple>
+
+namespace ozo::impl {
+
+/**
+ * Result processor of the transaction script: passes the result of each script query to the
+ * corresponding output. The first statement of the script is `BEGIN` and the last one is
+ * `COMMIT`, their results are ignored as well as results of queries with `ozo::none` output.
+ */
+template <typename Outs>
+struct transaction_script_processor {
+    Outs outs;
+
+    template <typename Result, typename Conn>
+    void operator() (std::size_t i, Result&& res, Conn& conn) {
+        std::size_t index = 0;
+        std::apply([&] (auto& ...out) {
+            (receive(++index == i, out, res, conn), ...);
+        }, outs);
+    }
+
+    template <typename Out, typename Result, typename Conn>
+    static void receive(bool matches, Out& out, Result& res, Conn& conn) {
+        if constexpr (!IsNone<Out>) {
+            if (matches) {
+                auto result = ozo::make_result(std::move(res));
+                ozo::recv_result(result, ozo::unwrap_connection(conn).oid_map(), out);
+            }
+        }
+    }
+};
+
+template <typename Outs>
+transaction_script_processor(Outs) -> transaction_script_processor<Outs>;
+
+/**
+ * Completion of the transaction script. If the script has failed within the transaction, the
+ * `COMMIT` statement is aborted and the transaction is rolled back here within the rest of the
+ * script time constraint, so the connection may be reused. The handler receives the error of
+ * the script anyway.
+ *
+ * A failed output conversion does not abort the script, so `ozo::error::bad_result_process`
+ * means the transaction has been committed. It is reported as `ozo::error::bad_result_process_after_commit`.
+ */
+template <typename Handler, typename TimeConstraint>
+struct async_transaction_script_rollback_op {
+    Handler handler_;
+    TimeConstraint time_constraint_;
+    error_code ec_ {};
+    std::string error_context_ {};
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection conn) {
+        if (ec_) {
+            // The error of the script is reported instead of the rollback result
+            unwrap_connection(conn).set_error_context(std::move(error_context_));
+            return handler_(std::move(ec_), std::move(conn));
+        }
+        if (ec == error::bad_result_process) {
+            return handler_(error_code{error::bad_result_process_after_commit}, std::move(conn));
+        }
+        if (ec) {
+            const auto status = get_transaction_status(conn);
+            if (status == transaction_status::transaction || status == transaction_status::error) {
+                ec_ = std::move(ec);
+                error_context_ = std::string(get_error_context(conn));
+                return async_execute(std::move(conn), make_query(std::string("ROLLBACK")), time_constraint_,
+                    std::move(*this));
+            }
+        }
+        handler_(std::move(ec), std::move(conn));
+    }
+
+    using executor_type = std::decay_t<decltype(asio::get_associated_executor(handler_))>;
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = std::decay_t<decltype(asio::get_associated_allocator(handler_))>;
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+template <typename Handler, typename TimeConstraint>
+async_transaction_script_rollback_op(Handler, TimeConstraint) -> async_transaction_script_rollback_op<Handler, TimeConstraint>;
+
+template <typename BeginQuery, typename Queries, typename TimeConstraint, typename Outs, typename Handler>
+struct async_transaction_script_op {
+    BeginQuery begin_;
+    Queries queries_;
+    TimeConstraint time_constraint_;
+    Outs outs_;
+    Handler handler_;
+
+    template <typename Connection>
+    void operator() (error_code ec, Connection conn) {
+        if (ec) {
+            return handler_(ec, std::move(conn));
+        }
+
+        auto handler = wrap_request_handler(conn, time_constraint_,
+            async_transaction_script_rollback_op{std::move(handler_), time_constraint_});
+        auto ctx = make_request_operation_context(std::move(conn), std::move(handler));
+        start_request_statistics(ctx);
+
+        const auto& oid_map = get_connection(ctx).oid_map();
+        const auto allocator = asio::get_associated_allocator(get_handler(ctx));
+        std::vector<binary_query> statements;
+        statements.reserve(std::tuple_size_v<Queries> + 2);
+        statements.push_back(to_binary_query(std::move(begin_), oid_map, allocator));
+        std::apply([&] (auto& ...query) {
+            (statements.push_back(to_binary_query(std::move(query), oid_map, allocator)), ...);
+        }, queries_);
+        statements.push_back(to_binary_query(make_query(std::string("COMMIT")), oid_map, allocator));
+
+        async_pipeline(std::move(ctx), std::move(statements), transaction_script_processor{std::move(outs_)});
+    }
+
+    using executor_type = std::decay_t<decltype(asio::get_associated_executor(handler_))>;
+
+    executor_type get_executor() const noexcept {
+        return asio::get_associated_executor(handler_);
+    }
+
+    using allocator_type = std::decay_t<decltype(asio::get_associated_allocator(handler_))>;
+
+    allocator_type get_allocator() const noexcept {
+        return asio::get_associated_allocator(handler_);
+    }
+};
+
+template <typename BeginQuery, typename Queries, typename TimeConstraint, typename Outs, typename Handler>
+async_transaction_script_op(BeginQuery, Queries, TimeConstraint, Outs, Handler)
+    -> async_transaction_script_op<BeginQuery, Queries, TimeConstraint, Outs, Handler>;
+
+template <typename P, typename BeginQuery, typename Queries, typename TimeConstraint, typename Outs, typename Handler>
+inline void async_transaction_script(P&& provider, BeginQuery&& begin, Queries&& queries,
+        TimeConstraint t, Outs&& outs, Handler&& handler) {
+    static_assert(ConnectionProvider<P>, "is not a ConnectionProvider");
+    static_assert(!is_transaction<std::decay_t<P>>::value,
+        "transaction script starts a transaction itself and can not be executed on a transaction");
+    static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+    static_assert(std::tuple_size_v<std::decay_t<Queries>> == std::tuple_size_v<std::decay_t<Outs>>,
+        "each query of the script should have an output, use ozo::none for queries without output");
+    async_get_connection(std::forward<P>(provider), deadline(t),
+        async_transaction_script_op{
+            std::forward<BeginQuery>(begin),
+            std::forward<Queries>(queries),
+            deadline(t),
+            std::forward<Outs>(outs),
+            std::forward<Handler>(handler)
+        }
+    );
+}
+
+} // namespace ozo::impl
@@ -11,6 +11,7 @@
 #include <ozo/optional.h>
 #include <ozo/pg/types.h>
 
+#include <boost/hana/equal.hpp>
 #include <boost/hana/for_each.hpp>
 #include <boost/hana/tuple.hpp>
 #include <boost/hana/ext/std/array.hpp>
@@ -20,7 +21,10 @@
 #include <array>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string_view>
+#include <typeinfo>
 #include <vector>
 
 namespace ozo {
@@ -51,6 +55,20 @@ public:
         allocator, std::move(text), params, oid_map, allocator
     )} {}
 
+    /**
+     * Construct a new binary query object from data which is prepared by a query
+     * representation itself, e.g. `ozo::dynamic_query`. The data is shared, not copied.
+     *
+     * @param data --- query data object with members `text()`, `types()`, `formats()`,
+     *                 `lengths()`, `values()`, `params_count()` and `is_prepared()` of the
+     *                 same signatures as the `binary_query` ones.
+     * @param allocator --- allocator object which should be used to allocate internal data,
+     *                      default is `std::allocator<char>`.
+     */
+    template <class Data, class Allocator = std::allocator<char>>
+    explicit binary_query(std::shared_ptr<const Data> data, const Allocator& allocator = Allocator{})
+    : impl{std::allocate_shared<shared_impl_type<Data>>(allocator, std::move(data))} {}
+
     /**
      * Get raw query text buffer.
      *
@@ -106,6 +124,15 @@ public:
         return impl->params_count();
     }
 
+    /**
+     * Indicates that the query text is a name of a prepared statement, see `ozo::prepared_statement`.
+     *
+     * @return `true` --- the query should be executed as a prepared statement.
+     */
+    bool is_prepared() const noexcept {
+        return impl->is_prepared();
+    }
+
 private:
     static constexpr auto binary_format = 1;
 
@@ -116,6 +143,7 @@ private:
         virtual const int* lengths() const noexcept = 0;
         virtual const char* const* values() const noexcept = 0;
         virtual std::ptrdiff_t params_count() const noexcept = 0;
+        virtual bool is_prepared() const noexcept = 0;
         virtual ~interface() = default;
     };
 
@@ -135,10 +163,12 @@ private:
         using params_type = Params;
 
         static constexpr auto params_count_ = decltype(hana::length(std::declval<params_type>()))::value;
+        // OIDs of built-in types are known at compile time, so they are not copied per query
+        using static_types = ozo::static_type_oids<params_type>;
 
         text_type text_;
         buffer_type buffer_;
-        std::array<oid_t, params_count_> types_;
+        std::array<oid_t, static_types::value ? 0 : params_count_> types_;
         std::array<int, params_count_> formats_;
         std::array<int, params_count_> lengths_;
         std::array<const char*, params_count_> values_;
@@ -152,7 +182,9 @@ private:
 
             hana::for_each(range, [&] (auto i) {
                 lengths_[i] = std::max(0, size_of(params[i]));
-                types_[i] = type_oid(oid_map, params[i]);
+                if constexpr (!static_types::value) {
+                    types_[i] = type_oid(oid_map, params[i]);
+                }
             });
 
             buffer_.reserve(hana::unpack(lengths_, [](auto ...x) {return (x + ... + 0);}));
@@ -176,7 +208,11 @@ private:
         }
 
         const oid_t* types() const noexcept override {
-            return std::data(types_);
+            if constexpr (static_types::value) {
+                return std::data(static_types::oids);
+            } else {
+                return std::data(types_);
+            }
         }
 
         const int* formats() const noexcept override {
@@ -194,6 +230,25 @@ private:
         std::ptrdiff_t params_count() const noexcept override {
             return params_count_;
         }
+
+        bool is_prepared() const noexcept override {
+            return is_prepared_statement<text_type>::value;
+        }
+    };
+
+    template <class Data>
+    struct shared_impl_type final : interface {
+        std::shared_ptr<const Data> data_;
+
+        shared_impl_type(std::shared_ptr<const Data> data) : data_(std::move(data)) {}
+
+        const char* text() const noexcept override { return data_->text(); }
+        const oid_t* types() const noexcept override { return data_->types(); }
+        const int* formats() const noexcept override { return data_->formats(); }
+        const int* lengths() const noexcept override { return data_->lengths(); }
+        const char* const* values() const noexcept override { return data_->values(); }
+        std::ptrdiff_t params_count() const noexcept override { return data_->params_count(); }
+        bool is_prepared() const noexcept override { return data_->is_prepared(); }
     };
 
     std::shared_ptr<const interface> impl;
@@ -212,7 +267,7 @@ struct to_binary_query_impl : detail::no_binary_query_conversion {
 };
 
 template <typename T>
-using is_binary_query_convertible = typename std::negation<typename std::is_base_of<detail::no_binary_query_conversion, T>::type>::type;
+using is_binary_query_convertible = typename std::negation<typename std::is_base_of<detail::no_binary_query_conversion, to_binary_query_impl<T>>::type>::type;
 
 template <typename T>
 inline constexpr auto is_binary_query_convertible_v = is_binary_query_convertible<T>::value;
@@ -299,8 +354,8 @@ struct to_binary_query_impl<binary_query> {
  * This function provides an ability to convert a query object to the protocol compatible
  * binary representation to send it to the PostgreSQL database. A user may call this
  * function to reuse the `binary_query` and eliminate unnecessarily conversion of the
- * query object to its binary representation each operation. E.g., this may be useful
- * with the `failover` micro-framework.
+ * query object to its binary representation each operation. The `failover` micro-framework
+ * does it automatically for the tries of an operation, see `ozo::cached_binary_query`.
  *
  * @param query     --- a query object to convert to the binary representation.
  * @param oid_map   --- `OidMap` to type OIDs for the binary representation.
@@ -316,4 +371,144 @@ inline binary_query to_binary_query(const BinaryQueryConvertible& query,
     return to_binary_query_impl<BinaryQueryConvertible>::apply(query, oid_map, allocator);
 }
 
+/**
+ * @brief Query which is converted to the binary representation once
+ *
+ * `BinaryQueryConvertible` wrapper which keeps the result of the first conversion
+ * of the query and returns it for the next conversions with an equal `OidMap`.
+ * So operation attempts which are performed via connections with the same types
+ * OIDs send the same immutable `ozo::binary_query` buffer instead of serializing the
+ * query parameters again. For a connection with a different `OidMap` the query is
+ * converted as usual.
+ *
+ * Copies of the object share the cached representation, the conversion is thread-safe.
+ * The representation is allocated with the allocator of the first conversion.
+ *
+ * The `failover` micro-framework wraps the query of an operation automatically,
+ * so all the tries of the operation share the representation.
+ *
+ * @tparam Query --- `BinaryQueryConvertible` query type.
+ *
+ * @models{BinaryQueryConvertible}
+ * @ingroup group-query-types
+ */
+template <typename Query>
+class cached_binary_query {
+    static_assert(BinaryQueryConvertible<Query>, "Query should model BinaryQueryConvertible concept");
+
+    struct state {
+        Query query;
+        std::mutex mutex;
+        std::optional<binary_query> binary;
+        std::shared_ptr<const void> oid_map;
+        const std::type_info* oid_map_type = nullptr;
+
+        explicit state(Query q) : query(std::move(q)) {}
+    };
+
+    template <typename OidMap>
+    static bool oid_map_equal(const OidMap& lhs, const OidMap& rhs) {
+        return hana::equal(lhs.impl, rhs.impl);
+    }
+
+    std::shared_ptr<state> state_;
+
+public:
+    using query_type = Query; //!< Type of the wrapped query
+
+    /**
+     * Construct a new `cached_binary_query` object.
+     *
+     * @param query --- query object to convert.
+     */
+    explicit cached_binary_query(Query query)
+    : state_(std::make_shared<state>(std::move(query))) {}
+
+    /**
+     * Wrapped query object.
+     */
+    const Query& query() const noexcept { return state_->query; }
+
+    /**
+     * Indicates if the binary representation has been cached already.
+     */
+    bool cached() const {
+        std::lock_guard lock(state_->mutex);
+        return state_->binary.has_value();
+    }
+
+    /**
+     * Get the binary representation of the query for the `OidMap`.
+     *
+     * @param oid_map   --- `OidMap` to type OIDs for the binary representation.
+     * @param allocator --- allocator to use for the data of `ozo::binary_query`.
+     * @return `ozo::binary_query` --- cached representation if it has been made for an equal
+     *                                 `OidMap`, new representation otherwise.
+     */
+    template <typename OidMap, typename Allocator = std::allocator<char>>
+    binary_query get(const OidMap& oid_map, const Allocator& allocator = Allocator{}) const {
+        std::lock_guard lock(state_->mutex);
+        if (state_->binary) {
+            if (*state_->oid_map_type == typeid(OidMap)
+                    && oid_map_equal(*static_cast<const OidMap*>(state_->oid_map.get()), oid_map)) {
+                return *state_->binary;
+            }
+            return to_binary_query(state_->query, oid_map, allocator);
+        }
+        state_->binary.emplace(to_binary_query(state_->query, oid_map, allocator));
+        state_->oid_map = std::make_shared<const OidMap>(oid_map);
+        state_->oid_map_type = &typeid(OidMap);
+        return *state_->binary;
+    }
+};
+
+template <typename Query>
+struct to_binary_query_impl<cached_binary_query<Query>> {
+    template <typename OidMap, typename Alloc>
+    static binary_query apply(const cached_binary_query<Query>& query, const OidMap& oid_map, const Alloc& allocator) {
+        return query.get(oid_map, allocator);
+    }
+};
+
+namespace detail {
+
+template <typename T>
+struct is_cached_binary_query : std::false_type {};
+
+template <typename Query>
+struct is_cached_binary_query<cached_binary_query<Query>> : std::true_type {};
+
+template <typename T>
+inline constexpr auto should_cache_binary_query = BinaryQueryConvertible<T>
+    && !std::is_same_v<std::decay_t<T>, binary_query>
+    && !is_cached_binary_query<std::decay_t<T>>::value;
+
+} // namespace detail
+
+/**
+ * @brief Wrap a query into `ozo::cached_binary_query`
+ *
+ * @param query --- `BinaryQueryConvertible` query object.
+ * @return `ozo::cached_binary_query` --- for a query which is converted each time,
+ *         the query itself for `ozo::binary_query`, `ozo::cached_binary_query` and other types.
+ *
+ * @ingroup group-query-functions
+ */
+template <typename T>
+inline decltype(auto) cache_binary_query(T&& query) {
+    if constexpr (detail::should_cache_binary_query<T>) {
+        return cached_binary_query<std::decay_t<T>>(std::forward<T>(query));
+    } else {
+        return std::forward<T>(query);
+    }
+}
+
+/**
+ * @brief Type of the `ozo::cache_binary_query()` result for the decayed type `T`
+ * @ingroup group-query-types
+ */
+template <typename T>
+using cache_binary_query_t = std::conditional_t<detail::should_cache_binary_query<T>,
+    cached_binary_query<std::decay_t<T>>, std::decay_t<T>>;
+
 } // namespace ozo
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <ozo/connector.h>
+#include <ozo/connection.h>
+#include <ozo/deadline.h>
+#include <ozo/impl/async_connect.h>
+#include <ozo/ext/std/shared_ptr.h>
+#include <ozo/detail/bind.h>
+
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ozo {
+
+/**
+ * @brief Configuration of the `ozo::multi_host_connection_info`
+ * @ingroup group-connection-types
+ */
+struct multi_host_connection_info_config {
+    /**
+     * Delay before a connection attempt to the next host while previous attempts are in progress.
+     * Zero delay means connecting to all the hosts in parallel. A failed attempt starts
+     * the next one immediately regardless of the delay.
+     */
+    time_traits::duration stagger = time_traits::duration::zero();
+    /**
+     * Value of the libpq [target_session_attrs](https://www.postgresql.org/docs/current/libpq-connect.html#LIBPQ-CONNECT-TARGET-SESSION-ATTRS)
+     * parameter added to the connection string of each host, e.g. `"read-write"` to connect
+     * to the master only. Empty value leaves connection strings as is.
+     */
+    std::string target_session_attrs;
+};
+
+namespace detail {
+
+inline std::string add_target_session_attrs(std::string conn_str, const std::string& attrs) {
+    if (attrs.empty()) {
+        return conn_str;
+    }
+    const auto is_uri = conn_str.compare(0, 13, "postgresql://") == 0 || conn_str.compare(0, 11, "postgres://") == 0;
+    if (is_uri) {
+        conn_str += conn_str.find('?') == std::string::npos ? '?' : '&';
+    } else if (!conn_str.empty()) {
+        conn_str += ' ';
+    }
+    conn_str += "target_session_attrs=";
+    conn_str += attrs;
+    return conn_str;
+}
+
+/**
+ * Shared state of a connection race. The first attempt which establishes a connection wins,
+ * the rest attempts are cancelled and their connections are dropped.
+ */
+template <typename Connection, typename Statistics, typename TimeConstraint, typename Handler>
+struct multi_host_connect_state : std::enable_shared_from_this<multi_host_connect_state<Connection, Statistics, TimeConstraint, Handler>> {
+    using connection_type = std::shared_ptr<Connection>;
+
+    std::mutex mutex;
+    io_context& io;
+    std::shared_ptr<const std::vector<std::string>> conn_strs;
+    time_traits::duration stagger;
+    Statistics statistics;
+    TimeConstraint t;
+    Handler handler;
+    asio::steady_timer timer;
+    std::vector<connection_type> attempts;
+    std::size_t next = 0;
+    std::size_t pending = 0;
+    bool done = false;
+    error_code last_error;
+    connection_type last_connection;
+
+    multi_host_connect_state(io_context& io, std::shared_ptr<const std::vector<std::string>> conn_strs,
+            time_traits::duration stagger, Statistics statistics, TimeConstraint t, Handler handler)
+    : io(io), conn_strs(std::move(conn_strs)), stagger(stagger), statistics(std::move(statistics)),
+      t(std::move(t)), handler(std::move(handler)), timer(io), attempts(this->conn_strs->size()) {}
+
+    struct attempt_handler {
+        std::shared_ptr<multi_host_connect_state> state;
+        std::size_t n;
+
+        void operator() (error_code ec, connection_type conn) {
+            state->on_attempt(n, std::move(ec), std::move(conn));
+        }
+    };
+
+    void start() {
+        std::vector<std::size_t> started;
+        {
+            std::lock_guard lock(mutex);
+            do {
+                started.push_back(reserve());
+            } while (next < conn_strs->size() && stagger == time_traits::duration::zero());
+            schedule();
+        }
+        for (auto n : started) {
+            launch(n);
+        }
+    }
+
+    // Should be called under the lock
+    std::size_t reserve() {
+        const auto n = next++;
+        ++pending;
+        attempts[n] = std::allocate_shared<Connection>(asio::get_associated_allocator(handler), io, statistics);
+        return n;
+    }
+
+    // Should be called under the lock
+    void schedule() {
+        if (next >= conn_strs->size() || stagger == time_traits::duration::zero()) {
+            return;
+        }
+        timer.expires_after(stagger);
+        timer.async_wait([self = this->shared_from_this()] (error_code ec) {
+            if (!ec) {
+                self->on_stagger();
+            }
+        });
+    }
+
+    void on_stagger() {
+        std::size_t n;
+        {
+            std::lock_guard lock(mutex);
+            if (done || next >= conn_strs->size()) {
+                return;
+            }
+            n = reserve();
+            schedule();
+        }
+        launch(n);
+    }
+
+    void launch(std::size_t n) {
+        connection_type conn;
+        {
+            std::lock_guard lock(mutex);
+            conn = attempts[n];
+        }
+        if (!conn) {
+            return;
+        }
+        impl::async_connect((*conn_strs)[n], t, std::move(conn), attempt_handler{this->shared_from_this(), n});
+    }
+
+    void on_attempt(std::size_t n, error_code ec, connection_type conn) {
+        std::unique_lock lock(mutex);
+        --pending;
+        attempts[n].reset();
+        if (done) {
+            return;
+        }
+        if (!ec) {
+            done = true;
+            std::vector<connection_type> losers(attempts.size());
+            losers.swap(attempts);
+            timer.cancel();
+            lock.unlock();
+            for (auto& loser : losers) {
+                if (loser) {
+                    asio::post(loser->get_executor(), [loser] { loser->cancel(); });
+                }
+            }
+            return complete(std::move(ec), std::move(conn));
+        }
+        last_error = std::move(ec);
+        last_connection = std::move(conn);
+        if (next < conn_strs->size()) {
+            const auto next_n = reserve();
+            lock.unlock();
+            return launch(next_n);
+        }
+        if (pending == 0) {
+            done = true;
+            timer.cancel();
+            lock.unlock();
+            return complete(std::move(last_error), std::move(last_connection));
+        }
+    }
+
+    void complete(error_code ec, connection_type conn) {
+        asio::dispatch(detail::bind(std::move(handler), std::move(ec), std::move(conn)));
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Connection source to the first available of several hosts
+ *
+ * This connection source races connection attempts to several hosts and provides the connection
+ * which is established first. Each host is specified with its own
+ * [connection string](https://www.postgresql.org/docs/current/libpq-connect.html#LIBPQ-CONNSTRING).
+ * Attempts are started either all at once or one by one with the
+ * `multi_host_connection_info_config::stagger` delay, like the "Happy Eyeballs" algorithm does.
+ * As soon as a connection is established the rest attempts are cancelled and their connections
+ * are closed. If all the attempts fail the handler gets the error and the connection of the last
+ * failed attempt.
+ *
+ * Comparing to a libpq multi-host connection string, which tries hosts sequentially and so pays
+ * for the full timeout of each unavailable host, the connection latency is determined by the
+ * fastest host. The `multi_host_connection_info_config::target_session_attrs` filter is applied by libpq
+ * for each host, so a host with non-matching session attributes fails its attempt.
+ *
+ * The time constraint is common for all the attempts.
+ *
+ * @tparam OidMap --- oid map type with custom types that should be used within a connection.
+ * @tparam Statistics --- statistics type which defines statistics is collected for this connection.
+ * @ingroup group-connection-types
+ * @models{ConnectionSource}
+ */
+template <
+    typename OidMap = empty_oid_map,
+    typename Statistics = no_statistics>
+class multi_host_connection_info {
+    std::shared_ptr<const std::vector<std::string>> conn_strs_;
+    time_traits::duration stagger_;
+    Statistics statistics_;
+
+public:
+    using connection_type = std::shared_ptr<ozo::connection<OidMap, Statistics>>; //!< Type of connection which is produced by the source.
+
+    /**
+     * @brief Construct a new multi-host connection information object
+     *
+     * @param conn_strs --- connection strings of the hosts, should not be empty.
+     * @param config --- connection configuration.
+     * @param OidMap --- #OidMap for custom types support.
+     * @param statistics --- statistics are being used for connections.
+     */
+    multi_host_connection_info(std::vector<std::string> conn_strs, multi_host_connection_info_config config = {},
+            const OidMap& = OidMap{}, Statistics statistics = Statistics{})
+            : stagger_(config.stagger), statistics_(std::move(statistics)) {
+        if (conn_strs.empty()) {
+            throw std::invalid_argument("multi_host_connection_info: connection strings should not be empty");
+        }
+        for (auto& conn_str : conn_strs) {
+            conn_str = detail::add_target_session_attrs(std::move(conn_str), config.target_session_attrs);
+        }
+        conn_strs_ = std::make_shared<const std::vector<std::string>>(std::move(conn_strs));
+    }
+
+    /**
+     * Number of hosts.
+     */
+    std::size_t size() const noexcept { return conn_strs_->size(); }
+
+    /**
+     * Connection string of the host which is used for connection attempts.
+     *
+     * @param n --- index of the host in order of construction.
+     */
+    const std::string& conn_str(std::size_t n) const { return conn_strs_->at(n); }
+
+    /**
+     * @brief Provides connection is binded to the given `io_context`
+     *
+     * In case of success --- the handler will be invoked with the first established connection.
+     * In case of all the attempts failed --- the handler will be invoked as operation failed.
+     * This operation has a time constrain and would be interrupted if the time
+     * constrain expired by cancelling IO on `Connection`s sockets.
+     *
+     * @param io --- `io_context` for the connection IO.
+     * @param t --- #TimeConstraint for the operation.
+     * @param handler --- #Handler.
+     */
+    template <typename TimeConstraint, typename Handler>
+    void operator ()(io_context& io, TimeConstraint t, Handler&& handler) const {
+        static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+        auto at = ozo::deadline(t);
+        using state_type = detail::multi_host_connect_state<ozo::connection<OidMap, Statistics>,
+            Statistics, decltype(at), std::decay_t<Handler>>;
+        auto allocator = asio::get_associated_allocator(handler);
+        auto state = std::allocate_shared<state_type>(allocator, io, conn_strs_, stagger_, statistics_,
+            at, std::forward<Handler>(handler));
+        state->start();
+    }
+
+    auto operator [](io_context& io) const & {
+        return connection_provider(*this, io);
+    }
+
+    auto operator [](io_context& io) && {
+        return connection_provider(std::move(*this), io);
+    }
+};
+
+template<typename OidMap, typename Statistics>
+multi_host_connection_info(std::vector<std::string>, multi_host_connection_info_config, const OidMap&, Statistics statistics)
+    -> multi_host_connection_info<OidMap, Statistics>;
+
+static_assert(ConnectionProvider<decltype(std::declval<multi_host_connection_info<>>()[std::declval<io_context&>()])>,
+    "is not a ConnectionProvider");
+
+} // namespace ozo
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <ozo/connection.h>
+#include <ozo/type_traits.h>
+
+#include <boost/container_hash/hash.hpp>
+#include <boost/hana/for_each.hpp>
+#include <boost/hana/keys.hpp>
+
+#include <libpq-fe.h>
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace ozo {
+
+/**
+ * @brief Process-wide cache of custom types oids
+ *
+ * Each new connection with a non-empty `OidMap` requests oids of the custom types from the
+ * database, which doubles the number of round trips to establish the connection. The cache keeps
+ * oids received by connections to a server, so new connections to the same server take the oids
+ * from the cache without the request. The server is identified by host, port, database and user
+ * name (user matters since type names are resolved via the `search_path`) and by server version.
+ * Since the `search_path` may be changed by the `options` connection parameter or by session
+ * initialization statements, connections with different options or statements use different entries.
+ *
+ * An entry of the server is invalidated then a result processing fails with the
+ * `ozo::error::oid_type_mismatch` error, so the next connection requests the oids again.
+ * If a type has been changed in the database and an error has not been caught by the library,
+ * e.g. `ozo::basic_result` is processed by user code, the entry may be invalidated
+ * manually via `invalidate()`.
+ *
+ * The cache is disabled by default, since oids of types which are dropped and created again
+ * (e.g. by migrations) stay in the cache until the first failed request. It should be enabled
+ * explicitly via `ozo::oid_map_cache::instance().enabled(true)`.
+ *
+ * The cache is thread-safe.
+ *
+ * @ingroup group-connection-types
+ */
+class oid_map_cache {
+public:
+    /**
+     * The process-wide instance which is used by connections.
+     */
+    static oid_map_cache& instance() {
+        static oid_map_cache cache;
+        return cache;
+    }
+
+    /**
+     * Indicates if the cache is used by connections.
+     */
+    bool enabled() const noexcept { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * Enable or disable use of the cache by connections. The cache is disabled by default.
+     */
+    void enabled(bool v) noexcept { enabled_.store(v, std::memory_order_relaxed); }
+
+    /**
+     * Fill an oid map with cached oids of a server.
+     *
+     * @param key --- server key, see `ozo::oid_map_cache_key()`.
+     * @param oid_map --- oid map to fill.
+     * @return true --- all the types of the map have been found, the map has been filled.
+     * @return false --- some types are missing in the cache, the map is left untouched.
+     */
+    template <typename ...Ts>
+    bool get(const std::string& key, oid_map_t<Ts...>& oid_map) const {
+        if (key.empty() || !enabled()) {
+            return false;
+        }
+        std::shared_lock lock(mutex_);
+        const auto server = servers_.find(key);
+        if (server == servers_.end()) {
+            return false;
+        }
+        const auto& oids = server->second;
+        bool found = true;
+        hana::for_each(hana::keys(oid_map.impl), [&] (const auto& type) {
+            found = found && oids.count(std::string(type_name<typename std::decay_t<decltype(type)>::type>()));
+        });
+        if (!found) {
+            return false;
+        }
+        hana::for_each(hana::keys(oid_map.impl), [&] (const auto& type) {
+            oid_map.impl[type] = oids.at(std::string(type_name<typename std::decay_t<decltype(type)>::type>()));
+        });
+        return true;
+    }
+
+    /**
+     * Store oids of an oid map received from a server.
+     *
+     * @param key --- server key, see `ozo::oid_map_cache_key()`.
+     * @param oid_map --- oid map with oids received from the server.
+     */
+    template <typename ...Ts>
+    void put(const std::string& key, const oid_map_t<Ts...>& oid_map) {
+        if (key.empty() || !enabled()) {
+            return;
+        }
+        std::unique_lock lock(mutex_);
+        auto& oids = servers_[key];
+        hana::for_each(hana::keys(oid_map.impl), [&] (const auto& type) {
+            oids[std::string(type_name<typename std::decay_t<decltype(type)>::type>())] = oid_map.impl[type];
+        });
+    }
+
+    /**
+     * Remove cached oids of a server. Entries of the server for connections with session
+     * initialization statements are removed as well.
+     *
+     * @param key --- server key, see `ozo::oid_map_cache_key()`.
+     */
+    void invalidate(const std::string& key) {
+        std::unique_lock lock(mutex_);
+        servers_.erase(key);
+        const auto prefix = key + '~';
+        for (auto i = servers_.begin(); i != servers_.end();) {
+            if (i->first.compare(0, prefix.size(), prefix) == 0) {
+                i = servers_.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    /**
+     * Remove all the cached oids.
+     */
+    void clear() {
+        std::unique_lock lock(mutex_);
+        servers_.clear();
+    }
+
+    /**
+     * Number of servers with cached oids.
+     */
+    std::size_t size() const {
+        std::shared_lock lock(mutex_);
+        return servers_.size();
+    }
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::unordered_map<std::string, oid_t>> servers_;
+    std::atomic<bool> enabled_{false};
+};
+
+namespace detail {
+
+template <typename Connection, typename = std::void_t<>>
+struct is_libpq_connection : std::false_type {};
+
+template <typename Connection>
+struct is_libpq_connection<Connection, std::void_t<decltype(unwrap_connection(std::declval<const Connection&>()).native_handle())>>
+    : std::is_same<decltype(unwrap_connection(std::declval<const Connection&>()).native_handle()), PGconn*> {};
+
+} // namespace detail
+
+/**
+ * @brief Key of a server in the `ozo::oid_map_cache`
+ *
+ * The key contains the `options` connection parameter and a hash of the session initialization
+ * statements, since both may change the `search_path` which the type names are resolved with.
+ *
+ * @param conn --- established connection to the server.
+ * @param session --- session initialization statements of the connection.
+ * @return std::string --- server key, empty string for a connection which does not provide
+ * a libpq native handle or is not established.
+ * @ingroup group-connection-functions
+ * @relates ozo::oid_map_cache
+ */
+template <typename Connection>
+inline std::string oid_map_cache_key([[maybe_unused]] const Connection& conn,
+        [[maybe_unused]] const std::vector<std::string>& session = {}) {
+    if constexpr (detail::is_libpq_connection<Connection>::value) {
+        const auto handle = get_native_handle(conn);
+        if (handle == nullptr || PQstatus(handle) != CONNECTION_OK) {
+            return {};
+        }
+        std::string key(get_host(conn));
+        key += ':';
+        key += get_port(conn);
+        key += '/';
+        key += get_database(conn);
+        key += '@';
+        key += get_user(conn);
+        key += '#';
+        key += std::to_string(PQserverVersion(handle));
+        if (const char* options = PQoptions(handle); options && *options) {
+            key += '?';
+            key += options;
+        }
+        if (!session.empty()) {
+            key += '~';
+            key += std::to_string(boost::hash_range(session.begin(), session.end()));
+        }
+        return key;
+    } else {
+        return {};
+    }
+}
+
+} // namespace ozo
@@ -4,6 +4,8 @@
 #include <ozo/core/concept.h>
 #include <ozo/type_traits.h>
 
+#include <string_view>
+
 /**
  * @defgroup group-query Queries
  * @brief Database queries related concepts, types and functions.
@@ -59,6 +61,38 @@ struct to_const_char_impl<const char*> {
     }
 };
 
+/**
+ * @brief Name of a prepared statement as a query text
+ *
+ * A query with this text is executed as the named statement which has been prepared on the
+ * connection before, e.g. via the `PREPARE` session statements of `ozo::connection_info`.
+ * Parameters of the query are sent without types since they are defined by the statement.
+ * The name should refer to a null-terminated buffer which outlives the query.
+ *
+ * @sa ozo::query_repository::prepare_statements()
+ * @ingroup group-query-types
+ */
+struct prepared_statement {
+    std::string_view name; //!< name of the prepared statement
+};
+
+template <>
+struct to_const_char_impl<prepared_statement> {
+    static constexpr const char* apply(const prepared_statement& v) noexcept {
+        return v.name.data();
+    }
+};
+
+/**
+ * @brief Indicates if a query text is a name of a prepared statement
+ *
+ * Should be specialized for query text types which wrap `ozo::prepared_statement`.
+ *
+ * @ingroup group-query-types
+ */
+template <typename T>
+struct is_prepared_statement : std::is_same<T, prepared_statement> {};
+
 #ifdef OZO_DOCUMENTATION
 /**
  * @brief Convert QueryText to const char*
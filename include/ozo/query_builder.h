@@ -112,6 +112,26 @@ struct query_builder {
             });
     }
 
+    /**
+     * Finalized query text as a static null-terminated buffer. Available if the text consists
+     * of `_SQL` literals only, i.e. `text()` is a `boost::hana::string`.
+     */
+    static constexpr const char* static_text() noexcept {
+        using text_type = decltype(std::declval<const query_builder&>().text());
+        static_assert(HanaString<text_type>, "query text is not known at compile time");
+        return hana::to<const char*>(text_type {});
+    }
+
+    /**
+     * OIDs of the query parameters as a static array. Available if all the parameter types
+     * are built-in, see `ozo::static_type_oids`.
+     */
+    static constexpr const oid_t* static_types() noexcept {
+        using static_types = ozo::static_type_oids<decltype(std::declval<const query_builder&>().params())>;
+        static_assert(static_types::value, "query parameters types are not built-in");
+        return std::data(static_types::oids);
+    }
+
     constexpr auto build() const {
         return hana::unpack(
             params(),
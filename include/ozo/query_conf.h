@@ -16,13 +16,20 @@
 #include <boost/range/numeric.hpp>
 #include <boost/spirit/home/x3.hpp>
 
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace ozo {
 
@@ -456,15 +463,167 @@ inline std::shared_ptr<query_conf> make_query_conf(std::vector<ozo::detail::quer
     return result;
 }
 
+template <class QueryT, class ... QueriesT>
+constexpr std::size_t query_index() noexcept {
+    constexpr bool matches[] = {std::is_same_v<QueryT, QueriesT> ..., false};
+    std::size_t index = 0;
+    while (index < sizeof...(QueriesT) && !matches[index]) {
+        ++index;
+    }
+    return index;
+}
+
+template <class QueryT, class ... QueriesT>
+constexpr std::size_t query_index_v = query_index<QueryT, QueriesT ...>();
+
+/**
+ * Texts of the declared queries in order of declaration. A text of a query which is not
+ * defined in the query conf has null data pointer.
+ */
+template <class ... QueriesT>
+using query_texts = std::array<std::string_view, sizeof...(QueriesT)>;
+
+template <class ... QueriesT>
+query_texts<QueriesT ...> make_query_texts(const query_conf& conf) {
+    query_texts<QueriesT ...> result;
+    std::size_t index = 0;
+    hana::for_each(hana::tuple<QueriesT ...>(), [&] (const auto& query) {
+        const auto found = conf.queries.find(get_query_name(query));
+        if (found != conf.queries.end()) {
+            result[index] = found->second;
+        }
+        ++index;
+    });
+    return result;
+}
+
+template <class Tuple, std::size_t ... I>
+std::vector<std::string_view> tuple_type_names(std::index_sequence<I ...>) {
+    return {std::string_view(type_name<std::tuple_element_t<I, Tuple>>()) ...};
+}
+
+template <class QueryT>
+std::vector<std::string_view> query_parameters_type_names() {
+    using parameters_type = typename typed_query_traits<QueryT>::parameters_type;
+    if constexpr (HasMembers<parameters_type>) {
+        std::vector<std::string_view> result;
+        hana::for_each(hana::accessors<parameters_type>(), [&] (const auto& accessor) {
+            using type = std::decay_t<decltype(hana::second(accessor)(std::declval<const parameters_type&>()))>;
+            result.emplace_back(type_name<type>());
+        });
+        return result;
+    } else {
+        return tuple_type_names<parameters_type>(std::make_index_sequence<std::tuple_size_v<parameters_type>>());
+    }
+}
+
+/**
+ * Prepared statement of a declared query. The name is made of the query name and a hash of
+ * the query name, parameter types and text, so it is stable for the same query conf and never
+ * refers to a statement prepared for another definition of the query.
+ */
+struct prepared_statement_description {
+    std::string name;
+    std::string prepare;
+};
+
+inline std::uint64_t fnv1a_hash(std::string_view data, std::uint64_t hash = 14695981039346656037ull) noexcept {
+    for (const auto c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline prepared_statement_description make_prepared_statement_description(std::string_view query_name,
+        const std::vector<std::string_view>& types, std::string_view text) {
+    constexpr std::size_t max_name_prefix_size = 40;
+    prepared_statement_description result;
+    result.name = "ozo_";
+    for (const auto c : query_name.substr(0, max_name_prefix_size)) {
+        result.name += std::isalnum(static_cast<unsigned char>(c))
+            ? static_cast<char>(std::tolower(static_cast<unsigned char>(c))) : '_';
+    }
+    std::string signature(query_name);
+    signature += '(';
+    for (std::size_t i = 0; i < types.size(); ++i) {
+        if (i) {
+            signature += ',';
+        }
+        signature += types[i];
+    }
+    signature += ')';
+    const auto hash = fnv1a_hash(text, fnv1a_hash(signature));
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    result.name += '_';
+    result.name += hex;
+
+    result.prepare = "PREPARE " + result.name;
+    if (!types.empty()) {
+        result.prepare += " (";
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            if (i) {
+                result.prepare += ", ";
+            }
+            result.prepare += types[i];
+        }
+        result.prepare += ')';
+    }
+    result.prepare += " AS ";
+    result.prepare += text;
+    return result;
+}
+
+/**
+ * Prepared statements of the declared queries in order of declaration. A statement description
+ * is made on first use, so parameter types of queries which are never prepared are not required
+ * to have type traits.
+ */
+template <class ... QueriesT>
+struct prepared_statements {
+    std::array<std::once_flag, sizeof...(QueriesT)> flags;
+    std::array<prepared_statement_description, sizeof...(QueriesT)> descriptions;
+};
+
 } // namespace detail
 
+/**
+ * @brief Repository of queries defined in a query conf
+ *
+ * The repository is made via `ozo::make_query_repository()` from a query conf and a set of
+ * query declarations. It makes queries with texts from the conf via `make_query()`.
+ *
+ * Each defined query also has a prepared statement with a stable name which is derived from
+ * the query name, parameter types and text. Statements are prepared by a connection with
+ * `prepare_statements()` used as session statements, e.g. each connection of a pool prepares
+ * all of them once it is established:
+ *
+ * @code
+const auto repository = ozo::make_query_repository(conf, hana::tuple<GetUser, UpdateUser>());
+const ozo::connection_info source(conn_str, repository.prepare_statements());
+ozo::connection_pool pool(source, pool_config);
+...
+ozo::request(pool[io], repository.make_prepared_query<GetUser>(id), deadline, ozo::into(result), yield);
+ * @endcode
+ *
+ * A query made via `make_prepared_query()` is executed via `PQsendQueryPrepared` without the
+ * parse and plan phases, so it should be used only with connections which prepare the statements.
+ *
+ * @ingroup group-query-types
+ */
 template <class ... QueriesT>
 class query_repository {
 public:
     query_repository() = default;
 
     query_repository(std::shared_ptr<detail::query_conf> query_conf)
-        : query_conf(std::move(query_conf)) {}
+        : query_conf(std::move(query_conf)) {
+        if (this->query_conf) {
+            texts = detail::make_query_texts<QueriesT ...>(*this->query_conf);
+            statements = std::make_shared<detail::prepared_statements<QueriesT ...>>();
+        }
+    }
 
     bool is_initialized() const noexcept {
         return query_conf != nullptr;
@@ -521,12 +680,87 @@ public:
         }
     }
 
+    /**
+     * Name of the prepared statement of a query.
+     *
+     * @tparam QueryT --- declared query type.
+     */
+    template <class QueryT>
+    std::string_view statement_name() const {
+        return get_prepared_statement<QueryT>().name;
+    }
+
+    /**
+     * `PREPARE` statements for all the queries defined in the query conf. The result is intended
+     * to be passed as session statements of `ozo::connection_info`.
+     */
+    std::vector<std::string> prepare_statements() const {
+        std::vector<std::string> result;
+        std::size_t index = 0;
+        hana::for_each(hana::tuple<QueriesT ...>(), [&] (const auto& query) {
+            if (texts[index++].data() != nullptr) {
+                result.push_back(get_prepared_statement<std::decay_t<decltype(query)>>().prepare);
+            }
+        });
+        return result;
+    }
+
+    /**
+     * Make a query which is executed as the prepared statement of the query, see `prepare_statements()`.
+     * Parameters are the same as for `make_query()`.
+     */
+    template <class QueryT, class ... ParametersT,
+        typename = Require<
+            std::is_same_v<typename typed_query_traits<QueryT>::parameters_type,
+            std::tuple<std::decay_t<ParametersT> ...>>
+        >
+    >
+    auto make_prepared_query(ParametersT&& ... parameters) const {
+        return ozo::make_query(prepared_statement{statement_name<QueryT>()}, std::forward<ParametersT>(parameters) ...);
+    }
+
+    template <class QueryT>
+    auto make_prepared_query(const typename typed_query_traits<QueryT>::parameters_type& parameters) const {
+        const prepared_statement statement{statement_name<QueryT>()};
+        if constexpr (detail::HasMembers<typename typed_query_traits<QueryT>::parameters_type>) {
+            return hana::unpack(
+                hana::members(parameters),
+                [&] (const auto& ... parameters) { return ozo::make_query(statement, parameters ...); }
+            );
+        } else {
+            return std::apply(
+                [&] (const auto& ... parameters) { return ozo::make_query(statement, parameters ...); },
+                parameters
+            );
+        }
+    }
+
 private:
     std::shared_ptr<detail::query_conf> query_conf;
+    detail::query_texts<QueriesT ...> texts;
+    std::shared_ptr<detail::prepared_statements<QueriesT ...>> statements;
+
+    template <class QueryT>
+    std::string_view get_description() const {
+        constexpr auto index = detail::query_index_v<QueryT, QueriesT ...>;
+        static_assert(index < sizeof...(QueriesT), "QueryT is not declared in the query repository");
+        const auto text = texts[index];
+        if (text.data() == nullptr) {
+            throw std::out_of_range(std::string("Query is not defined in query conf: ")
+                + hana::to<const char*>(typed_query_name_t<QueryT>()));
+        }
+        return text;
+    }
 
     template <class QueryT>
-    decltype(auto) get_description() const {
-        return query_conf->queries.at(get_query_name(std::get<QueryT>(std::tuple<QueriesT ...>())));
+    const detail::prepared_statement_description& get_prepared_statement() const {
+        constexpr auto index = detail::query_index_v<QueryT, QueriesT ...>;
+        const auto text = get_description<QueryT>();
+        std::call_once(statements->flags[index], [&] {
+            statements->descriptions[index] = detail::make_prepared_statement_description(
+                get_query_name(QueryT{}), detail::query_parameters_type_names<QueryT>(), text);
+        });
+        return statements->descriptions[index];
     }
 };
 
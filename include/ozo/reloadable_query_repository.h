@@ -0,0 +1,205 @@
+#pragma once
+
+#include <ozo/query_conf.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace ozo {
+namespace detail {
+
+/**
+ * Query text which keeps the snapshot of `ozo::reloadable_query_repository` it refers to alive.
+ */
+template <typename Text>
+struct snapshot_query_text {
+    Text text;
+    std::shared_ptr<const void> snapshot;
+};
+
+} // namespace detail
+
+template <typename Text>
+struct to_const_char_impl<detail::snapshot_query_text<Text>> {
+    static const char* apply(const detail::snapshot_query_text<Text>& v) noexcept {
+        return to_const_char(v.text);
+    }
+};
+
+template <typename Text>
+struct is_prepared_statement<detail::snapshot_query_text<Text>> : is_prepared_statement<Text> {};
+
+/**
+ * @brief Query repository which can be reloaded from a query conf file at runtime
+ *
+ * The repository holds an immutable snapshot of `ozo::query_repository` made from the file.
+ * `reload()` reads the file again, validates it the same way `ozo::make_query_repository()`
+ * does and publishes a new snapshot. Readers, i.e. `make_query()` and `snapshot()` calls, do not
+ * take a lock while the snapshot is not changed: each thread caches the current snapshot and checks
+ * it with a single atomic load of the snapshot version. A thread takes the lock once after a reload
+ * to refresh its cache.
+ *
+ * Queries made via the reloadable repository share ownership of the snapshot they have been
+ * made from, so a previous snapshot is released as soon as there are no queries, no `snapshot()`
+ * results and no thread caches which refer to it. A thread cache keeps a snapshot until the thread
+ * reads from a repository of the same type again or exits. A snapshot is published only if the file content
+ * differs from the current one. The repository is expected to be reloaded on demand, e.g. via
+ * a signal handler or a timer.
+ *
+ * @note Prepared statement names depend on query texts, so connections which prepared statements
+ * of a previous snapshot (see `ozo::query_repository::prepare_statements()`) do not have statements
+ * of changed queries.
+ *
+ * @tparam QueriesT --- declared query types.
+ * @ingroup group-query-types
+ */
+template <class ... QueriesT>
+class reloadable_query_repository {
+public:
+    using repository_type = query_repository<QueriesT ...>; //!< Snapshot type
+
+    /**
+     * Construct the repository and load the query conf file.
+     *
+     * @param path --- path to the query conf file.
+     * @throws std::runtime_error --- the file can not be read.
+     * @throws std::invalid_argument --- the query conf is invalid.
+     */
+    explicit reloadable_query_repository(std::string path) : path_(std::move(path)) {
+        reload();
+    }
+
+    reloadable_query_repository(const reloadable_query_repository&) = delete;
+    reloadable_query_repository& operator =(const reloadable_query_repository&) = delete;
+
+    /**
+     * Reload the query conf file. In case of an error the current snapshot stays in use.
+     *
+     * @return `true` --- a new snapshot has been published.
+     * @return `false` --- the file content has not been changed.
+     * @throws std::runtime_error --- the file can not be read.
+     * @throws std::invalid_argument --- the query conf is invalid.
+     */
+    bool reload() {
+        const std::lock_guard reload_lock(reload_mutex_);
+        auto content = read_file();
+        if (current_ && current_->content == content) {
+            return false;
+        }
+        auto repository = make_query_repository(content, hana::tuple<QueriesT ...>());
+        auto snapshot = std::make_shared<const snapshot_type>(snapshot_type {std::move(content), std::move(repository)});
+        {
+            const std::lock_guard lock(mutex_);
+            current_ = std::move(snapshot);
+            version_.store(versions_.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        generation_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Current snapshot of the repository. The snapshot stays valid while the result is kept,
+     * even if a new one has been published.
+     */
+    std::shared_ptr<const repository_type> snapshot() const {
+        auto current = current_snapshot();
+        const auto repository = std::addressof(current->repository);
+        return {std::move(current), repository};
+    }
+
+    /**
+     * Number of published snapshots.
+     */
+    std::uint64_t generation() const noexcept {
+        return generation_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Path to the query conf file.
+     */
+    const std::string& path() const noexcept { return path_; }
+
+    /**
+     * Make a query from the current snapshot, see `ozo::query_repository::make_query()`.
+     * The query keeps the snapshot alive.
+     */
+    template <class QueryT, class ... ParametersT>
+    auto make_query(ParametersT&& ... parameters) const {
+        auto current = snapshot();
+        auto query = current->template make_query<QueryT>(std::forward<ParametersT>(parameters) ...);
+        return with_snapshot(std::move(query), std::move(current));
+    }
+
+    /**
+     * Make a prepared query from the current snapshot, see `ozo::query_repository::make_prepared_query()`.
+     * The query keeps the snapshot alive.
+     */
+    template <class QueryT, class ... ParametersT>
+    auto make_prepared_query(ParametersT&& ... parameters) const {
+        auto current = snapshot();
+        auto query = current->template make_prepared_query<QueryT>(std::forward<ParametersT>(parameters) ...);
+        return with_snapshot(std::move(query), std::move(current));
+    }
+
+private:
+    template <class Text, class ... ParamsT>
+    static auto with_snapshot(impl::query<Text, ParamsT ...>&& query, std::shared_ptr<const repository_type> snapshot) {
+        using text_type = detail::snapshot_query_text<Text>;
+        return impl::query<text_type, ParamsT ...> {
+            text_type {std::move(query.text), std::move(snapshot)}, std::move(query.params)
+        };
+    }
+
+    struct snapshot_type {
+        std::string content;
+        repository_type repository;
+    };
+
+    struct cached_snapshot {
+        std::uint64_t version = 0;
+        std::shared_ptr<const snapshot_type> snapshot;
+    };
+
+    // Versions are unique among all the repositories of the type, so a thread cache
+    // of one repository is never taken for a snapshot of another one.
+    std::shared_ptr<const snapshot_type> current_snapshot() const {
+        thread_local cached_snapshot cache;
+        if (cache.version != version_.load(std::memory_order_acquire)) {
+            const std::lock_guard lock(mutex_);
+            cache.snapshot = current_;
+            cache.version = version_.load(std::memory_order_relaxed);
+        }
+        return cache.snapshot;
+    }
+
+    std::string read_file() const {
+        std::ifstream file(path_, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Can not open query conf file: " + path_);
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        if (file.bad()) {
+            throw std::runtime_error("Can not read query conf file: " + path_);
+        }
+        return content.str();
+    }
+
+    std::string path_;
+    std::mutex reload_mutex_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const snapshot_type> current_;
+    std::atomic<std::uint64_t> version_ {0};
+    std::atomic<std::uint64_t> generation_ {0};
+    inline static std::atomic<std::uint64_t> versions_ {0};
+};
+
+} // namespace ozo
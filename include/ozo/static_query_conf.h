@@ -0,0 +1,425 @@
+#pragma once
+
+#include <ozo/query_conf.h>
+
+#include <boost/hana/accessors.hpp>
+#include <boost/hana/first.hpp>
+#include <boost/hana/string.hpp>
+#include <boost/hana/tuple.hpp>
+#include <boost/hana/unpack.hpp>
+
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+namespace ozo {
+namespace detail::static_query_conf {
+
+/**
+ * Compile-time counterpart of the query conf parser. It follows the rules of `parse_query_conf()`
+ * and `make_query_description()`: the conf consists of lines, a comment line `-- name: <name>`
+ * starts a query, other comment lines are skipped, text lines of a query are joined, named
+ * parameters `:name` are replaced with `$N` and the text is trimmed.
+ *
+ * All the functions are `constexpr` and report errors via exceptions, so errors are compile
+ * errors being evaluated in a constant expression.
+ */
+
+constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+constexpr bool is_space(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+constexpr bool is_parameter_name_char(char c) noexcept {
+    return c == '_' || (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+struct line {
+    std::string_view content; // line without end of line
+    std::string_view text; // line with end of line
+};
+
+constexpr line next_line(std::string_view conf, std::size_t& position) noexcept {
+    const auto begin = position;
+    while (position < conf.size() && conf[position] != '\r' && conf[position] != '\n') {
+        ++position;
+    }
+    const auto content = conf.substr(begin, position - begin);
+    if (position < conf.size()) {
+        position += (conf[position] == '\r' && position + 1 < conf.size() && conf[position + 1] == '\n') ? 2 : 1;
+    }
+    return line {content, conf.substr(begin, position - begin)};
+}
+
+constexpr bool is_comment(std::string_view content) noexcept {
+    return content.size() >= 2 && content[0] == '-' && content[1] == '-';
+}
+
+constexpr std::size_t skip_spaces(std::string_view value, std::size_t position) noexcept {
+    while (position < value.size() && (is_space(value[position]) || value[position] == '\0')) {
+        ++position;
+    }
+    return position;
+}
+
+/**
+ * Query name of a `-- name: <name>` comment line or empty string for other lines.
+ */
+constexpr std::string_view header_name(std::string_view content) noexcept {
+    if (!is_comment(content)) {
+        return {};
+    }
+    auto position = skip_spaces(content, 2);
+    if (content.substr(position, 4) != "name") {
+        return {};
+    }
+    position = skip_spaces(content, position + 4);
+    if (position >= content.size() || content[position] != ':') {
+        return {};
+    }
+    position = skip_spaces(content, position + 1);
+    return content.substr(position);
+}
+
+/**
+ * Validate the conf structure and query definitions against the declared query names:
+ * each definition should be declared and each declared query should be defined once.
+ */
+template <std::size_t N>
+constexpr void check(std::string_view conf, const std::array<std::string_view, N>& declared) {
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = i + 1; j < N; ++j) {
+            if (declared[i] == declared[j]) {
+                throw std::invalid_argument("Duplicate declaration for query");
+            }
+        }
+    }
+    std::size_t position = 0;
+    bool header_parsed = false;
+    while (position < conf.size()) {
+        const auto current = next_line(conf, position);
+        if (is_comment(current.content)) {
+            const auto name = header_name(current.content);
+            if (name.empty()) {
+                continue;
+            }
+            header_parsed = true;
+            bool is_declared = false;
+            for (const auto& v : declared) {
+                is_declared = is_declared || v == name;
+            }
+            if (!is_declared) {
+                throw std::invalid_argument("Query is not declared");
+            }
+            std::size_t other_position = position;
+            while (other_position < conf.size()) {
+                if (header_name(next_line(conf, other_position).content) == name) {
+                    throw std::invalid_argument("Duplicate definition for query");
+                }
+            }
+        } else if (!header_parsed) {
+            throw std::invalid_argument("Failed to parse query conf: expected comment");
+        }
+    }
+    for (const auto& v : declared) {
+        bool is_defined = false;
+        position = 0;
+        while (!is_defined && position < conf.size()) {
+            is_defined = header_name(next_line(conf, position).content) == v;
+        }
+        if (!is_defined) {
+            throw std::invalid_argument("Query is not defined in query conf");
+        }
+    }
+}
+
+/**
+ * Sink which writes a range [begin, end) of the produced text and tracks
+ * the range of the text without leading and trailing spaces.
+ */
+template <std::size_t N>
+struct text_sink {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    std::size_t position = 0;
+    std::size_t first = npos;
+    std::size_t last = 0;
+    char data[N + 1] {};
+
+    constexpr void push(char c) noexcept {
+        if (!is_space(c)) {
+            if (first == npos) {
+                first = position;
+            }
+            last = position + 1;
+        }
+        if (position >= begin && position < end) {
+            data[position - begin] = c;
+        }
+        ++position;
+    }
+
+    constexpr void push_number(std::size_t value) noexcept {
+        char digits[std::numeric_limits<std::size_t>::digits10 + 1] {};
+        std::size_t size = 0;
+        do {
+            digits[size++] = char('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (size) {
+            push(digits[--size]);
+        }
+    }
+};
+
+template <std::size_t N>
+constexpr std::size_t parameter_number(std::string_view parameter, const std::array<std::string_view, N>& names,
+        bool numeric, std::size_t parameters_count) {
+    if (numeric) {
+        std::size_t number = 0;
+        for (const auto c : parameter) {
+            if (c < '0' || c > '9') {
+                throw std::invalid_argument("Only valid numeric names supported for not adapted query parameters types");
+            }
+            number = number * 10 + std::size_t(c - '0');
+        }
+        if (number >= parameters_count) {
+            throw std::out_of_range("Query has numeric parameter greater than maximum");
+        }
+        return number;
+    }
+    for (std::size_t i = 0; i < N; ++i) {
+        if (names[i] == parameter) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("Parameter is not found in query");
+}
+
+template <std::size_t N, class Sink>
+constexpr void make_text(std::string_view conf, std::string_view query_name,
+        const std::array<std::string_view, N>& names, bool numeric, std::size_t parameters_count, Sink& sink) {
+    std::size_t position = 0;
+    bool found = false;
+    bool in_query = false;
+    while (position < conf.size()) {
+        const auto current = next_line(conf, position);
+        if (is_comment(current.content)) {
+            const auto name = header_name(current.content);
+            if (!name.empty()) {
+                in_query = name == query_name;
+                found = found || in_query;
+            }
+            continue;
+        }
+        if (!in_query) {
+            continue;
+        }
+        const auto text = current.text;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] == '\0') {
+                continue;
+            }
+            if (text[i] != ':') {
+                sink.push(text[i]);
+                continue;
+            }
+            if (i + 1 < text.size() && (text[i + 1] == ':' || text[i + 1] == '=')) {
+                sink.push(text[i]);
+                sink.push(text[++i]);
+                continue;
+            }
+            std::size_t end = i + 1;
+            while (end < text.size() && is_parameter_name_char(text[end])) {
+                ++end;
+            }
+            if (end == i + 1) {
+                throw std::invalid_argument("Failed to parse query text");
+            }
+            sink.push('$');
+            sink.push_number(parameter_number(text.substr(i + 1, end - i - 1), names, numeric, parameters_count) + 1);
+            i = end - 1;
+        }
+    }
+    if (!found) {
+        throw std::invalid_argument("Query is not defined in query conf");
+    }
+}
+
+template <class QueryT>
+constexpr auto parameter_names() {
+    using parameters_type = typename typed_query_traits<QueryT>::parameters_type;
+    if constexpr (HasMembers<parameters_type>) {
+        return hana::unpack(hana::accessors<parameters_type>(), [] (const auto& ... accessors) {
+            return std::array<std::string_view, sizeof...(accessors)> {
+                std::string_view(hana::to<const char*>(hana::first(accessors))) ...
+            };
+        });
+    } else {
+        return std::array<std::string_view, 0> {};
+    }
+}
+
+template <class QueryT>
+constexpr std::size_t parameters_count() {
+    using parameters_type = typename typed_query_traits<QueryT>::parameters_type;
+    if constexpr (HasMembers<parameters_type>) {
+        return parameter_names<QueryT>().size();
+    } else {
+        return std::tuple_size_v<parameters_type>;
+    }
+}
+
+template <std::size_t N, class Conf, class QueryT>
+constexpr auto make_text_sink(std::size_t begin, std::size_t end) {
+    text_sink<N> sink;
+    sink.begin = begin;
+    sink.end = end;
+    using parameters_type = typename typed_query_traits<QueryT>::parameters_type;
+    make_text(std::string_view(hana::to<const char*>(Conf {}), hana::length(Conf {})),
+        std::string_view(hana::to<const char*>(typed_query_name_t<QueryT> {})),
+        parameter_names<QueryT>(), !HasMembers<parameters_type>, parameters_count<QueryT>(), sink);
+    return sink;
+}
+
+template <class Conf, class QueryT>
+struct query_text {
+    static constexpr auto measure = make_text_sink<0, Conf, QueryT>(0, 0);
+    static constexpr std::size_t begin = measure.first == npos ? 0 : measure.first;
+    static constexpr std::size_t size = measure.first == npos ? 0 : measure.last - measure.first;
+    static constexpr auto value = make_text_sink<size, Conf, QueryT>(begin, begin + size);
+};
+
+template <class Conf, class QueryT, std::size_t ... I>
+constexpr auto to_hana_string(std::index_sequence<I ...>) noexcept {
+    return hana::string_c<query_text<Conf, QueryT>::value.data[I] ...>;
+}
+
+template <class Conf, class ... QueriesT>
+constexpr bool check_conf() {
+    constexpr std::array<std::string_view, sizeof...(QueriesT)> declared {
+        std::string_view(hana::to<const char*>(typed_query_name_t<QueriesT> {})) ...
+    };
+    check(std::string_view(hana::to<const char*>(Conf {}), hana::length(Conf {})), declared);
+    return true;
+}
+
+} // namespace detail::static_query_conf
+
+/**
+ * @brief Query text of a query conf parsed at compile time
+ *
+ * Produces the text of the query `QueryT` from the query conf `Conf` which is
+ * a `boost::hana::string`. The text is the same as `ozo::query_repository::make_query()`
+ * gives at runtime and `ozo::query_builder` builds for the same query, named parameters
+ * are replaced with `$N` placeholders. An invalid conf, undefined query or unknown parameter
+ * name is a compile error.
+ *
+ * @tparam QueryT --- declared query type.
+ * @tparam Conf --- query conf as `boost::hana::string`.
+ * @ingroup group-query-functions
+ */
+template <class QueryT, class Conf>
+constexpr auto make_static_query_text(Conf) noexcept {
+    static_assert(HanaString<Conf>, "query conf should be boost::hana::string");
+    using text = detail::static_query_conf::query_text<Conf, QueryT>;
+    return detail::static_query_conf::to_hana_string<Conf, QueryT>(std::make_index_sequence<text::size>());
+}
+
+/**
+ * @brief Repository of queries defined in a query conf parsed at compile time
+ *
+ * Compile-time alternative of `ozo::query_repository`: the query conf is a `boost::hana::string`,
+ * e.g. a string literal with `_s` suffix, and the whole conf is parsed and validated against
+ * the declared queries during compilation. Queries have `boost::hana::string` texts, so
+ * no parsing happens at startup and no text is built at runtime.
+ *
+ * @code
+using namespace boost::hana::literals;
+
+constexpr auto conf =
+    "-- name: get user\n"
+    "SELECT name FROM users WHERE id = :id\n"_s;
+
+constexpr auto repository = ozo::make_static_query_repository(conf, hana::tuple<GetUser>());
+ozo::request(pool[io], repository.make_query<GetUser>(GetUser::parameters_type {id}), deadline, ozo::into(result), yield);
+ * @endcode
+ *
+ * @tparam Conf --- query conf as `boost::hana::string`.
+ * @tparam QueriesT --- declared query types.
+ * @ingroup group-query-types
+ */
+template <class Conf, class ... QueriesT>
+class static_query_repository {
+    static_assert(HanaString<Conf>, "query conf should be boost::hana::string");
+    static_assert(detail::static_query_conf::check_conf<Conf, QueriesT ...>());
+
+public:
+    constexpr static_query_repository() = default;
+
+    template <class QueryT>
+    static constexpr auto text() noexcept {
+        static_assert(detail::query_index_v<QueryT, QueriesT ...> < sizeof...(QueriesT),
+            "QueryT is not declared in the query repository");
+        return make_static_query_text<QueryT>(Conf {});
+    }
+
+    template <class QueryT, class ... ParametersT,
+        typename = Require<
+            std::is_same_v<typename typed_query_traits<QueryT>::parameters_type,
+            std::tuple<std::decay_t<ParametersT> ...>>
+        >
+    >
+    constexpr auto make_query(ParametersT&& ... parameters) const {
+        return ozo::make_query(text<QueryT>(), std::forward<ParametersT>(parameters) ...);
+    }
+
+    template <class QueryT>
+    auto make_query(const typename typed_query_traits<QueryT>::parameters_type& parameters) const {
+        if constexpr (detail::HasMembers<typename typed_query_traits<QueryT>::parameters_type>) {
+            return hana::unpack(
+                hana::members(parameters),
+                [&] (const auto& ... parameters) { return ozo::make_query(text<QueryT>(), parameters ...); }
+            );
+        } else {
+            return std::apply(
+                [&] (const auto& ... parameters) { return ozo::make_query(text<QueryT>(), parameters ...); },
+                parameters
+            );
+        }
+    }
+
+    template <class QueryT>
+    auto make_query(typename typed_query_traits<QueryT>::parameters_type&& parameters) const {
+        if constexpr (detail::HasMembers<typename typed_query_traits<QueryT>::parameters_type>) {
+            return hana::unpack(
+                hana::members(std::move(parameters)),
+                [&] (auto&& ... parameters) { return ozo::make_query(text<QueryT>(), std::move(parameters) ...); }
+            );
+        } else {
+            return std::apply(
+                [&] (auto&& ... parameters) { return ozo::make_query(text<QueryT>(), std::move(parameters) ...); },
+                std::move(parameters)
+            );
+        }
+    }
+};
+
+/**
+ * @brief Make a repository of queries defined in a query conf parsed at compile time
+ *
+ * @param conf --- query conf as `boost::hana::string`.
+ * @param queries --- declared queries.
+ * @return `ozo::static_query_repository`
+ * @ingroup group-query-functions
+ */
+template <class Conf, class ... QueriesT>
+constexpr auto make_static_query_repository(Conf, const hana::tuple<QueriesT ...>& = hana::tuple<QueriesT ...>()) {
+    return static_query_repository<Conf, QueriesT ...>();
+}
+
+} // namespace ozo
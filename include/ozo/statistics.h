@@ -0,0 +1,393 @@
+#pragma once
+
+#include <ozo/time_traits.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @defgroup group-statistics Statistics
+ * @ingroup group-connection
+ * @brief Connection statistics models
+ *
+ * The `Statistics` template parameter of `ozo::connection` and `ozo::connection_info` defines
+ * statistics which are collected for a connection. A copy of the statistics object is kept
+ * by each connection, so a model which aggregates data of many connections should share
+ * its storage between copies.
+ *
+ * Connection establishing reports a duration of each `ozo::connect_phase` via
+ * `statistics.on_connect_phase(phase, duration)` member function if the statistics type provides it.
+ *
+ * Requests report `ozo::request_counter` increments, errors by `ozo::request_error_category` and
+ * `ozo::request_phase` timing points via `statistics.update(key, value)` member function overloads
+ * if the statistics type provides them. The same function is called by `update_statistics(key, value)`
+ * member function of a connection. Timing points are measured only if the statistics type accepts
+ * `ozo::request_phase`, so a connection without statistics does not pay for clock readings.
+ */
+
+namespace ozo {
+
+/**
+ * @brief Phase of a connection establishing
+ * @ingroup group-statistics
+ */
+enum class connect_phase {
+    resolve, //!< connection start: connection string parsing and host name resolution
+    connect, //!< TCP (or Unix-domain socket) connection
+    tls, //!< TLS (or GSS encryption) negotiation
+    authentication, //!< waiting for the authentication exchange with the server
+    startup, //!< backend startup after authentication, e.g. `target_session_attrs` checks
+    bootstrap, //!< oid map request and session initialization statements
+};
+
+constexpr std::size_t connect_phases_count = 6;
+
+/**
+ * Name of a connection establishing phase.
+ *
+ * @ingroup group-statistics
+ */
+constexpr std::string_view to_string(connect_phase phase) noexcept {
+    switch (phase) {
+        case connect_phase::resolve: return "resolve";
+        case connect_phase::connect: return "connect";
+        case connect_phase::tls: return "tls";
+        case connect_phase::authentication: return "authentication";
+        case connect_phase::startup: return "startup";
+        case connect_phase::bootstrap: return "bootstrap";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Lock-free latency histogram
+ *
+ * Histogram with exponential buckets: a bucket `n` counts values in range
+ * [2^(n-1), 2^n) microseconds, the bucket 0 counts values less than 1 microsecond,
+ * the last bucket counts all the values which are greater.
+ *
+ * @ingroup group-statistics
+ */
+class latency_histogram {
+public:
+    static constexpr std::size_t buckets_count = 32; //!< number of buckets
+
+    /**
+     * Add a value to the histogram.
+     */
+    void add(time_traits::duration value) noexcept {
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(value).count();
+        std::size_t n = 0;
+        for (auto v = us; v > 0 && n + 1 < buckets_count; v >>= 1) {
+            ++n;
+        }
+        buckets_[n].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(static_cast<std::uint64_t>(std::max<decltype(us)>(us, 0)), std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of values in a bucket.
+     */
+    std::uint64_t bucket(std::size_t n) const noexcept { return buckets_[n].load(std::memory_order_relaxed); }
+
+    /**
+     * Exclusive upper bound of a bucket values.
+     */
+    static constexpr std::chrono::microseconds upper_bound(std::size_t n) noexcept {
+        return std::chrono::microseconds(std::int64_t(1) << n);
+    }
+
+    /**
+     * Total number of values.
+     */
+    std::uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+
+    /**
+     * Sum of the values.
+     */
+    std::chrono::microseconds sum() const noexcept {
+        return std::chrono::microseconds(sum_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, buckets_count> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+};
+
+/**
+ * @brief Latency histograms of connection establishing phases
+ * @ingroup group-statistics
+ */
+class connect_phase_histograms {
+public:
+    void add(connect_phase phase, time_traits::duration value) noexcept {
+        phases_[static_cast<std::size_t>(phase)].add(value);
+    }
+
+    const latency_histogram& operator [](connect_phase phase) const noexcept {
+        return phases_[static_cast<std::size_t>(phase)];
+    }
+
+private:
+    std::array<latency_histogram, connect_phases_count> phases_;
+};
+
+/**
+ * @brief Statistics model which collects latency histograms of connection establishing phases
+ *
+ * Copies of the object share the histograms, so the histograms aggregate phases of all the connections
+ * made by a connection source, e.g.
+ *
+ * @code
+const ozo::connect_statistics statistics;
+const auto source = ozo::connection_info(conn_str, ozo::empty_oid_map{}, statistics);
+ozo::connection_pool pool(source, config);
+...
+const auto& authentication = statistics.histograms()[ozo::connect_phase::authentication];
+ * @endcode
+ *
+ * @ingroup group-statistics
+ */
+class connect_statistics {
+public:
+    connect_statistics() : histograms_(std::make_shared<connect_phase_histograms>()) {}
+
+    explicit connect_statistics(std::shared_ptr<connect_phase_histograms> histograms)
+    : histograms_(std::move(histograms)) {}
+
+    void on_connect_phase(connect_phase phase, time_traits::duration value) const noexcept {
+        histograms_->add(phase, value);
+    }
+
+    const connect_phase_histograms& histograms() const noexcept { return *histograms_; }
+
+private:
+    std::shared_ptr<connect_phase_histograms> histograms_;
+};
+
+/**
+ * @brief Counter of requests statistics
+ * @ingroup group-statistics
+ */
+enum class request_counter {
+    requests, //!< requests started on a connection
+    bytes_sent, //!< query text and parameters bytes sent
+    bytes_received, //!< result values bytes received
+    rows_decoded, //!< result rows passed to request outputs
+};
+
+constexpr std::size_t request_counters_count = 4;
+
+/**
+ * Name of a request counter.
+ *
+ * @ingroup group-statistics
+ */
+constexpr std::string_view to_string(request_counter counter) noexcept {
+    switch (counter) {
+        case request_counter::requests: return "requests";
+        case request_counter::bytes_sent: return "bytes_sent";
+        case request_counter::bytes_received: return "bytes_received";
+        case request_counter::rows_decoded: return "rows_decoded";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Category of a request error
+ * @ingroup group-statistics
+ */
+enum class request_error_category {
+    connection, //!< libpq or socket I/O error, the connection is most likely bad
+    timeout, //!< the request has been cancelled by the time constraint or by user
+    sql, //!< the server has reported an error with SQLSTATE
+    result, //!< unexpected result status or the result can not be converted into the output
+    other, //!< any other error
+};
+
+constexpr std::size_t request_error_categories_count = 5;
+
+/**
+ * Name of a request error category.
+ *
+ * @ingroup group-statistics
+ */
+constexpr std::string_view to_string(request_error_category category) noexcept {
+    switch (category) {
+        case request_error_category::connection: return "connection";
+        case request_error_category::timeout: return "timeout";
+        case request_error_category::sql: return "sql";
+        case request_error_category::result: return "result";
+        case request_error_category::other: return "other";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Timing point of a request
+ *
+ * Each point is reported as a duration since the request start, i.e. since the connection
+ * has been obtained and the request is about to be sent.
+ *
+ * @ingroup group-statistics
+ */
+enum class request_phase {
+    send, //!< the query has been flushed into the socket
+    first_byte, //!< the first result has been received
+    last_result, //!< all the results have been received
+    decode, //!< the result has been passed to the request output
+};
+
+constexpr std::size_t request_phases_count = 4;
+
+/**
+ * Name of a request timing point.
+ *
+ * @ingroup group-statistics
+ */
+constexpr std::string_view to_string(request_phase phase) noexcept {
+    switch (phase) {
+        case request_phase::send: return "send";
+        case request_phase::first_byte: return "first_byte";
+        case request_phase::last_result: return "last_result";
+        case request_phase::decode: return "decode";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Lock-free request counters and timing histograms
+ *
+ * All the values are updated with relaxed atomic operations, so they may be scraped
+ * concurrently with requests without any locks.
+ *
+ * @ingroup group-statistics
+ */
+class request_metrics {
+public:
+    void add(request_counter counter, std::uint64_t value) noexcept {
+        counters_[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void add(request_error_category category, std::uint64_t value) noexcept {
+        errors_[static_cast<std::size_t>(category)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void add(request_phase phase, time_traits::duration value) noexcept {
+        phases_[static_cast<std::size_t>(phase)].add(value);
+    }
+
+    /**
+     * Value of a counter.
+     */
+    std::uint64_t operator [](request_counter counter) const noexcept {
+        return counters_[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of errors of a category.
+     */
+    std::uint64_t operator [](request_error_category category) const noexcept {
+        return errors_[static_cast<std::size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Histogram of a timing point.
+     */
+    const latency_histogram& operator [](request_phase phase) const noexcept {
+        return phases_[static_cast<std::size_t>(phase)];
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, request_counters_count> counters_{};
+    std::array<std::atomic<std::uint64_t>, request_error_categories_count> errors_{};
+    std::array<latency_histogram, request_phases_count> phases_;
+};
+
+/**
+ * @brief Statistics model which collects connection establishing and requests statistics
+ *
+ * Copies of the object share the storage, so the statistics aggregate all the connections
+ * made by a connection source. A connection source per scope of interest (e.g. per host)
+ * should be used with its own statistics object to get separate values, e.g.
+ *
+ * @code
+const ozo::connection_statistics statistics;
+const auto source = ozo::connection_info(conn_str, ozo::empty_oid_map{}, statistics);
+ozo::connection_pool pool(source, config);
+...
+const auto& requests = statistics.requests();
+const auto errors = requests[ozo::request_error_category::sql];
+const auto& first_byte = requests[ozo::request_phase::first_byte];
+ * @endcode
+ *
+ * @ingroup group-statistics
+ */
+class connection_statistics {
+public:
+    connection_statistics()
+    : histograms_(std::make_shared<connect_phase_histograms>()),
+      requests_(std::make_shared<request_metrics>()) {}
+
+    connection_statistics(std::shared_ptr<connect_phase_histograms> histograms,
+            std::shared_ptr<request_metrics> requests)
+    : histograms_(std::move(histograms)), requests_(std::move(requests)) {}
+
+    void on_connect_phase(connect_phase phase, time_traits::duration value) const noexcept {
+        histograms_->add(phase, value);
+    }
+
+    void update(request_counter counter, std::uint64_t value) const noexcept {
+        requests_->add(counter, value);
+    }
+
+    void update(request_error_category category, std::uint64_t value) const noexcept {
+        requests_->add(category, value);
+    }
+
+    void update(request_phase phase, time_traits::duration value) const noexcept {
+        requests_->add(phase, value);
+    }
+
+    const connect_phase_histograms& histograms() const noexcept { return *histograms_; }
+
+    const request_metrics& requests() const noexcept { return *requests_; }
+
+private:
+    std::shared_ptr<connect_phase_histograms> histograms_;
+    std::shared_ptr<request_metrics> requests_;
+};
+
+namespace detail {
+
+template <typename Statistics, typename Key, typename Value, typename = std::void_t<>>
+struct has_statistics_update : std::false_type {};
+
+template <typename Statistics, typename Key, typename Value>
+struct has_statistics_update<Statistics, Key, Value, std::void_t<decltype(
+    std::declval<Statistics&>().update(std::declval<const Key&>(), std::declval<Value>())
+)>> : std::true_type {};
+
+} // namespace detail
+
+/**
+ * Update statistics with a value if the statistics type supports the key, otherwise do nothing.
+ *
+ * @ingroup group-statistics
+ */
+template <typename Statistics, typename Key, typename Value>
+inline void update_statistics([[maybe_unused]] Statistics& statistics, [[maybe_unused]] const Key& key,
+        [[maybe_unused]] Value&& value) noexcept {
+    if constexpr (detail::has_statistics_update<Statistics, Key, Value>::value) {
+        statistics.update(key, std::forward<Value>(value));
+    }
+}
+
+} // namespace ozo
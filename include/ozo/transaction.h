@@ -2,8 +2,13 @@
 
 #include <ozo/core/options.h>
 #include <ozo/detail/begin_statement_builder.h>
+#include <ozo/io/binary_query.h>
 #include <ozo/transaction_status.h>
 
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace ozo {
 
 /**
@@ -248,6 +253,27 @@ public:
      */
     bool is_open() const noexcept { return !is_null() && lowest_layer().is_open();}
 
+    /**
+     * Defer a statement until the next request on the transaction. The statement is sent in front
+     * of the request within a single pipeline, so it takes no additional round trip. E.g., `ozo::begin()`
+     * defers the `BEGIN` statement for the `ozo::transaction_options::pipelined` option.
+     *
+     * @note The object should be initialized for this call.
+     *
+     * @param statement --- SQL statement without parameters.
+     */
+    void defer_statement(std::string statement) {
+        deferred_statements_.push_back(std::move(statement));
+    }
+
+    /**
+     * Determine whether the transaction has statements which are not sent yet.
+     *
+     * @return true --- there are deferred statements, see `defer_statement()`.
+     * @return false --- all the statements have been sent.
+     */
+    bool has_deferred_statements() const noexcept { return !deferred_statements_.empty();}
+
     /**
      * Get the transaction options. See `ozo::transaction_options` for the details.
      *
@@ -272,14 +298,34 @@ public:
 private:
     bool is_null() const noexcept { return ozo::is_null(impl_); }
 
+    friend std::vector<std::string> take_deferred_statements(transaction& x) noexcept {
+        return std::exchange(x.deferred_statements_, {});
+    }
+
     friend struct is_null_impl<transaction>;
     handle_type impl_;
     options_type options_;
+    std::vector<std::string> deferred_statements_;
 };
 
 template <typename ...Ts>
 struct is_connection<transaction<Ts...>> : std::true_type {};
 
+/**
+ * @brief Determines whether the type is an `ozo::transaction`
+ *
+ * A transaction which handle type is a transaction itself is a nested transaction
+ * backed by a savepoint, see `ozo::begin()`.
+ *
+ * @tparam T --- type to examine.
+ * @ingroup group-transaction-types
+ */
+template <typename T>
+struct is_transaction : std::false_type {};
+
+template <typename ...Ts>
+struct is_transaction<transaction<Ts...>> : std::true_type {};
+
 namespace impl {
 // [[DEPRECATED]] for backward compatibility only
 template <typename ...Ts>
@@ -319,6 +365,42 @@ ozo::begin.with_transaction_options(ozo::make_options(Options...));
  *
  * there `%Options` are available items of `ozo::transaction_options`.
  *
+ * @par Pipelined transaction
+ *
+ * With the `ozo::transaction_options::pipelined = true` option the function does not send the
+ * `BEGIN` statement, it only gets a connection. The statement is deferred and sent in front of
+ * the first request on the transaction within a single pipeline (see `ozo::transaction::defer_statement()`),
+ * so the transaction start takes no additional round trip. If the `BEGIN` statement fails the
+ * first request completes with its error, and the error context of the connection refers to it.
+ * The last request may be pipelined with the `COMMIT` statement via the `ozo::commit()` overload
+ * which accepts a query.
+ *
+ * @code
+ozo::begin.with_transaction_options(ozo::make_options(ozo::transaction_options::pipelined = true));
+ * @endcode
+ *
+ * @par Nested transaction
+ *
+ * If the provider is a transaction itself, the function starts a nested transaction backed by
+ * a savepoint. The outer transaction should be moved into the nested one and is returned back by
+ * `ozo::commit()` or `ozo::rollback()` of the nested transaction. Neither of these operations
+ * performs I/O: the `SAVEPOINT` statement is deferred until the next request on the nested
+ * transaction, and `RELEASE SAVEPOINT` or `ROLLBACK TO SAVEPOINT` statements are deferred until
+ * the next request on the outer transaction (see `ozo::transaction::defer_statement()`). So a
+ * savepoint per processed item takes no additional round trip. Transaction options are not
+ * applicable to nested transactions and are ignored.
+ *
+ * @code
+auto transaction = ozo::begin(conn_info[io], yield);
+for (const auto& item : items) {
+    auto nested = ozo::begin(std::move(transaction), yield);
+    ozo::error_code ec;
+    ozo::execute(nested, make_insert_query(item), yield[ec]);
+    transaction = ec ? ozo::rollback(std::move(nested), yield) : ozo::commit(std::move(nested), yield);
+}
+auto conn = ozo::commit(std::move(transaction), yield);
+ * @endcode
+ *
  * @par Example
  *
  * For full example see [examples/transaction.cpp](examples/transaction.cpp).
@@ -394,6 +476,11 @@ struct initiate_async_end_transaction {
     template <typename Handler, typename ...Args>
     constexpr void operator()(Handler&& h, Args&& ...args) const;
 };
+
+struct initiate_async_end_nested_transaction {
+    template <typename Handler, typename ...Args>
+    constexpr void operator()(Handler&& h, Args&& ...args) const;
+};
 } // namespace detail
 
 #ifdef OZO_DOCUMENTATION
@@ -408,6 +495,10 @@ struct initiate_async_end_transaction {
  *
  * @note After commit the transaction object may not be used.
  *
+ * @note For a nested transaction the function defers `RELEASE SAVEPOINT` until the next request
+ *       on the outer transaction and provides the outer transaction without I/O,
+ *       see `ozo::begin()` for the details.
+ *
  * @param transaction --- open transaction to commit.
  * @param time_constraint --- operation `TimeConstraint`.
  * @param token --- operation `CompletionToken`.
@@ -440,6 +531,66 @@ decltype(auto) commit (transaction<T, Options>&& transaction, TimeConstraint t,
 template <typename ConnectionProvider, typename CompletionToken>
 decltype(auto) commit (ConnectionProvider&& provider, CompletionToken&& token);
 
+/**
+ * @brief Performs the last request of a transaction and commits it
+ *
+ * The function sends the query and the `COMMIT` statement within a single pipeline, so the commit
+ * takes no additional round trip. If the transaction has been started with the
+ * `ozo::transaction_options::pipelined` option and has no requests yet, the `BEGIN` statement is
+ * sent within the same pipeline too. The output is filled the same way as for `ozo::request()`.
+ *
+ * If the query fails, the `COMMIT` statement is not executed and the handler receives the error
+ * of the query, the connection stays in the failed transaction. If the `COMMIT` statement fails
+ * the error context of the connection refers to it.
+ *
+ * @warning The output is filled after the `COMMIT` statement has been executed by the server. If the
+ * output conversion fails, the transaction is committed anyway and the handler receives the
+ * `ozo::error::bad_result_process_after_commit` error instead of `ozo::error::bad_result_process`.
+ * The error context of the connection describes the conversion failure.
+ *
+ * For a nested transaction the query is sent with `RELEASE SAVEPOINT` instead of `COMMIT`, and the
+ * handler receives the outer transaction. If the query fails, the savepoint is rolled back with
+ * the next request on the outer transaction, so the outer transaction may be continued. If only
+ * the output conversion fails, the savepoint is released anyway and the outer transaction keeps
+ * the changes of the nested one.
+ *
+ * @note The function does not particitate in ADL since could be implemented via functional object.
+ *
+ * @note After commit the transaction object may not be used.
+ *
+ * @param transaction --- open transaction to perform request on and to commit.
+ * @param query --- `BinaryQueryConvertible` query object to request from a database.
+ * @param time_constraint --- operation `TimeConstraint`.
+ * @param out --- output object like Iterator, Container, etc.
+ * @param token --- operation `CompletionToken`.
+ * @return deduced from the `CompletionToken`.
+ *
+ * @par Example
+ *
+@code
+auto transaction = ozo::begin.with_transaction_options(
+    ozo::make_options(ozo::transaction_options::pipelined = true)
+)(conn_info[io], yield);
+// BEGIN, UPDATE and COMMIT take a single round trip
+auto conn = ozo::commit(std::move(transaction), "UPDATE users SET rating = rating + 1"_SQL, 1s,
+    std::ref(result), yield);
+@endcode
+ * @ingroup group-transaction-functions
+ */
+template <typename T, typename Options, typename BinaryQueryConvertible, typename TimeConstraint, typename Out, typename CompletionToken>
+decltype(auto) commit (transaction<T, Options>&& transaction, BinaryQueryConvertible&& query, TimeConstraint time_constraint, Out out, CompletionToken&& token);
+
+/**
+ * @brief Performs the last request of a transaction and commits it
+ *
+ * This function is time constrain free shortcut to `ozo::commit()` function.
+ * Its call is equal to `ozo::commit(std::move(transaction), query, ozo::none, out, token)` call.
+ *
+ * @ingroup group-transaction-functions
+ */
+template <typename T, typename Options, typename BinaryQueryConvertible, typename Out, typename CompletionToken>
+decltype(auto) commit (transaction<T, Options>&& transaction, BinaryQueryConvertible&& query, Out out, CompletionToken&& token);
+
 #endif
 //! @cond
 struct commit_op {
@@ -447,9 +598,15 @@ struct commit_op {
     auto operator() (transaction<T, Options>&& transaction, TimeConstraint t, CompletionToken&& token) const {
         static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
         using namespace ozo::literals;
-        return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
-            detail::initiate_async_end_transaction{}, token,
-            std::move(transaction), "COMMIT"_SQL, t);
+        if constexpr (is_transaction<T>::value) {
+            return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
+                detail::initiate_async_end_nested_transaction{}, token,
+                std::move(transaction), true);
+        } else {
+            return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
+                detail::initiate_async_end_transaction{}, token,
+                std::move(transaction), "COMMIT"_SQL, t);
+        }
     }
 
     template <typename... Ts, typename CompletionToken>
@@ -460,6 +617,26 @@ struct commit_op {
             std::forward<CompletionToken>(token)
         );
     }
+
+    template <typename T, typename Options, typename Q, typename TimeConstraint, typename Out, typename CompletionToken>
+    auto operator() (transaction<T, Options>&& transaction, Q&& query, TimeConstraint t, Out out, CompletionToken&& token) const {
+        static_assert(BinaryQueryConvertible<Q>, "query should be convertible to the binary_query");
+        static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+        return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
+            detail::initiate_async_end_transaction{}, token,
+            std::move(transaction), t, std::forward<Q>(query), std::move(out));
+    }
+
+    template <typename T, typename Options, typename Q, typename Out, typename CompletionToken>
+    auto operator() (transaction<T, Options>&& transaction, Q&& query, Out out, CompletionToken&& token) const {
+        return (*this)(
+            std::move(transaction),
+            std::forward<Q>(query),
+            none,
+            std::move(out),
+            std::forward<CompletionToken>(token)
+        );
+    }
 };
 
 inline constexpr commit_op commit;
@@ -478,6 +655,10 @@ inline constexpr commit_op commit;
  *
  * @note After rollback the transaction object may not be used.
  *
+ * @note For a nested transaction the function defers `ROLLBACK TO SAVEPOINT` until the next request
+ *       on the outer transaction and provides the outer transaction without I/O,
+ *       see `ozo::begin()` for the details.
+ *
  * @param transaction --- open transaction to rollback.
  * @param time_constraint --- operation `TimeConstraint`.
  * @param token --- operation `CompletionToken`.
@@ -519,9 +700,15 @@ struct rollback_op {
     auto operator() (transaction<T, Options>&& transaction, TimeConstraint t, CompletionToken&& token) const {
         static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
         using namespace ozo::literals;
-        return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
-            detail::initiate_async_end_transaction{}, token,
-            std::move(transaction), "ROLLBACK"_SQL, t);
+        if constexpr (is_transaction<T>::value) {
+            return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
+                detail::initiate_async_end_nested_transaction{}, token,
+                std::move(transaction), false);
+        } else {
+            return async_initiate<CompletionToken, handler_signature<typename ozo::transaction<T, Options>::handle_type>>(
+                detail::initiate_async_end_transaction{}, token,
+                std::move(transaction), "ROLLBACK"_SQL, t);
+        }
     }
 
     template <typename... Ts, typename CompletionToken>
@@ -66,6 +66,7 @@ struct transaction_options {
     constexpr static option<class isolation_level_tag> isolation_level{}; //!< Transaction isolation level, see ozo::isolation_level
     constexpr static option<class mode_tag> mode{}; //!< Transaction mode, see ozo::transaction_mode
     constexpr static option<class deferrability_tag> deferrability{}; //!< Transaction deferrability, see ozo::deferrable_mode
+    constexpr static option<class pipelined_tag> pipelined{}; //!< Defer BEGIN statement until the first request on the transaction, boolean value
 };
 
 } // ozo
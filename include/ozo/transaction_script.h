@@ -0,0 +1,137 @@
+#pragma once
+
+#include <ozo/impl/transaction_script.h>
+
+namespace ozo {
+
+#ifdef OZO_DOCUMENTATION
+/**
+ * @brief Executes queries within a transaction in a single round trip
+ *
+ * The function executes a short transaction of a fixed shape (e.g. read, check, update and insert)
+ * as a single script: the `BEGIN` statement, the queries and the `COMMIT` statement are sent within
+ * a single pipeline, so the whole transaction takes one round trip instead of one per statement.
+ * If libpq does not support the pipeline mode, the statements are sent one after another.
+ *
+ * The result of each query is passed into the output with the same index. Use `ozo::none` as an
+ * output for queries without results. The handler receives the connection after the transaction
+ * end.
+ *
+ * If any statement fails, the following statements and the `COMMIT` statement are not executed,
+ * the transaction is rolled back and the handler receives the error of the failed statement.
+ * The error context of the connection names the failed statement. The rollback is limited by
+ * the rest of the time constraint.
+ *
+ * @warning The outputs are filled while the server executes the script, so an output conversion
+ * failure can not prevent the `COMMIT` statement. In this case the transaction is committed and the
+ * handler receives the `ozo::error::bad_result_process_after_commit` error, the error context of the
+ * connection describes the conversion failure.
+ *
+ * @note The function does not particitate in ADL since could be implemented via functional object.
+ *
+ * @param provider --- #ConnectionProvider to get connection from, should not be a transaction.
+ * @param queries --- `std::tuple` of `BinaryQueryConvertible` queries to execute.
+ * @param time_constraint --- operation #TimeConstraint; this time constrain <b>includes</b> time for getting connection from provider.
+ * @param outs --- `std::tuple` of outputs for the query results, see `ozo::request()` for the output types.
+ * @param token --- operation #CompletionToken.
+ * @return deduced from #CompletionToken.
+ *
+ * @par Transaction options
+ *
+ * The transaction may be executed with the isolation level, mode and deferrability options
+ * of `ozo::transaction_options` in the same way as with `ozo::begin()`:
+ *
+ * @code
+ozo::transaction_script.with_transaction_options(ozo::make_options(Options...));
+ * @endcode
+ *
+ * @par Example
+ *
+ * @code
+ozo::rows_of<std::int64_t> balance;
+ozo::transaction_script.with_transaction_options(
+    ozo::make_options(ozo::transaction_options::isolation_level = ozo::isolation_level::serializable)
+)(
+    conn_info[io],
+    std::make_tuple(
+        "SELECT balance FROM accounts WHERE id = "_SQL + from + " FOR UPDATE"_SQL,
+        "UPDATE accounts SET balance = balance - "_SQL + amount + " WHERE id = "_SQL + from,
+        "UPDATE accounts SET balance = balance + "_SQL + amount + " WHERE id = "_SQL + to
+    ),
+    std::chrono::seconds(1),
+    std::make_tuple(ozo::into(balance), ozo::none, ozo::none),
+    yield
+);
+ * @endcode
+ * @ingroup group-transaction-functions
+ */
+template <typename ConnectionProvider, typename Queries, typename TimeConstraint, typename Outs, typename CompletionToken>
+decltype(auto) transaction_script(ConnectionProvider&& provider, Queries&& queries, TimeConstraint time_constraint,
+        Outs&& outs, CompletionToken&& token);
+
+/**
+ * @brief Executes queries within a transaction in a single round trip
+ *
+ * This function is time constrain free shortcut to `ozo::transaction_script()` function.
+ * Its call is equal to `ozo::transaction_script(provider, queries, ozo::none, outs, token)` call.
+ *
+ * @note The function does not particitate in ADL since could be implemented via functional object.
+ *
+ * @param provider --- #ConnectionProvider to get connection from, should not be a transaction.
+ * @param queries --- `std::tuple` of `BinaryQueryConvertible` queries to execute.
+ * @param outs --- `std::tuple` of outputs for the query results.
+ * @param token --- operation #CompletionToken.
+ * @return deduced from #CompletionToken.
+ * @ingroup group-transaction-functions
+ */
+template <typename ConnectionProvider, typename Queries, typename Outs, typename CompletionToken>
+decltype(auto) transaction_script(ConnectionProvider&& provider, Queries&& queries, Outs&& outs, CompletionToken&& token);
+#else
+
+template <typename Initiator, typename Options = decltype(make_options())>
+struct transaction_script_op : base_async_operation <transaction_script_op<Initiator, Options>, Initiator> {
+    using base = typename transaction_script_op::base;
+    Options options_;
+
+    constexpr explicit transaction_script_op(Initiator initiator = {}, Options options = {}) : base(initiator), options_(options) {}
+
+    template <typename P, typename Queries, typename TimeConstraint, typename Outs, typename CompletionToken>
+    decltype(auto) operator() (P&& provider, Queries&& queries, TimeConstraint t, Outs&& outs, CompletionToken&& token) const {
+        static_assert(ConnectionProvider<P>, "provider should be a ConnectionProvider");
+        static_assert(ozo::TimeConstraint<TimeConstraint>, "should model TimeConstraint concept");
+        return async_initiate<CompletionToken, handler_signature<P>>(
+            get_operation_initiator(*this), token, std::forward<P>(provider), t,
+            detail::begin_statement_builder::build(options_), std::forward<Queries>(queries), std::forward<Outs>(outs));
+    }
+
+    template <typename P, typename Queries, typename Outs, typename CompletionToken>
+    decltype(auto) operator() (P&& provider, Queries&& queries, Outs&& outs, CompletionToken&& token) const {
+        return (*this)(std::forward<P>(provider), std::forward<Queries>(queries), none, std::forward<Outs>(outs),
+            std::forward<CompletionToken>(token));
+    }
+
+    template <typename OtherOptions>
+    constexpr auto with_transaction_options(const OtherOptions& options) const {
+        return transaction_script_op<Initiator, OtherOptions>{get_operation_initiator(*this), options};
+    }
+
+    template <typename OtherInitiator>
+    constexpr auto rebind_initiator(const OtherInitiator& other) const {
+        return transaction_script_op<OtherInitiator, Options>{other, options_};
+    }
+};
+
+namespace detail {
+struct initiate_async_transaction_script {
+    template <typename Handler, typename P, typename TimeConstraint, typename BeginQuery, typename Queries, typename Outs>
+    constexpr void operator()(Handler&& h, P&& provider, TimeConstraint t, BeginQuery&& begin, Queries&& queries, Outs&& outs) const {
+        impl::async_transaction_script(std::forward<P>(provider), std::forward<BeginQuery>(begin),
+            std::forward<Queries>(queries), t, std::forward<Outs>(outs), std::forward<Handler>(h));
+    }
+};
+} // namespace detail
+
+inline constexpr transaction_script_op<detail::initiate_async_transaction_script> transaction_script;
+#endif
+
+} // namespace ozo
@@ -16,7 +16,9 @@
 #include <boost/hana/pair.hpp>
 #include <boost/hana/type.hpp>
 #include <boost/hana/not_equal.hpp>
+#include <boost/hana/unpack.hpp>
 
+#include <array>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -630,6 +632,45 @@ inline auto type_oid(const OidMap& map, const T&) noexcept{
 }
 #endif
 
+namespace detail {
+
+/**
+ * OIDs of a sequence of types which are known at compile time if all the types are built-in.
+ */
+template <typename ...Ts>
+struct static_type_oids {
+    static constexpr bool value = (BuiltIn<Ts> && ...);
+
+    static constexpr std::array<oid_t, sizeof...(Ts)> make() noexcept {
+        if constexpr (value) {
+            return {oid_t(typename type_traits<Ts>::oid())...};
+        } else {
+            return {};
+        }
+    }
+
+    static constexpr std::array<oid_t, sizeof...(Ts)> oids = make();
+};
+
+struct static_type_oids_of {
+    template <typename ...Ts>
+    auto operator ()(const Ts& ...) const -> static_type_oids<std::decay_t<Ts>...>;
+};
+
+} // namespace detail
+
+/**
+ * @brief OIDs of parameters of a sequence which are known at compile time
+ *
+ * `value` is `true` if all the parameter types are built-in, then `oids` is a static array
+ * with the OIDs of the parameters, so there is no need to get them from an #OidMap.
+ *
+ * @tparam Params --- parameters sequence type, should model #HanaSequence.
+ * @ingroup group-type_system-types
+ */
+template <typename Params>
+using static_type_oids = decltype(hana::unpack(std::declval<const Params&>(), detail::static_type_oids_of{}));
+
 /**
 * Function returns true if type can be obtained from DB response with
 * specified OID.
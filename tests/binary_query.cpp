@@ -6,6 +6,14 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+struct cached_binary_query_custom_type {};
+
+OZO_PG_DEFINE_CUSTOM_TYPE(cached_binary_query_custom_type, "cached_binary_query_custom_type")
+
+OZO_STRONG_TYPEDEF(std::string, binary_query_custom_string)
+
+OZO_PG_DEFINE_CUSTOM_TYPE(binary_query_custom_string, "binary_query_custom_string")
+
 namespace {
 
 namespace hana = boost::hana;
@@ -48,6 +56,21 @@ TEST_F(binary_query_types, for_param_should_be_equal_to_type_oid) {
     EXPECT_EQ(query.types()[0], ozo::type_traits<std::int16_t>::oid());
 }
 
+TEST_F(binary_query_types, for_built_in_params_should_be_shared_static_array) {
+    const auto first = make_binary_query("", hana::make_tuple(std::int16_t(), std::string()));
+    const auto second = make_binary_query("", hana::make_tuple(std::int16_t(1), std::string("text")));
+    EXPECT_EQ(first.types(), second.types());
+    EXPECT_EQ(first.types()[1], ozo::type_traits<std::string>::oid());
+}
+
+TEST_F(binary_query_types, for_custom_type_param_should_be_equal_to_oid_map_value) {
+    auto oid_map = ozo::register_types<binary_query_custom_string>();
+    ozo::set_type_oid<binary_query_custom_string>(oid_map, 100500);
+    const auto query = ozo::binary_query("", hana::make_tuple(std::int16_t(), binary_query_custom_string {}), oid_map);
+    EXPECT_EQ(query.types()[0], ozo::type_traits<std::int16_t>::oid());
+    EXPECT_EQ(query.types()[1], 100500u);
+}
+
 TEST_F(binary_query_types, for_nullptr_should_be_equal_to_0) {
     const auto query = make_binary_query("", hana::make_tuple(nullptr));
     EXPECT_EQ(query.types()[0], 0u);
@@ -173,4 +196,58 @@ TEST_F(binary_query_values, for_std_reference_wrapper_value_should_be_equal_to_b
         ElementsAre('s', 't', 'r', 'i', 'n', 'g'));
 }
 
+struct cached_binary_query : Test {
+    ozo::cached_binary_query<decltype(ozo::make_query("query", 42))> query{ozo::make_query("query", 42)};
+};
+
+TEST_F(cached_binary_query, should_return_same_representation_for_equal_oid_maps) {
+    const auto first = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    const auto second = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    EXPECT_TRUE(query.cached());
+    EXPECT_EQ(first.values(), second.values());
+    EXPECT_STREQ(second.text(), "query");
+}
+
+TEST_F(cached_binary_query, should_share_representation_between_copies) {
+    const auto copy = query;
+    const auto first = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    const auto second = ozo::to_binary_query(copy, ozo::empty_oid_map{});
+    EXPECT_EQ(first.values(), second.values());
+}
+
+TEST_F(cached_binary_query, should_convert_query_again_for_oid_map_of_other_type) {
+    const auto first = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    const auto second = ozo::to_binary_query(query, ozo::register_types<cached_binary_query_custom_type>());
+    EXPECT_NE(first.values(), second.values());
+    EXPECT_EQ(second.params_count(), 1);
+}
+
+TEST_F(cached_binary_query, should_convert_query_again_for_oid_map_with_other_oids) {
+    auto oid_map = ozo::register_types<cached_binary_query_custom_type>();
+    const auto first = ozo::to_binary_query(query, oid_map);
+    ozo::set_type_oid<cached_binary_query_custom_type>(oid_map, 100500);
+    const auto second = ozo::to_binary_query(query, oid_map);
+    const auto third = ozo::to_binary_query(query, ozo::register_types<cached_binary_query_custom_type>());
+    EXPECT_NE(first.values(), second.values());
+    EXPECT_EQ(first.values(), third.values());
+}
+
+TEST(cache_binary_query, should_wrap_query) {
+    const auto query = ozo::cache_binary_query(ozo::make_query("query", 42));
+    EXPECT_TRUE((std::is_same_v<std::decay_t<decltype(query)>,
+        ozo::cached_binary_query<decltype(ozo::make_query("query", 42))>>));
+    EXPECT_FALSE(query.cached());
+}
+
+TEST(cache_binary_query, should_not_wrap_binary_query_and_cached_binary_query) {
+    EXPECT_TRUE((std::is_same_v<ozo::cache_binary_query_t<ozo::binary_query>, ozo::binary_query>));
+    using cached = ozo::cached_binary_query<decltype(ozo::make_query("query"))>;
+    EXPECT_TRUE((std::is_same_v<ozo::cache_binary_query_t<cached>, cached>));
+}
+
+TEST(cache_binary_query, should_not_wrap_non_query_types) {
+    EXPECT_TRUE((std::is_same_v<ozo::cache_binary_query_t<const std::string&>, std::string>));
+    EXPECT_TRUE((std::is_same_v<ozo::cache_binary_query_t<int>, int>));
+}
+
 } // namespace
@@ -85,11 +85,44 @@ struct PGconn_mock {
         );
     }
 
+    MOCK_METHOD6(PQsendQueryPrepared, int(
+                      const char*, int, const char* const*,
+                      const int*, const int*, int));
+    friend int PQsendQueryPrepared(PGconn_mock* self,
+                      const char *stmtName,
+                      int nParams,
+                      const char * const *paramValues,
+                      const int *paramLengths,
+                      const int *paramFormats,
+                      int resultFormat) {
+        return mock(self).PQsendQueryPrepared(
+            stmtName, nParams, paramValues,
+            paramLengths, paramFormats, resultFormat
+        );
+    }
+
     MOCK_METHOD0(PQgetResult, pg_result*());
     friend pg_result* PQgetResult(PGconn_mock* self) {
         return mock(self).PQgetResult();
     }
 
+#ifdef LIBPQ_HAS_PIPELINING
+    MOCK_METHOD0(PQenterPipelineMode, int());
+    friend int PQenterPipelineMode(PGconn_mock* self) {
+        return mock(self).PQenterPipelineMode();
+    }
+
+    MOCK_METHOD0(PQpipelineSync, int());
+    friend int PQpipelineSync(PGconn_mock* self) {
+        return mock(self).PQpipelineSync();
+    }
+
+    MOCK_METHOD0(PQexitPipelineMode, int());
+    friend int PQexitPipelineMode(PGconn_mock* self) {
+        return mock(self).PQexitPipelineMode();
+    }
+#endif
+
 private:
     static PGconn_mock& mock(PGconn_mock* self) { return self ? *self : null_mock();}
     static PGconn_mock& null_mock() {
@@ -107,6 +140,11 @@ private:
         ON_CALL(mock, PQconsumeInput()).WillByDefault(::testing::Return(0));
         ON_CALL(mock, PQconnectPoll()).WillByDefault(::testing::Return(PGRES_POLLING_FAILED));
         ON_CALL(mock, PQsendQueryParams(_, _, _, _, _, _, _)).WillByDefault(::testing::Return(0));
+#ifdef LIBPQ_HAS_PIPELINING
+        ON_CALL(mock, PQenterPipelineMode()).WillByDefault(::testing::Return(0));
+        ON_CALL(mock, PQpipelineSync()).WillByDefault(::testing::Return(0));
+        ON_CALL(mock, PQexitPipelineMode()).WillByDefault(::testing::Return(0));
+#endif
         return mock;
     }
 };
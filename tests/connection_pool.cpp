@@ -3,10 +3,16 @@
 
 #include <ozo/connection_info.h>
 #include <ozo/connection_pool.h>
+#include <ozo/impl/request_statistics.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
 namespace {
 
 TEST(make_connection_pool, should_not_throw) {
@@ -16,8 +22,51 @@ TEST(make_connection_pool, should_not_throw) {
     EXPECT_NO_THROW(ozo::make_connection_pool(conn_info, config));
 }
 
+struct connection_source_with_statistics {
+    using connection_type = std::shared_ptr<ozo::connection<ozo::empty_oid_map, ozo::connection_statistics>>;
+
+    ozo::connection_statistics statistics;
+
+    template <typename TimeConstraint, typename Handler>
+    void operator()(ozo::io_context& io, TimeConstraint, Handler&& h) const {
+        std::forward<Handler>(h)(ozo::error_code{}, std::make_shared<connection_type::element_type>(io, statistics));
+    }
+};
+
+TEST(connection_pool, request_on_pooled_connection_should_update_statistics_of_source_connection) {
+    boost::asio::io_context io;
+    connection_source_with_statistics source;
+    ozo::connection_pool pool(source, ozo::connection_pool_config{});
+
+    bool called = false;
+    pool(io, ozo::none, [&] (ozo::error_code ec, auto conn) {
+        called = true;
+        ASSERT_FALSE(ec);
+        ozo::impl::update_request_statistics(conn, ozo::request_counter::requests, 1);
+    });
+    io.run();
+
+    ASSERT_TRUE(called);
+    EXPECT_EQ(source.statistics.requests()[ozo::request_counter::requests], 1u);
+}
+
 } //namespace
 
+namespace ozo::detail {
+template <>
+struct connection_stream<ozo::tests::executor> {
+    using type = ozo::tests::stream_descriptor;
+
+    static type get(const ozo::tests::executor& ex, type::native_handle_type fd) {
+        return type{ex.context(), fd};
+    }
+
+    static type get(const ozo::tests::executor& ex) {
+        return type{ex.context()};
+    }
+};
+} // namespace ozo::detail
+
 namespace ozo::tests {
 
 struct pool_handle_mock {
@@ -27,6 +76,10 @@ struct pool_handle_mock {
         using error_context_type = std::string;
         using statistics_type = ozo::none_t;
 
+        value_type(native_conn_handle safe_handle, ozo::empty_oid_map oid_map, error_context_type error_context,
+                statistics_type = ozo::none)
+        : safe_handle_(std::move(safe_handle)), oid_map_(oid_map), error_context_(std::move(error_context)) {}
+
         native_conn_handle safe_handle_;
         ozo::empty_oid_map oid_map_;
         error_context_type error_context_;
@@ -47,6 +100,12 @@ struct pool_handle_mock {
         void set_error_context(error_context_type v) {
             error_context_ = std::move(v);
         }
+
+        ozo::detail::pooled_stream<executor> stream_;
+
+        auto& bind_stream(const executor& ex) { return stream_.bind(ex, safe_handle_.get()); }
+        void release_stream() noexcept { stream_.release(); }
+        void cancel_stream() noexcept { stream_.cancel(); }
     };
 
     MOCK_CONST_METHOD0(empty, bool());
@@ -121,20 +180,6 @@ struct unwrap_impl<ozo::tests::connection_pool::handle> {
     }
 };
 
-namespace detail {
-template <>
-struct connection_stream<ozo::tests::executor> {
-    using type = ozo::tests::stream_descriptor;
-
-    static type get(const ozo::tests::executor& ex, type::native_handle_type fd) {
-        return type{ex.context(), fd};
-    }
-
-    static type get(const ozo::tests::executor& ex) {
-        return type{ex.context()};
-    }
-};
-} // namespace detail
 } // namespace ozo
 
 namespace {
@@ -235,6 +280,576 @@ TEST_F(pooled_connection, should_not_check_connection_status_and_call_waste_on_d
     }
 }
 
+TEST_F(pooled_connection, should_keep_socket_registered_between_checkouts_for_the_same_execution_context) {
+    EXPECT_CALL(handle_mock, value()).WillRepeatedly(ReturnRef(value));
+    EXPECT_CALL(handle_mock, empty()).WillRepeatedly(Return(false));
+    EXPECT_CALL(conn_handle, PQsocket()).WillRepeatedly(Return(42));
+    EXPECT_CALL(conn_handle, PQstatus()).WillRepeatedly(Return(CONNECTION_OK));
+    EXPECT_CALL(conn_handle, PQtransactionStatus()).WillRepeatedly(Return(PQTRANS_IDLE));
+
+    Sequence s;
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(socket));
+    EXPECT_CALL(socket, assign(42)).InSequence(s);
+    EXPECT_CALL(socket, release()).InSequence(s).WillOnce(Return(42));
+
+    {
+        impl p(io.get_executor(), connection_pool::handle{&handle_mock});
+    }
+    {
+        impl p(io.get_executor(), connection_pool::handle{&handle_mock});
+    }
+}
+
+TEST_F(pooled_connection, should_register_socket_again_for_executor_of_another_execution_context) {
+    io_context other_io;
+    StrictMock<stream_descriptor_mock> other_socket {};
+
+    EXPECT_CALL(handle_mock, value()).WillRepeatedly(ReturnRef(value));
+    EXPECT_CALL(handle_mock, empty()).WillRepeatedly(Return(false));
+    EXPECT_CALL(conn_handle, PQsocket()).WillRepeatedly(Return(42));
+    EXPECT_CALL(conn_handle, PQstatus()).WillRepeatedly(Return(CONNECTION_OK));
+    EXPECT_CALL(conn_handle, PQtransactionStatus()).WillRepeatedly(Return(PQTRANS_IDLE));
+
+    Sequence s;
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(socket));
+    EXPECT_CALL(socket, assign(42)).InSequence(s);
+    EXPECT_CALL(socket, release()).InSequence(s).WillOnce(Return(42));
+    EXPECT_CALL(other_io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(other_socket));
+    EXPECT_CALL(other_socket, assign(42)).InSequence(s);
+
+    {
+        impl p(io.get_executor(), connection_pool::handle{&handle_mock});
+    }
+    {
+        impl p(other_io.get_executor(), connection_pool::handle{&handle_mock});
+    }
+
+    EXPECT_CALL(other_socket, release()).WillOnce(Return(42));
+    value.release_stream();
+}
+
+TEST_F(pooled_connection, cancel_should_cancel_bound_stream) {
+    EXPECT_CALL(handle_mock, value()).WillRepeatedly(ReturnRef(value));
+    EXPECT_CALL(handle_mock, empty()).WillRepeatedly(Return(false));
+    EXPECT_CALL(conn_handle, PQsocket()).WillRepeatedly(Return(42));
+    EXPECT_CALL(conn_handle, PQstatus()).WillRepeatedly(Return(CONNECTION_OK));
+    EXPECT_CALL(conn_handle, PQtransactionStatus()).WillRepeatedly(Return(PQTRANS_IDLE));
+
+    Sequence s;
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(socket));
+    EXPECT_CALL(socket, assign(42)).InSequence(s);
+    EXPECT_CALL(socket, cancel(_)).InSequence(s);
+    EXPECT_CALL(socket, release()).InSequence(s).WillOnce(Return(42));
+
+    impl p(io.get_executor(), connection_pool::handle{&handle_mock});
+    p.cancel();
+    value.release_stream();
+}
+
+TEST_F(pooled_connection, cancel_should_not_bind_released_stream) {
+    EXPECT_CALL(handle_mock, value()).WillRepeatedly(ReturnRef(value));
+    EXPECT_CALL(handle_mock, empty()).WillRepeatedly(Return(false));
+    EXPECT_CALL(conn_handle, PQsocket()).WillRepeatedly(Return(42));
+    EXPECT_CALL(conn_handle, PQstatus()).WillRepeatedly(Return(CONNECTION_OK));
+    EXPECT_CALL(conn_handle, PQtransactionStatus()).WillRepeatedly(Return(PQTRANS_IDLE));
+
+    Sequence s;
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(socket));
+    EXPECT_CALL(socket, assign(42)).InSequence(s);
+    EXPECT_CALL(socket, release()).InSequence(s).WillOnce(Return(42));
+
+    impl p(io.get_executor(), connection_pool::handle{&handle_mock});
+    value.release_stream();
+    p.cancel();
+}
+
+TEST(block_cache, should_reuse_deallocated_block_of_the_same_size) {
+    ozo::detail::block_cache<ozo::detail::stub_mutex> cache(1);
+    void* block = cache.allocate(64);
+    cache.deallocate(block, 64);
+    EXPECT_EQ(cache.allocate(64), block);
+    cache.deallocate(block, 64);
+}
+
+TEST(block_cache, should_not_keep_blocks_more_than_capacity) {
+    ozo::detail::block_cache<ozo::detail::stub_mutex> cache(1);
+    void* first = cache.allocate(64);
+    void* second = cache.allocate(64);
+    cache.deallocate(first, 64);
+    cache.deallocate(second, 64);
+    EXPECT_EQ(cache.allocate(64), first);
+    cache.deallocate(first, 64);
+}
+
+TEST(block_cache, should_not_keep_blocks_of_other_size) {
+    ozo::detail::block_cache<ozo::detail::stub_mutex> cache(1);
+    void* block = cache.allocate(64);
+    void* other = cache.allocate(128);
+    cache.deallocate(other, 128);
+    cache.deallocate(block, 64);
+    EXPECT_EQ(cache.allocate(64), block);
+    cache.deallocate(block, 64);
+}
+
+struct idle_connections : Test {
+    struct handle {
+        int id = 0;
+        int* wasted = nullptr;
+
+        void waste() { ++*wasted; }
+    };
+
+    using time_point = ozo::time_traits::time_point;
+    using connection_selection = ozo::connection_selection;
+
+    int wasted = 0;
+    int first_context = 0;
+    int second_context = 0;
+    const time_point now{std::chrono::seconds(10)};
+    const time_point alive{std::chrono::seconds(20)};
+    ozo::detail::idle_connections<handle> idle{3};
+
+    void park(int id, const void* context, time_point expires_at) {
+        handle h{id, std::addressof(wasted)};
+        EXPECT_TRUE(idle.park(h, context, expires_at, now - std::chrono::seconds(1)));
+    }
+
+    int pick(connection_selection selection, const void* context) {
+        const auto h = idle.pick(selection, context, now);
+        return h ? h->id : 0;
+    }
+};
+
+TEST_F(idle_connections, should_pick_the_most_recently_parked_connection_for_lifo) {
+    park(1, &first_context, alive);
+    park(2, &first_context, alive);
+    EXPECT_EQ(pick(connection_selection::lifo, &first_context), 2);
+    EXPECT_EQ(pick(connection_selection::lifo, &first_context), 1);
+}
+
+TEST_F(idle_connections, should_pick_the_least_recently_parked_connection_for_fifo) {
+    park(1, &first_context, alive);
+    park(2, &first_context, alive);
+    EXPECT_EQ(pick(connection_selection::fifo, &first_context), 1);
+    EXPECT_EQ(pick(connection_selection::fifo, &first_context), 2);
+}
+
+TEST_F(idle_connections, should_pick_the_most_recently_parked_connection_of_the_same_context_for_affinity) {
+    park(1, &first_context, alive);
+    park(2, &second_context, alive);
+    park(3, &first_context, alive);
+    EXPECT_EQ(pick(connection_selection::affinity, &second_context), 2);
+    EXPECT_EQ(pick(connection_selection::affinity, &first_context), 3);
+}
+
+TEST_F(idle_connections, should_pick_the_most_recently_parked_connection_for_affinity_if_there_is_no_one_of_the_same_context) {
+    park(1, &first_context, alive);
+    park(2, &first_context, alive);
+    EXPECT_EQ(pick(connection_selection::affinity, &second_context), 2);
+}
+
+TEST_F(idle_connections, should_waste_expired_connections_and_pick_alive_one) {
+    park(1, &first_context, alive);
+    park(2, &first_context, now);
+    EXPECT_EQ(pick(connection_selection::lifo, &first_context), 1);
+    EXPECT_EQ(wasted, 1);
+    EXPECT_TRUE(idle.empty());
+}
+
+TEST_F(idle_connections, should_waste_expired_connections_which_are_not_selected_by_lifo) {
+    park(1, &first_context, now);
+    park(2, &first_context, alive);
+    EXPECT_EQ(pick(connection_selection::lifo, &first_context), 2);
+    EXPECT_EQ(wasted, 1);
+    EXPECT_TRUE(idle.empty());
+}
+
+TEST_F(idle_connections, should_waste_expired_connections_on_park) {
+    park(1, &first_context, now);
+    park(2, &first_context, alive);
+    handle h{3, std::addressof(wasted)};
+    EXPECT_TRUE(idle.park(h, &first_context, alive, now));
+    EXPECT_EQ(wasted, 1);
+    EXPECT_EQ(idle.size(), 2u);
+    EXPECT_EQ(pick(connection_selection::fifo, &first_context), 2);
+}
+
+TEST_F(idle_connections, should_pick_nothing_if_empty) {
+    EXPECT_EQ(pick(connection_selection::lifo, &first_context), 0);
+}
+
+TEST_F(idle_connections, should_not_park_connection_more_than_capacity) {
+    park(1, &first_context, alive);
+    park(2, &first_context, alive);
+    park(3, &first_context, alive);
+    handle h{4, std::addressof(wasted)};
+    EXPECT_FALSE(idle.park(h, &first_context, alive, now));
+    EXPECT_EQ(idle.size(), 3u);
+}
+
+struct connection_pool_state : Test {
+    struct rep {
+        int id = 0;
+        ozo::time_traits::time_point created_at_ = ozo::time_traits::now();
+
+        ozo::time_traits::time_point created_at() const noexcept { return created_at_;}
+    };
+
+    using state_type = ozo::detail::connection_pool_state<rep, ozo::thread_safety<false>>;
+    using handle = ozo::detail::pooled_handle<state_type::handle_type>;
+
+    struct result {
+        ozo::error_code ec;
+        std::optional<handle> value;
+    };
+
+    boost::asio::io_context io;
+    ozo::connection_pool_config config = [] {
+        ozo::connection_pool_config v;
+        v.capacity = 1;
+        v.queue_capacity = 10;
+        return v;
+    } ();
+
+    auto make_state() {
+        return std::make_shared<state_type>(config);
+    }
+
+    auto get(state_type& state, std::vector<std::string>& log, std::string name,
+            ozo::connection_priority priority, ozo::time_traits::time_point at = ozo::time_traits::time_point::max()) {
+        auto out = std::make_shared<result>();
+        state.get(io, at, priority, [&log, name, out] (ozo::error_code ec, handle&& h) {
+            log.push_back(name);
+            out->ec = ec;
+            out->value.emplace(std::move(h));
+        });
+        return out;
+    }
+
+    void run() {
+        io.restart();
+        io.run();
+    }
+};
+
+TEST_F(connection_pool_state, should_provide_released_connection_to_waiting_requests_in_priority_order) {
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    ASSERT_FALSE(first->ec);
+    first->value->reset(rep{1});
+
+    auto low = get(*state, log, "low", ozo::connection_priority::low);
+    auto high = get(*state, log, "high", ozo::connection_priority::high);
+    auto normal = get(*state, log, "normal", ozo::connection_priority::normal);
+    run();
+    EXPECT_EQ(state->stats().queue_size, 3u);
+
+    first->value.reset();
+    run();
+    high->value.reset();
+    run();
+    normal->value.reset();
+    run();
+
+    EXPECT_THAT(log, ElementsAre("first", "high", "normal", "low"));
+    ASSERT_FALSE(low->ec);
+    EXPECT_EQ((**low->value).id, 1);
+}
+
+TEST_F(connection_pool_state, should_reject_request_if_queue_quota_of_its_priority_is_exceeded) {
+    config.queue_quota[std::size_t(ozo::connection_priority::low)] = 0;
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+
+    auto low = get(*state, log, "low", ozo::connection_priority::low);
+    run();
+
+    EXPECT_EQ(low->ec, ozo::error_code(yamail::resource_pool::error::request_queue_overflow));
+}
+
+TEST_F(connection_pool_state, should_reject_request_if_queue_capacity_is_exceeded) {
+    config.queue_capacity = 1;
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+
+    auto queued = get(*state, log, "queued", ozo::connection_priority::normal);
+    auto rejected = get(*state, log, "rejected", ozo::connection_priority::high);
+    run();
+
+    EXPECT_THAT(log, ElementsAre("first", "rejected"));
+    EXPECT_EQ(rejected->ec, ozo::error_code(yamail::resource_pool::error::request_queue_overflow));
+}
+
+TEST_F(connection_pool_state, should_complete_waiting_request_with_timeout_on_its_deadline) {
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+
+    auto waiting = get(*state, log, "waiting", ozo::connection_priority::normal,
+        ozo::time_traits::now() + std::chrono::milliseconds(1));
+    run();
+
+    EXPECT_EQ(waiting->ec, ozo::error_code(yamail::resource_pool::error::get_resource_timeout));
+    EXPECT_EQ(state->stats().queue_size, 0u);
+}
+
+TEST_F(connection_pool_state, should_request_new_connection_for_waiting_request_if_released_one_is_wasted) {
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+
+    auto waiting = get(*state, log, "waiting", ozo::connection_priority::normal);
+    run();
+    first->value->waste();
+    run();
+
+    EXPECT_THAT(log, ElementsAre("first", "waiting"));
+    ASSERT_FALSE(waiting->ec);
+    EXPECT_TRUE(waiting->value->empty());
+}
+
+TEST_F(connection_pool_state, should_provide_parked_idle_connection) {
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+    first->value.reset();
+    EXPECT_EQ(state->stats().available, 1u);
+
+    auto second = get(*state, log, "second", ozo::connection_priority::normal);
+    run();
+
+    ASSERT_FALSE(second->ec);
+    EXPECT_EQ((**second->value).id, 1);
+}
+
+TEST_F(connection_pool_state, should_waste_expired_idle_connection_which_is_not_picked_by_lifo) {
+    config.capacity = 2;
+    config.idle_timeout = std::chrono::milliseconds(10);
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto oldest = get(*state, log, "oldest", ozo::connection_priority::normal);
+    auto newest = get(*state, log, "newest", ozo::connection_priority::normal);
+    run();
+    oldest->value->reset(rep{1});
+    newest->value->reset(rep{2});
+    oldest->value.reset();
+    EXPECT_EQ(state->stats().available, 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    newest->value.reset();
+
+    auto next = get(*state, log, "next", ozo::connection_priority::normal);
+    auto another = get(*state, log, "another", ozo::connection_priority::normal);
+    run();
+    ASSERT_FALSE(next->ec);
+    EXPECT_EQ((**next->value).id, 2);
+    ASSERT_FALSE(another->ec);
+    EXPECT_TRUE(another->value->empty());
+}
+
+TEST_F(connection_pool_state, waiting_request_should_not_keep_state_alive) {
+    auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+
+    auto waiting = get(*state, log, "waiting", ozo::connection_priority::normal);
+    EXPECT_EQ(state->stats().queue_size, 1u);
+    std::weak_ptr<state_type> weak = state;
+    state.reset();
+    EXPECT_EQ(weak.use_count(), 1);
+
+    first->value.reset();
+    run();
+    ASSERT_FALSE(waiting->ec);
+    EXPECT_EQ((**waiting->value).id, 1);
+    waiting->value.reset();
+    EXPECT_TRUE(weak.expired());
+}
+
+struct connection_pool_state_deadline_admission : connection_pool_state {
+    std::shared_ptr<state_type> state;
+    std::vector<std::string> log;
+    std::shared_ptr<result> first;
+
+    connection_pool_state_deadline_admission() {
+        config.deadline_admission = true;
+        state = make_state();
+        first = get(*state, log, "first", ozo::connection_priority::normal);
+        run();
+        first->value->reset(rep{1});
+    }
+
+    void use_connection_for(ozo::time_traits::duration usage) {
+        std::this_thread::sleep_for(usage);
+        first->value.reset();
+        first = get(*state, log, "first", ozo::connection_priority::normal);
+        run();
+    }
+};
+
+TEST_F(connection_pool_state_deadline_admission, should_reject_request_with_deadline_shorter_than_usage_estimate_immediately) {
+    use_connection_for(std::chrono::milliseconds(50));
+
+    auto rejected = get(*state, log, "rejected", ozo::connection_priority::normal,
+        ozo::time_traits::now() + std::chrono::milliseconds(10));
+    EXPECT_EQ(state->stats().queue_size, 0u);
+    run();
+
+    EXPECT_EQ(rejected->ec, ozo::error_code(yamail::resource_pool::error::get_resource_timeout));
+}
+
+TEST_F(connection_pool_state_deadline_admission, should_queue_request_without_deadline) {
+    use_connection_for(std::chrono::milliseconds(50));
+
+    auto queued = get(*state, log, "queued", ozo::connection_priority::normal);
+    EXPECT_EQ(state->stats().queue_size, 1u);
+}
+
+TEST_F(connection_pool_state_deadline_admission, should_queue_request_with_short_deadline_without_usage_estimate) {
+    auto queued = get(*state, log, "queued", ozo::connection_priority::normal,
+        ozo::time_traits::now() + std::chrono::milliseconds(10));
+    EXPECT_EQ(state->stats().queue_size, 1u);
+}
+
+TEST_F(connection_pool_state, should_queue_request_with_deadline_shorter_than_usage_if_deadline_admission_is_disabled) {
+    const auto state = make_state();
+    std::vector<std::string> log;
+    auto first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+    first->value->reset(rep{1});
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    first->value.reset();
+    first = get(*state, log, "first", ozo::connection_priority::normal);
+    run();
+
+    auto queued = get(*state, log, "queued", ozo::connection_priority::normal,
+        ozo::time_traits::now() + std::chrono::milliseconds(10));
+    EXPECT_EQ(state->stats().queue_size, 1u);
+}
+
+TEST_F(connection_pool_state_deadline_admission, should_reject_queued_request_which_can_not_meet_deadline_when_connection_is_released) {
+    use_connection_for(std::chrono::milliseconds(50));
+
+    auto doomed = get(*state, log, "doomed", ozo::connection_priority::normal,
+        ozo::time_traits::now() + std::chrono::milliseconds(200));
+    auto waiting = get(*state, log, "waiting", ozo::connection_priority::normal);
+    EXPECT_EQ(state->stats().queue_size, 2u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(170));
+    first->value.reset();
+    run();
+
+    EXPECT_THAT(log, ElementsAre("first", "first", "doomed", "waiting"));
+    EXPECT_EQ(doomed->ec, ozo::error_code(yamail::resource_pool::error::get_resource_timeout));
+    EXPECT_FALSE(waiting->ec);
+}
+
+struct socket_pair {
+    int fds[2] = {-1, -1};
+
+    socket_pair() {
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+            throw std::runtime_error("socketpair failed");
+        }
+    }
+
+    ~socket_pair() {
+        close_peer();
+        ::close(fds[0]);
+    }
+
+    int fd() const { return fds[0]; }
+
+    void send() const {
+        if (::write(fds[1], "x", 1) != 1) {
+            throw std::runtime_error("write failed");
+        }
+    }
+
+    void close_peer() {
+        if (fds[1] != -1) {
+            ::close(fds[1]);
+            fds[1] = -1;
+        }
+    }
+};
+
+struct connection_alive : Test {
+    StrictMock<PGconn_mock> native_handle;
+    socket_pair sockets;
+};
+
+TEST_F(connection_alive, should_return_false_for_connection_with_bad_status) {
+    EXPECT_CALL(native_handle, PQstatus()).WillOnce(Return(CONNECTION_BAD));
+    EXPECT_FALSE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
+TEST_F(connection_alive, should_return_false_for_connection_without_socket) {
+    EXPECT_CALL(native_handle, PQstatus()).WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).WillOnce(Return(-1));
+    EXPECT_FALSE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
+TEST_F(connection_alive, should_return_true_without_consuming_input_for_connection_without_pending_input) {
+    EXPECT_CALL(native_handle, PQstatus()).WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).WillOnce(Return(sockets.fd()));
+    EXPECT_TRUE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
+TEST_F(connection_alive, should_consume_and_parse_pending_input_and_return_true_if_connection_status_is_still_ok) {
+    sockets.send();
+    Sequence s;
+    EXPECT_CALL(native_handle, PQstatus()).InSequence(s).WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(sockets.fd()));
+    EXPECT_CALL(native_handle, PQconsumeInput()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQstatus()).InSequence(s).WillOnce(Return(CONNECTION_OK));
+    EXPECT_TRUE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
+TEST_F(connection_alive, should_return_false_without_consuming_input_for_connection_closed_by_peer) {
+    sockets.close_peer();
+    Sequence s;
+    EXPECT_CALL(native_handle, PQstatus()).InSequence(s).WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(sockets.fd()));
+    EXPECT_FALSE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
+TEST_F(connection_alive, should_return_false_if_pending_input_consumption_fails) {
+    sockets.send();
+    Sequence s;
+    EXPECT_CALL(native_handle, PQstatus()).InSequence(s).WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(sockets.fd()));
+    EXPECT_CALL(native_handle, PQconsumeInput()).InSequence(s).WillOnce(Return(0));
+    EXPECT_FALSE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
+TEST_F(connection_alive, should_return_false_if_connection_status_is_bad_after_input_parsing) {
+    sockets.send();
+    Sequence s;
+    EXPECT_CALL(native_handle, PQstatus()).InSequence(s).WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(sockets.fd()));
+    EXPECT_CALL(native_handle, PQconsumeInput()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQstatus()).InSequence(s).WillOnce(Return(CONNECTION_BAD));
+    EXPECT_FALSE(ozo::detail::connection_alive(std::addressof(native_handle)));
+}
+
 struct pooled_connection_wrapper : Test {
     using pooled_connection_ptr = std::shared_ptr<ozo::pooled_connection<ozo::tests::connection_pool::handle, ozo::tests::executor>>;
     StrictMock<connection_source_mock> provider_mock;
@@ -290,11 +905,12 @@ TEST_F(pooled_connection_wrapper, should_invoke_handler_if_passed_connection_is_
     auto h = wrap_pooled_connection_handler();
 
 
+    socket_pair sockets;
     EXPECT_CALL(handle_mock, empty()).WillRepeatedly(Return(false));
     EXPECT_CALL(io.stream_service_, create()).WillOnce(ReturnRef(stream));
-    EXPECT_CALL(stream, assign(42));
+    EXPECT_CALL(stream, assign(sockets.fd()));
     EXPECT_CALL(stream, release());
-    EXPECT_CALL(native_handle, PQsocket()).WillRepeatedly(Return(42));
+    EXPECT_CALL(native_handle, PQsocket()).WillRepeatedly(Return(sockets.fd()));
     EXPECT_CALL(native_handle, PQstatus()).WillRepeatedly(Return(CONNECTION_OK));
     EXPECT_CALL(native_handle, PQtransactionStatus()).WillRepeatedly(Return(PQTRANS_IDLE));
 
@@ -316,21 +932,55 @@ TEST_F(pooled_connection_wrapper, should_call_async_get_connection_and_invoke_ha
         .InSequence(s)
         .WillOnce(InvokeArgument<0>(error_code{}, make_connection()));
     EXPECT_CALL(handle_mock, reset(_)).InSequence(s);
-    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
     EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(42));
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
     EXPECT_CALL(stream, assign(42)).InSequence(s);
 
     EXPECT_CALL(callback_mock, call(ozo::error_code{}, _))
         .InSequence(s)
         .WillOnce(Return());
 
+    EXPECT_CALL(native_handle, PQstatus())
+        .InSequence(s)
+        .WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQtransactionStatus())
+        .InSequence(s)
+        .WillOnce(Return(PQTRANS_IDLE));
     EXPECT_CALL(stream, release()).InSequence(s);
+
+    h({}, connection_pool::handle{&handle_mock});
+}
+
+TEST_F(pooled_connection_wrapper, should_call_async_get_connection_and_invoke_handler_if_passed_connection_is_closed_by_peer) {
+    auto h = wrap_pooled_connection_handler();
+
+    socket_pair sockets;
+    sockets.close_peer();
+    Sequence s;
+    EXPECT_CALL(handle_mock, empty()).WillRepeatedly(Return(false));
+    EXPECT_CALL(native_handle, PQstatus())
+        .InSequence(s)
+        .WillOnce(Return(CONNECTION_OK));
+    EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(sockets.fd()));
+    EXPECT_CALL(provider_mock, async_get_connection(_))
+        .InSequence(s)
+        .WillOnce(InvokeArgument<0>(error_code{}, make_connection()));
+    EXPECT_CALL(handle_mock, reset(_)).InSequence(s);
+    EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(42));
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
+    EXPECT_CALL(stream, assign(42)).InSequence(s);
+
+    EXPECT_CALL(callback_mock, call(ozo::error_code{}, _))
+        .InSequence(s)
+        .WillOnce(Return());
+
     EXPECT_CALL(native_handle, PQstatus())
         .InSequence(s)
         .WillOnce(Return(CONNECTION_OK));
     EXPECT_CALL(native_handle, PQtransactionStatus())
         .InSequence(s)
         .WillOnce(Return(PQTRANS_IDLE));
+    EXPECT_CALL(stream, release()).InSequence(s);
 
     h({}, connection_pool::handle{&handle_mock});
 }
@@ -344,22 +994,22 @@ TEST_F(pooled_connection_wrapper, should_call_async_get_connection_and_invoke_ha
     EXPECT_CALL(provider_mock, async_get_connection(_))
         .InSequence(s)
         .WillOnce(InvokeArgument<0>(error_code{}, make_connection()));
-    EXPECT_CALL(handle_mock, reset(_)).InSequence(s).WillOnce(Invoke([&](auto){ handle_empty = false;}));
-    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
+    EXPECT_CALL(handle_mock, reset(_)).InSequence(s).WillOnce(Invoke([&](auto&){ handle_empty = false;}));
     EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(42));
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
     EXPECT_CALL(stream, assign(42)).InSequence(s);
 
     EXPECT_CALL(callback_mock, call(ozo::error_code{}, _))
         .InSequence(s)
         .WillOnce(Return());
 
-    EXPECT_CALL(stream, release()).InSequence(s);
     EXPECT_CALL(native_handle, PQstatus())
         .InSequence(s)
         .WillOnce(Return(CONNECTION_OK));
     EXPECT_CALL(native_handle, PQtransactionStatus())
         .InSequence(s)
         .WillOnce(Return(PQTRANS_IDLE));
+    EXPECT_CALL(stream, release()).InSequence(s);
 
     h({}, connection_pool::handle{&handle_mock});
 }
@@ -373,22 +1023,22 @@ TEST_F(pooled_connection_wrapper, should_invoke_callback_with_error_and_provided
     EXPECT_CALL(provider_mock, async_get_connection(_))
         .InSequence(s)
         .WillOnce(InvokeArgument<0>(error::error, make_connection()));
-    EXPECT_CALL(handle_mock, reset(_)).InSequence(s).WillOnce(Invoke([&](auto){ handle_empty = false;}));
-    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
+    EXPECT_CALL(handle_mock, reset(_)).InSequence(s).WillOnce(Invoke([&](auto&){ handle_empty = false;}));
     EXPECT_CALL(native_handle, PQsocket()).InSequence(s).WillOnce(Return(42));
+    EXPECT_CALL(io.stream_service_, create()).InSequence(s).WillOnce(ReturnRef(stream));
     EXPECT_CALL(stream, assign(42)).InSequence(s);
 
     EXPECT_CALL(callback_mock, call(Eq(error::error), _))
         .InSequence(s)
         .WillOnce(Return());
 
-    EXPECT_CALL(stream, release()).InSequence(s);
     EXPECT_CALL(native_handle, PQstatus())
         .InSequence(s)
         .WillOnce(Return(CONNECTION_OK));
     EXPECT_CALL(native_handle, PQtransactionStatus())
         .InSequence(s)
         .WillOnce(Return(PQTRANS_IDLE));
+    EXPECT_CALL(stream, release()).InSequence(s);
 
     h({}, connection_pool::handle{&handle_mock});
 }
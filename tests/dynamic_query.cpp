@@ -0,0 +1,111 @@
+#include <ozo/dynamic_query.h>
+#include <ozo/pg/types.h>
+
+#include <boost/endian/conversion.hpp>
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace testing;
+
+std::int32_t read_int32(const char* value) {
+    std::int32_t result;
+    std::memcpy(&result, value, sizeof(result));
+    return boost::endian::big_to_native(result);
+}
+
+TEST(dynamic_query, should_number_parameters_in_order) {
+    ozo::dynamic_query query;
+    query.text("SELECT ").param(std::int32_t(1)).text(" + ").param(std::int32_t(2));
+    EXPECT_EQ(query.get_text(), "SELECT $1 + $2");
+    EXPECT_EQ(query.params_count(), 2u);
+}
+
+TEST(dynamic_query, any_should_append_array_parameter) {
+    ozo::dynamic_query query;
+    query.text("SELECT 1 WHERE 1 ").any(std::vector<std::int32_t>({1, 2, 3}));
+    EXPECT_EQ(query.get_text(), "SELECT 1 WHERE 1 = ANY($1)");
+    const auto binary = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    EXPECT_EQ(binary.params_count(), 1u);
+    EXPECT_EQ(binary.types()[0], ozo::type_traits<std::vector<std::int32_t>>::oid());
+}
+
+TEST(dynamic_query, to_binary_query_should_provide_text_and_serialized_parameters) {
+    ozo::dynamic_query query;
+    query.text("SELECT ").param(std::int32_t(42)).text("::text || ").param(std::string("text"));
+    const auto binary = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    EXPECT_STREQ(binary.text(), "SELECT $1::text || $2");
+    ASSERT_EQ(binary.params_count(), 2u);
+    EXPECT_EQ(binary.types()[0], ozo::type_traits<std::int32_t>::oid());
+    EXPECT_EQ(binary.types()[1], ozo::type_traits<std::string>::oid());
+    EXPECT_EQ(binary.formats()[0], 1);
+    EXPECT_EQ(binary.formats()[1], 1);
+    EXPECT_EQ(binary.lengths()[0], 4);
+    EXPECT_EQ(binary.lengths()[1], 4);
+    EXPECT_EQ(read_int32(binary.values()[0]), 42);
+    EXPECT_EQ(std::string_view(binary.values()[1], 4), "text");
+}
+
+TEST(dynamic_query, to_binary_query_should_provide_null_value_for_empty_parameter) {
+    ozo::dynamic_query query;
+    query.text("SELECT ").param(std::string());
+    const auto binary = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    EXPECT_EQ(binary.lengths()[0], 0);
+    EXPECT_EQ(binary.values()[0], nullptr);
+}
+
+TEST(dynamic_query, values_should_be_valid_after_buffer_reallocation) {
+    ozo::dynamic_query query;
+    for (std::int32_t i = 0; i < 100; ++i) {
+        query.text(i ? ", " : "SELECT ").param(i);
+    }
+    const auto binary = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    ASSERT_EQ(binary.params_count(), 100u);
+    for (std::int32_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(read_int32(binary.values()[i]), i);
+    }
+}
+
+TEST(dynamic_query, reset_should_clear_query_and_reuse_buffers) {
+    ozo::dynamic_query query;
+    query.text("SELECT ").param(std::int32_t(42));
+    const auto data = query.data().get();
+    const auto text_capacity = data->text_.capacity();
+    query.reset();
+    EXPECT_EQ(query.get_text(), "");
+    EXPECT_EQ(query.params_count(), 0u);
+    EXPECT_EQ(query.data().get(), data);
+    EXPECT_EQ(data->text_.capacity(), text_capacity);
+    query.text("SELECT ").param(std::int32_t(13));
+    EXPECT_EQ(query.get_text(), "SELECT $1");
+}
+
+TEST(dynamic_query, modification_should_not_affect_alive_binary_query) {
+    ozo::dynamic_query query;
+    query.text("SELECT ").param(std::int32_t(42));
+    const auto binary = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    query.text(" + ").param(std::int32_t(13));
+    EXPECT_STREQ(binary.text(), "SELECT $1");
+    EXPECT_EQ(binary.params_count(), 1u);
+    EXPECT_EQ(read_int32(binary.values()[0]), 42);
+    EXPECT_EQ(query.get_text(), "SELECT $1 + $2");
+    const auto modified = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    EXPECT_EQ(read_int32(modified.values()[0]), 42);
+    EXPECT_EQ(read_int32(modified.values()[1]), 13);
+}
+
+TEST(dynamic_query, reset_should_not_affect_alive_binary_query) {
+    ozo::dynamic_query query;
+    query.text("SELECT ").param(std::int32_t(42));
+    const auto binary = ozo::to_binary_query(query, ozo::empty_oid_map{});
+    query.reset();
+    EXPECT_STREQ(binary.text(), "SELECT $1");
+    EXPECT_EQ(read_int32(binary.values()[0]), 42);
+    EXPECT_EQ(query.get_text(), "");
+}
+
+} // namespace
@@ -11,6 +11,8 @@ TEST(connection_error, should_match_to_mapped_errors_only) {
     EXPECT_EQ(connection_error, boost::asio::error::connection_aborted);
     EXPECT_EQ(connection_error, boost::system::errc::make_error_code(boost::system::errc::io_error));
     EXPECT_EQ(connection_error, ozo::error::pq_socket_failed);
+    EXPECT_EQ(connection_error, ozo::error::circuit_open);
+    EXPECT_EQ(connection_error, ozo::error::pg_pipeline_failed);
     EXPECT_NE(connection_error, ozo::error::bad_object_size);
 }
 
@@ -23,6 +25,7 @@ TEST(database_readonly, should_match_to_mapped_errors_only) {
 TEST(introspection_error, should_match_to_mapped_errors_only) {
     const auto introspection_error = ozo::error_condition{ozo::errc::introspection_error};
     EXPECT_EQ(introspection_error, ozo::error::bad_object_size);
+    EXPECT_EQ(introspection_error, ozo::error::bad_result_process_after_commit);
     EXPECT_NE(introspection_error, ozo::error::pq_socket_failed);
 }
 
@@ -0,0 +1,125 @@
+#include <ozo/failover/balanced.h>
+
+#include "../test_error.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+struct connection_mock {};
+
+using connection_ptr = std::shared_ptr<connection_mock>;
+
+struct source_call {
+    std::size_t source;
+    std::function<void(ozo::error_code, connection_ptr)> handler;
+};
+
+struct source {
+    using connection_type = connection_ptr;
+
+    std::size_t id_ = 0;
+    std::vector<source_call>* calls_ = nullptr;
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (ozo::io_context&, TimeConstraint, Handler&& h) const {
+        calls_->push_back({id_, std::forward<Handler>(h)});
+    }
+};
+
+} // namespace
+
+namespace ozo {
+
+template <>
+struct is_connection<connection_ptr> : std::true_type {};
+
+} // namespace ozo
+
+namespace {
+
+struct balanced_connection_source : Test {
+    ozo::io_context io;
+    std::vector<source_call> calls;
+    ozo::failover::balanced_connection_source<source> balanced{{source{0, &calls}, source{1, &calls}}};
+    std::vector<connection_ptr> conns;
+
+    void request() {
+        balanced(io, ozo::none, [this](ozo::error_code ec, connection_ptr conn) {
+            EXPECT_FALSE(ec);
+            conns.push_back(std::move(conn));
+        });
+    }
+};
+
+TEST_F(balanced_connection_source, should_throw_for_empty_sources) {
+    EXPECT_THROW(ozo::failover::balanced_connection_source<source>{{}}, std::invalid_argument);
+}
+
+TEST_F(balanced_connection_source, should_pass_connection_of_selected_source_to_handler) {
+    request();
+    ASSERT_EQ(calls.size(), 1u);
+    auto conn = std::make_shared<connection_mock>();
+    calls.front().handler(ozo::error_code{}, conn);
+    ASSERT_EQ(conns.size(), 1u);
+    EXPECT_EQ(conns.front().get(), conn.get());
+}
+
+TEST_F(balanced_connection_source, should_prefer_source_with_less_requests_in_flight) {
+    request();
+    request();
+    ASSERT_EQ(calls.size(), 2u);
+    EXPECT_NE(calls[0].source, calls[1].source);
+    EXPECT_EQ(balanced.in_flight(0), 1u);
+    EXPECT_EQ(balanced.in_flight(1), 1u);
+}
+
+TEST_F(balanced_connection_source, should_keep_request_in_flight_until_connection_is_released) {
+    request();
+    ASSERT_EQ(calls.size(), 1u);
+    const auto n = calls.front().source;
+    calls.front().handler(ozo::error_code{}, std::make_shared<connection_mock>());
+    EXPECT_EQ(balanced.in_flight(n), 1u);
+
+    conns.clear();
+    EXPECT_EQ(balanced.in_flight(n), 0u);
+    EXPECT_GT(balanced.latency(n), ozo::time_traits::duration::zero());
+}
+
+TEST_F(balanced_connection_source, should_account_error_penalty_for_failed_request) {
+    balanced(io, ozo::none, [](ozo::error_code ec, connection_ptr) {
+        EXPECT_EQ(ec, ozo::tests::error::error);
+    });
+    ASSERT_EQ(calls.size(), 1u);
+    const auto n = calls.front().source;
+    calls.front().handler(ozo::tests::error::error, nullptr);
+    EXPECT_EQ(balanced.in_flight(n), 0u);
+    EXPECT_GE(balanced.latency(n), 1s);
+}
+
+TEST_F(balanced_connection_source, should_prefer_source_with_lower_latency) {
+    balanced(io, ozo::none, [](ozo::error_code, connection_ptr) {});
+    ASSERT_EQ(calls.size(), 1u);
+    const auto failed = calls.front().source;
+    calls.front().handler(ozo::tests::error::error, nullptr);
+
+    for (int i = 0; i < 3; ++i) {
+        request();
+        EXPECT_NE(calls.back().source, failed);
+        calls.back().handler(ozo::error_code{}, std::make_shared<connection_mock>());
+        conns.clear();
+    }
+}
+
+TEST(make_balanced_connection_source, should_create_source_with_all_sources_given) {
+    std::vector<source_call> calls;
+    auto balanced = ozo::failover::make_balanced_connection_source(source{0, &calls}, source{1, &calls}, source{2, &calls});
+    EXPECT_EQ(balanced.size(), 3u);
+    EXPECT_TRUE(ozo::ConnectionSource<decltype(balanced)>);
+}
+
+} // namespace
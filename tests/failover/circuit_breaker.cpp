@@ -0,0 +1,230 @@
+#include <ozo/failover/circuit_breaker.h>
+#include <ozo/ext/std/shared_ptr.h>
+
+#include "../test_error.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+struct connection_mock {
+    bool bad = false;
+    bool is_bad() const noexcept { return bad; }
+};
+
+using connection_ptr = std::shared_ptr<connection_mock>;
+
+struct source {
+    using connection_type = connection_ptr;
+
+    std::vector<std::function<void(ozo::error_code, connection_ptr)>>* calls_ = nullptr;
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (ozo::io_context&, TimeConstraint, Handler&& h) const {
+        calls_->push_back(std::forward<Handler>(h));
+    }
+};
+
+} // namespace
+
+namespace ozo {
+
+template <>
+struct is_connection<connection_mock> : std::true_type {};
+
+} // namespace ozo
+
+namespace {
+
+using ozo::failover::circuit_breaker;
+using ozo::failover::circuit_state;
+using result = circuit_breaker::result;
+
+struct circuit_breaker_ : Test {
+    ozo::time_traits::time_point now{};
+    circuit_breaker breaker{ozo::failover::circuit_breaker_config{4, 2, 0.5, ozo::time_traits::duration::max(), 1s, 1}};
+
+    void request(result r) {
+        breaker.release(breaker.try_acquire(now), r, now);
+    }
+
+    void open() {
+        request(result::failure);
+        request(result::failure);
+        ASSERT_EQ(breaker.state(now), circuit_state::open);
+    }
+};
+
+TEST_F(circuit_breaker_, should_be_closed_initially) {
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+    EXPECT_TRUE(breaker.is_available(now));
+    EXPECT_TRUE(breaker.try_acquire(now).granted);
+}
+
+TEST_F(circuit_breaker_, should_open_when_failure_rate_is_reached) {
+    request(result::success);
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::open);
+    EXPECT_FALSE(breaker.is_available(now));
+}
+
+TEST_F(circuit_breaker_, should_stay_closed_until_minimum_number_of_requests) {
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+}
+
+TEST_F(circuit_breaker_, should_stay_closed_below_failure_rate) {
+    request(result::success);
+    request(result::success);
+    request(result::success);
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+}
+
+TEST_F(circuit_breaker_, should_forget_results_out_of_window) {
+    for (int i = 0; i < 6; ++i) {
+        request(result::success);
+    }
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::open);
+}
+
+TEST_F(circuit_breaker_, should_not_count_ignored_results) {
+    request(result::ignored);
+    request(result::ignored);
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+}
+
+TEST_F(circuit_breaker_, should_deny_requests_when_open) {
+    open();
+    EXPECT_FALSE(breaker.try_acquire(now).granted);
+}
+
+TEST_F(circuit_breaker_, should_become_half_open_after_open_timeout) {
+    open();
+    now += 1s;
+    EXPECT_EQ(breaker.state(now), circuit_state::half_open);
+    EXPECT_TRUE(breaker.is_available(now));
+    const auto permit = breaker.try_acquire(now);
+    EXPECT_TRUE(permit.granted);
+    EXPECT_TRUE(permit.probe);
+}
+
+TEST_F(circuit_breaker_, should_limit_number_of_probes_when_half_open) {
+    open();
+    now += 1s;
+    EXPECT_TRUE(breaker.try_acquire(now).granted);
+    EXPECT_FALSE(breaker.is_available(now));
+    EXPECT_FALSE(breaker.try_acquire(now).granted);
+}
+
+TEST_F(circuit_breaker_, should_close_on_successful_probe) {
+    open();
+    now += 1s;
+    request(result::success);
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::closed);
+}
+
+TEST_F(circuit_breaker_, should_open_again_on_failed_probe) {
+    open();
+    now += 1s;
+    request(result::failure);
+    EXPECT_EQ(breaker.state(now), circuit_state::open);
+    EXPECT_FALSE(breaker.try_acquire(now).granted);
+}
+
+TEST_F(circuit_breaker_, should_release_probe_on_ignored_result) {
+    open();
+    now += 1s;
+    request(result::ignored);
+    EXPECT_EQ(breaker.state(now), circuit_state::half_open);
+    EXPECT_TRUE(breaker.try_acquire(now).granted);
+}
+
+struct circuit_breaker_source : Test {
+    ozo::io_context io;
+    std::vector<std::function<void(ozo::error_code, connection_ptr)>> calls;
+    std::shared_ptr<circuit_breaker> breaker = std::make_shared<circuit_breaker>(
+        ozo::failover::circuit_breaker_config{1, 1, 1.0, ozo::time_traits::duration::max(), 1h, 1});
+    ozo::failover::circuit_breaker_source<source> guarded{source{&calls}, breaker};
+    StrictMock<MockFunction<void(ozo::error_code, connection_ptr)>> callback;
+
+    auto handler() {
+        return [this](ozo::error_code ec, connection_ptr conn) { callback.Call(ec, std::move(conn)); };
+    }
+};
+
+TEST_F(circuit_breaker_source, should_pass_connection_to_handler_when_closed) {
+    guarded(io, ozo::none, handler());
+    ASSERT_EQ(calls.size(), 1u);
+    auto conn = std::make_shared<connection_mock>();
+    EXPECT_CALL(callback, Call(ozo::error_code{}, conn));
+    calls.front()(ozo::error_code{}, conn);
+}
+
+TEST_F(circuit_breaker_source, should_open_circuit_on_connection_error) {
+    EXPECT_CALL(callback, Call(ozo::error_code{ozo::error::pq_connection_start_failed}, _));
+    guarded(io, ozo::none, handler());
+    ASSERT_EQ(calls.size(), 1u);
+    calls.front()(ozo::error::pq_connection_start_failed, nullptr);
+    EXPECT_EQ(breaker->state(), circuit_state::open);
+    EXPECT_FALSE(guarded.is_available());
+}
+
+TEST_F(circuit_breaker_source, should_not_count_error_other_than_connection_error) {
+    EXPECT_CALL(callback, Call(ozo::error_code{ozo::tests::error::error}, _));
+    guarded(io, ozo::none, handler());
+    ASSERT_EQ(calls.size(), 1u);
+    calls.front()(ozo::tests::error::error, nullptr);
+    EXPECT_EQ(breaker->state(), circuit_state::closed);
+}
+
+TEST_F(circuit_breaker_source, should_open_circuit_when_bad_connection_is_released) {
+    connection_ptr conn;
+    guarded(io, ozo::none, [&](ozo::error_code, connection_ptr c) { conn = std::move(c); });
+    ASSERT_EQ(calls.size(), 1u);
+    calls.front()(ozo::error_code{}, std::make_shared<connection_mock>());
+    ASSERT_TRUE(conn);
+    EXPECT_EQ(breaker->state(), circuit_state::closed);
+
+    conn->bad = true;
+    conn.reset();
+    EXPECT_EQ(breaker->state(), circuit_state::open);
+}
+
+TEST_F(circuit_breaker_source, should_fail_with_circuit_open_without_source_call_when_open) {
+    breaker->release(breaker->try_acquire(), result::failure);
+    guarded(io, ozo::none, handler());
+    EXPECT_TRUE(calls.empty());
+
+    EXPECT_CALL(callback, Call(ozo::error_code{ozo::error::circuit_open}, connection_ptr{}));
+    io.run();
+}
+
+TEST_F(circuit_breaker_source, circuit_open_should_match_connection_error_condition) {
+    EXPECT_EQ(ozo::error_code{ozo::error::circuit_open}, ozo::errc::connection_error);
+}
+
+TEST(is_available, should_return_true_for_source_without_availability) {
+    EXPECT_TRUE(ozo::failover::is_available(source{}));
+}
+
+TEST(is_available, should_return_circuit_breaker_availability) {
+    auto guarded = ozo::failover::circuit_breaker_source(source{},
+        ozo::failover::circuit_breaker_config{1, 1, 1.0, ozo::time_traits::duration::max(), 1h, 1});
+    EXPECT_TRUE(ozo::failover::is_available(guarded));
+    guarded.breaker()->release(guarded.breaker()->try_acquire(), result::failure);
+    EXPECT_FALSE(ozo::failover::is_available(guarded));
+    EXPECT_TRUE(ozo::ConnectionSource<decltype(guarded)>);
+}
+
+} // namespace
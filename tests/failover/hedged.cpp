@@ -0,0 +1,319 @@
+#include <ozo/failover/hedged.h>
+
+#include "../test_error.h"
+
+#include <boost/asio/bind_executor.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <deque>
+#include <thread>
+
+namespace {
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+struct connection_mock {
+    MOCK_CONST_METHOD0(close_connection, void());
+    friend void close_connection(connection_mock* self) {
+        if(!self) {
+            throw std::invalid_argument("self should not be null");
+        }
+        self->close_connection();
+    };
+};
+
+struct cancellable_connection {
+    ozo::io_context* io_ = nullptr;
+    ozo::io_context* cancel_io_ = nullptr;
+
+    ozo::io_context::executor_type get_executor() const { return io_->get_executor(); }
+
+    friend ozo::cancel_handle<ozo::io_context::executor_type> get_cancel_handle(const cancellable_connection& self) {
+        return {nullptr, self.cancel_io_->get_executor()};
+    }
+};
+
+struct test_role_type {};
+static constexpr test_role_type test_role;
+
+struct provider {
+    using connection_type = connection_mock*;
+
+    std::deque<connection_mock*>* conns_ = nullptr;
+    std::deque<connection_mock*>* role_conns_ = nullptr;
+
+    template <typename Role>
+    provider rebind_role(Role) const {
+        return {role_conns_, nullptr};
+    }
+
+    template <typename TimeConstraint, typename Handler>
+    void async_get_connection(TimeConstraint, Handler&& h) const {
+        auto conn = conns_->front();
+        conns_->pop_front();
+        h(ozo::error_code{}, conn);
+    }
+};
+
+struct started_try {
+    std::function<void(ozo::error_code, connection_mock*)> handler;
+    connection_mock* conn = nullptr;
+    ozo::error_code ec;
+    std::string arg;
+
+    void complete(ozo::error_code ec) { handler(ec, conn); }
+};
+
+struct operation {
+    std::vector<started_try>* tries = nullptr;
+
+    struct initiator_type {
+        std::vector<started_try>* tries = nullptr;
+
+        template <typename Handler, typename Provider, typename TimeConstraint>
+        void operator() (Handler&& h, Provider&& p, TimeConstraint t, std::string arg) const {
+            ozo::async_get_connection(p, t, [&](ozo::error_code ec, connection_mock* conn) {
+                tries->push_back(started_try{std::forward<Handler>(h), conn, ec, arg});
+            });
+        }
+    };
+
+    initiator_type get_initiator() const { return {tries}; }
+};
+
+} // namespace
+
+namespace ozo {
+
+template <>
+struct is_connection<connection_mock*> : std::true_type {};
+
+template <>
+struct is_nullable<connection_mock*> : std::true_type {};
+
+template <>
+struct is_connection<cancellable_connection> : std::true_type {};
+
+} // namespace ozo
+
+namespace {
+
+struct hedged_strategy : Test {
+    ozo::io_context io;
+    StrictMock<connection_mock> conn1;
+    StrictMock<connection_mock> conn2;
+    StrictMock<connection_mock> role_conn;
+    std::deque<connection_mock*> conns{&conn1, &conn2};
+    std::deque<connection_mock*> role_conns{&role_conn};
+    std::vector<started_try> tries;
+    operation op{&tries};
+    StrictMock<MockFunction<void(ozo::error_code, connection_mock*)>> callback;
+    StrictMock<MockFunction<void(connection_mock*)>> cancel;
+    StrictMock<MockFunction<void()>> on_hedge;
+
+    auto handler() {
+        return boost::asio::bind_executor(io, [this](ozo::error_code ec, connection_mock* conn) {
+            callback.Call(ec, conn);
+        });
+    }
+
+    template <typename Strategy, typename TimeConstraint>
+    void start(Strategy strategy, TimeConstraint t) {
+        auto initiator = ozo::construct_initiator(strategy.set(
+            ozo::failover::hedged_options::cancel = [this](connection_mock* conn) { cancel.Call(conn); },
+            ozo::failover::hedged_options::on_hedge = [this] { on_hedge.Call(); }
+        ), op);
+        initiator(handler(), provider{&conns, &role_conns}, t, std::string("arg"));
+    }
+};
+
+TEST_F(hedged_strategy, should_complete_with_first_try_result_if_it_succeeds_before_delay) {
+    start(ozo::failover::hedge(1h), ozo::none);
+    ASSERT_EQ(tries.size(), 1u);
+    EXPECT_EQ(tries[0].conn, &conn1);
+    EXPECT_EQ(tries[0].arg, "arg");
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn1));
+    tries[0].complete({});
+    io.run();
+    EXPECT_EQ(tries.size(), 1u);
+}
+
+TEST_F(hedged_strategy, should_start_hedge_after_delay) {
+    start(ozo::failover::hedge(1ms), ozo::none);
+    ASSERT_EQ(tries.size(), 1u);
+
+    EXPECT_CALL(on_hedge, Call());
+    io.run_one();
+    ASSERT_EQ(tries.size(), 2u);
+    EXPECT_EQ(tries[1].conn, &conn2);
+    EXPECT_EQ(tries[1].arg, "arg");
+}
+
+TEST_F(hedged_strategy, should_complete_with_hedge_result_and_cancel_first_try_if_hedge_succeeds_first) {
+    start(ozo::failover::hedge(1ms), ozo::none);
+    EXPECT_CALL(on_hedge, Call());
+    io.run_one();
+    ASSERT_EQ(tries.size(), 2u);
+
+    InSequence s;
+    EXPECT_CALL(cancel, Call(&conn1));
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn2));
+    tries[1].complete({});
+
+    EXPECT_CALL(conn1, close_connection());
+    tries[0].complete(ozo::tests::error::error);
+    io.run();
+}
+
+TEST_F(hedged_strategy, should_start_hedge_immediately_if_first_try_fails) {
+    start(ozo::failover::hedge(1h), ozo::none);
+    ASSERT_EQ(tries.size(), 1u);
+
+    EXPECT_CALL(conn1, close_connection());
+    EXPECT_CALL(on_hedge, Call());
+    tries[0].complete(ozo::tests::error::error);
+    ASSERT_EQ(tries.size(), 2u);
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn2));
+    tries[1].complete({});
+    io.run();
+}
+
+TEST_F(hedged_strategy, should_complete_with_last_error_if_both_tries_fail) {
+    start(ozo::failover::hedge(1ms), ozo::none);
+    EXPECT_CALL(on_hedge, Call());
+    io.run_one();
+    ASSERT_EQ(tries.size(), 2u);
+
+    EXPECT_CALL(conn2, close_connection());
+    tries[1].complete(ozo::tests::error::error);
+
+    EXPECT_CALL(callback, Call(ozo::error_code{ozo::tests::error::another_error}, &conn1));
+    tries[0].complete(ozo::tests::error::another_error);
+    io.run();
+}
+
+TEST_F(hedged_strategy, should_not_close_connection_of_failed_try_if_close_connection_is_false) {
+    start(ozo::failover::hedge(1h).set(ozo::failover::hedged_options::close_connection = false), ozo::none);
+
+    EXPECT_CALL(on_hedge, Call());
+    tries[0].complete(ozo::tests::error::error);
+    ASSERT_EQ(tries.size(), 2u);
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn2));
+    tries[1].complete({});
+    io.run();
+}
+
+TEST_F(hedged_strategy, should_get_hedge_connection_for_role_specified) {
+    start(ozo::failover::hedge(1ms).to(test_role), ozo::none);
+    EXPECT_CALL(on_hedge, Call());
+    io.run_one();
+    ASSERT_EQ(tries.size(), 2u);
+    EXPECT_EQ(tries[1].conn, &role_conn);
+
+    InSequence s;
+    EXPECT_CALL(cancel, Call(&role_conn));
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn1));
+    tries[0].complete({});
+    io.run();
+}
+
+TEST_F(hedged_strategy, should_not_start_hedge_by_timer_if_delay_exceeds_time_left) {
+    start(ozo::failover::hedge(1h), 1s);
+    io.run();
+    EXPECT_EQ(tries.size(), 1u);
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn1));
+    tries[0].complete({});
+    io.run();
+}
+
+TEST_F(hedged_strategy, should_take_delay_from_latency_percentile_and_update_it) {
+    auto percentile = std::make_shared<ozo::failover::latency_percentile>(0.5, 1ms, 1);
+    start(ozo::failover::hedge(percentile), ozo::none);
+    EXPECT_CALL(on_hedge, Call());
+    io.run_one();
+    ASSERT_EQ(tries.size(), 2u);
+
+    EXPECT_CALL(cancel, Call(&conn2));
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn1));
+    tries[0].complete({});
+    io.run();
+    EXPECT_GE(percentile->get(), 1ms);
+}
+
+TEST_F(hedged_strategy, should_sample_latency_of_hedge_if_it_wins) {
+    auto percentile = std::make_shared<ozo::failover::latency_percentile>(0.5, 10ms, 1);
+    start(ozo::failover::hedge(percentile), ozo::none);
+    EXPECT_CALL(on_hedge, Call());
+    io.run_one();
+    ASSERT_EQ(tries.size(), 2u);
+
+    EXPECT_CALL(cancel, Call(&conn1));
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn2));
+    tries[1].complete({});
+    io.run();
+    EXPECT_LT(percentile->get(), 10ms);
+}
+
+TEST_F(hedged_strategy, should_sample_elapsed_time_of_failed_first_try) {
+    auto percentile = std::make_shared<ozo::failover::latency_percentile>(0.5, 1h, 1);
+    start(ozo::failover::hedge(percentile), ozo::none);
+    ASSERT_EQ(tries.size(), 1u);
+    std::this_thread::sleep_for(10ms);
+
+    EXPECT_CALL(conn1, close_connection());
+    EXPECT_CALL(on_hedge, Call());
+    tries[0].complete(ozo::tests::error::error);
+    EXPECT_GE(percentile->get(), 10ms);
+    EXPECT_LT(percentile->get(), 1h);
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}, &conn2));
+    tries[1].complete({});
+    io.run();
+}
+
+TEST(hedged_cancel_try, should_stop_waiting_for_cancel_at_operation_deadline) {
+    ozo::io_context io;
+    ozo::io_context cancel_io; // is not run like a thread blocked by a cancel request to an unreachable host
+    const cancellable_connection conn{&io, &cancel_io};
+    StrictMock<MockFunction<void(ozo::error_code)>> callback;
+
+    const ozo::failover::detail::cancel_try<ozo::time_traits::time_point> cancel{ozo::time_traits::now() + 10ms};
+    cancel(conn, [&](ozo::error_code ec, std::string) { callback.Call(ec); });
+
+    EXPECT_CALL(callback, Call(ozo::error_code{boost::asio::error::timed_out}));
+    io.run();
+}
+
+TEST(latency_percentile, should_return_initial_value_without_enough_samples) {
+    ozo::failover::latency_percentile percentile(0.9, 10ms, 100);
+    percentile.update(1s);
+    EXPECT_EQ(percentile.get(), 10ms);
+}
+
+TEST(latency_percentile, should_return_percentile_of_samples) {
+    ozo::failover::latency_percentile percentile(0.9, 10ms, 100);
+    for (int i = 1; i <= 100; ++i) {
+        percentile.update(std::chrono::milliseconds(i));
+    }
+    EXPECT_EQ(percentile.get(), 90ms);
+}
+
+TEST(latency_percentile, should_forget_samples_out_of_window) {
+    ozo::failover::latency_percentile percentile(0.5, 10ms, 16);
+    for (int i = 0; i < 16; ++i) {
+        percentile.update(1s);
+    }
+    for (int i = 0; i < 16; ++i) {
+        percentile.update(1ms);
+    }
+    EXPECT_EQ(percentile.get(), 1ms);
+}
+
+} // namespace
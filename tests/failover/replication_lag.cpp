@@ -0,0 +1,186 @@
+#include <ozo/failover/replication_lag.h>
+
+#include "../test_error.h"
+
+#include <ozo/connection_info.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+struct connection_mock {};
+
+using connection_ptr = std::shared_ptr<connection_mock>;
+
+struct unavailable_source {
+    using connection_type = ozo::connection_type<ozo::connection_info<>>;
+
+    int id_ = 0;
+    std::vector<int>* calls_ = nullptr;
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (ozo::io_context& io, TimeConstraint, Handler&& handler) const {
+        calls_->push_back(id_);
+        boost::asio::post(io, [h = std::forward<Handler>(handler)] () mutable {
+            h(ozo::tests::error::error, connection_type{});
+        });
+    }
+};
+
+struct source {
+    using connection_type = connection_ptr;
+
+    int id_ = 0;
+    std::vector<int>* calls_ = nullptr;
+
+    template <typename TimeConstraint, typename Handler>
+    void operator() (ozo::io_context&, TimeConstraint, Handler&&) const {
+        calls_->push_back(id_);
+    }
+};
+
+} // namespace
+
+namespace ozo {
+
+template <>
+struct is_connection<connection_ptr> : std::true_type {};
+
+} // namespace ozo
+
+namespace {
+
+constexpr int master = 0;
+
+struct lag_aware_connection_source : Test {
+    ozo::io_context io;
+    std::vector<int> calls;
+    ozo::failover::lag_aware_connection_source<source> lag_aware{
+        source{master, &calls}, {source{1, &calls}, source{2, &calls}}};
+    ozo::time_traits::time_point now = ozo::time_traits::now();
+
+    template <typename Source>
+    void request(const Source& s) {
+        s(io, ozo::none, [](ozo::error_code, connection_ptr) {});
+    }
+};
+
+TEST_F(lag_aware_connection_source, should_route_unconstrained_request_to_replica_with_unknown_position) {
+    request(lag_aware);
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_NE(calls.front(), master);
+}
+
+TEST_F(lag_aware_connection_source, should_route_request_to_master_if_no_replica_position_is_known) {
+    request(lag_aware.min_lsn(1));
+    EXPECT_THAT(calls, ElementsAre(master));
+}
+
+TEST_F(lag_aware_connection_source, should_route_request_to_replica_which_has_replayed_min_lsn) {
+    lag_aware.update(0, 10, 0s, now);
+    lag_aware.update(1, 20, 0s, now);
+    request(lag_aware.min_lsn(15));
+    request(lag_aware.min_lsn(15));
+    EXPECT_THAT(calls, ElementsAre(2, 2));
+}
+
+TEST_F(lag_aware_connection_source, should_route_request_to_master_if_no_replica_has_replayed_min_lsn) {
+    lag_aware.update(0, 10, 0s, now);
+    lag_aware.update(1, 20, 0s, now);
+    request(lag_aware.min_lsn(30));
+    EXPECT_THAT(calls, ElementsAre(master));
+}
+
+TEST_F(lag_aware_connection_source, should_route_requests_between_satisfying_replicas_in_round_robin) {
+    lag_aware.update(0, 10, 0s, now);
+    lag_aware.update(1, 10, 0s, now);
+    request(lag_aware.min_lsn(5));
+    request(lag_aware.min_lsn(5));
+    ASSERT_EQ(calls.size(), 2u);
+    EXPECT_NE(calls[0], calls[1]);
+    EXPECT_NE(calls[0], master);
+    EXPECT_NE(calls[1], master);
+}
+
+TEST_F(lag_aware_connection_source, should_account_position_age_as_staleness) {
+    lag_aware.update(0, 10, 100ms, now - 2s);
+    lag_aware.update(1, 10, 100ms, now);
+    request(lag_aware.max_staleness(1s));
+    EXPECT_THAT(calls, ElementsAre(2));
+}
+
+TEST_F(lag_aware_connection_source, should_route_request_to_master_if_replicas_lag_exceeds_max_staleness) {
+    lag_aware.update(0, 10, 2s, now);
+    lag_aware.update(1, 10, 3s, now);
+    request(lag_aware.max_staleness(1s));
+    EXPECT_THAT(calls, ElementsAre(master));
+}
+
+TEST_F(lag_aware_connection_source, should_combine_requirements) {
+    lag_aware.update(0, 20, 2s, now);
+    lag_aware.update(1, 10, 0s, now);
+    const auto s = lag_aware.min_lsn(15).max_staleness(1s);
+    EXPECT_EQ(s.requirement().min_lsn, 15);
+    EXPECT_EQ(s.requirement().max_staleness, 1s);
+    request(s);
+    EXPECT_THAT(calls, ElementsAre(master));
+}
+
+TEST_F(lag_aware_connection_source, update_should_replace_position_of_rewound_replica) {
+    lag_aware.update(0, 20, 0s, now);
+    lag_aware.update(0, 10, 1s, now);
+    const auto pos = lag_aware.position(0);
+    EXPECT_TRUE(pos.known);
+    EXPECT_EQ(pos.lsn, 10);
+    EXPECT_EQ(pos.lag, 1s);
+}
+
+TEST_F(lag_aware_connection_source, should_route_request_to_master_if_replica_position_is_invalidated) {
+    lag_aware.update(0, 20, 0s, now);
+    lag_aware.update(1, 20, 0s, now);
+    lag_aware.invalidate(0, now);
+    lag_aware.invalidate(1, now);
+    EXPECT_FALSE(lag_aware.position(0).known);
+    request(lag_aware.min_lsn(10));
+    EXPECT_THAT(calls, ElementsAre(master));
+}
+
+TEST_F(lag_aware_connection_source, copies_should_share_replicas_positions) {
+    const auto copy = lag_aware.min_lsn(5);
+    lag_aware.update(1, 10, 0s, now);
+    EXPECT_EQ(copy.position(1).lsn, 10);
+    EXPECT_EQ(lag_aware.requirement().min_lsn, 0);
+}
+
+TEST_F(lag_aware_connection_source, should_model_connection_source) {
+    EXPECT_TRUE(ozo::ConnectionSource<decltype(lag_aware)>);
+    EXPECT_EQ(lag_aware.size(), 2u);
+}
+
+TEST(lag_aware_connection_source_monitoring, should_route_request_to_master_if_replica_stops_answering) {
+    ozo::io_context io;
+    std::vector<int> calls;
+    ozo::failover::lag_aware_connection_source<unavailable_source> lag_aware{
+        unavailable_source{master, &calls}, {unavailable_source{1, &calls}}};
+    lag_aware.update(0, 20, 0s);
+
+    lag_aware.start_monitoring(io, 1h);
+    io.poll();
+    EXPECT_THAT(calls, ElementsAre(1));
+    EXPECT_FALSE(lag_aware.position(0).known);
+
+    calls.clear();
+    lag_aware(io, ozo::none, [](ozo::error_code, auto) {});
+    lag_aware.min_lsn(10)(io, ozo::none, [](ozo::error_code, auto) {});
+    EXPECT_THAT(calls, ElementsAre(1, master));
+
+    lag_aware.stop_monitoring();
+    io.restart();
+    io.run();
+}
+
+} // namespace
@@ -4,6 +4,7 @@
 
 #include <boost/hana/equal.hpp>
 #include <boost/hana/not_equal.hpp>
+#include <boost/asio/bind_executor.hpp>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -160,6 +161,43 @@ TEST_F(basic_try__get_next_try, should_return_null_state_for_matching_error_and_
     EXPECT_FALSE(next_try->get_next_try(ozo::tests::error::error, null_conn));
 }
 
+TEST_F(basic_try__get_next_try, should_return_null_state_if_retry_budget_is_exhausted) {
+    using op = ozo::failover::retry_options;
+    ozo::failover::retry_budget budget(0.0, 1.0);
+    const auto basic_try = [&] {
+        return ozo::failover::basic_try(ozo::make_options(op::tries = 3, op::budget = std::ref(budget)), ctx());
+    };
+    EXPECT_TRUE(basic_try().get_next_try(ozo::tests::error::error, null_conn));
+    EXPECT_FALSE(basic_try().get_next_try(ozo::tests::error::error, null_conn));
+}
+
+TEST_F(basic_try__get_next_try, should_not_withdraw_retry_budget_for_nonmatching_error) {
+    using op = ozo::failover::retry_options;
+    ozo::failover::retry_budget budget(0.0, 1.0);
+    auto basic_try = ozo::failover::basic_try(ozo::make_options(
+        op::tries = 3,
+        op::conditions = hana::make_tuple(ozo::tests::errc::error),
+        op::budget = std::ref(budget)
+    ), ctx());
+    EXPECT_FALSE(basic_try.get_next_try(ozo::tests::error::ok, null_conn));
+    EXPECT_EQ(budget.tokens(), 1.0);
+}
+
+TEST_F(basic_try__get_next_try, should_set_delay_of_next_try_from_backoff_by_retry_number) {
+    using op = ozo::failover::retry_options;
+    auto first_try = ozo::failover::basic_try(ozo::make_options(
+        op::tries = 3,
+        op::backoff = [](int n) { return duration(10ms) * (n + 1); }
+    ), ctx());
+    EXPECT_EQ(first_try.delay(), duration::zero());
+    auto second_try = first_try.get_next_try(ozo::tests::error::error, null_conn);
+    ASSERT_TRUE(second_try);
+    EXPECT_EQ(second_try->delay(), 10ms);
+    auto third_try = second_try->get_next_try(ozo::tests::error::error, null_conn);
+    ASSERT_TRUE(third_try);
+    EXPECT_EQ(third_try->delay(), 20ms);
+}
+
 TEST_F(basic_try__get_next_try, should_close_connection_on_retry_if_option_is_omitted) {
     auto basic_try = make_basic_try(3, hana::make_tuple(), ctx());
     EXPECT_CALL(conn, close_connection());
@@ -228,6 +266,14 @@ TEST_F(basic_try__get_context, should_return_additional_arguments_form_context)
     EXPECT_EQ(basic_try.get_context()[hana::size_c<3>], "strong"s);
 }
 
+TEST_F(basic_try__get_context, should_return_query_form_context_with_cached_binary_representation) {
+    auto basic_try = make_basic_try(3, errcs,
+        ozo::failover::basic_context(std::addressof(provider), ozo::none, ozo::make_query("query", 42)));
+    const auto first = ozo::to_binary_query(basic_try.get_context()[hana::size_c<2>], ozo::empty_oid_map{});
+    const auto second = ozo::to_binary_query(basic_try.get_context()[hana::size_c<2>], ozo::empty_oid_map{});
+    EXPECT_EQ(first.values(), second.values());
+}
+
 TEST_F(basic_try__get_context, should_return_claculated_time_out_form_context) {
     auto basic_try = make_basic_try(3, errcs,
         ozo::failover::basic_context(std::addressof(provider), 3s));
@@ -259,4 +305,107 @@ TEST(basic_try__retry_conditions, should_return_retry_conditions) {
         << to_string(basic_try.get_conditions()) << "!=" << to_string(conditions);
 }
 
+struct recording_connection_provider {
+    using connection_type = connection_mock*;
+
+    std::vector<duration>* calls_ = nullptr;
+
+    template <typename TimeConstraint, typename Handler>
+    void async_get_connection(TimeConstraint, Handler&& h) const {
+        calls_->push_back(duration::zero());
+        h(ozo::error_code{}, nullptr);
+    }
+};
+
+struct backoff_connection_provider : Test {
+    ozo::io_context io;
+    std::vector<duration> calls;
+    StrictMock<MockFunction<void(ozo::error_code, connection_mock*)>> callback;
+
+    auto handler() {
+        return boost::asio::bind_executor(io, [this](ozo::error_code ec, connection_mock* conn) {
+            callback.Call(ec, conn);
+        });
+    }
+};
+
+TEST_F(backoff_connection_provider, should_get_connection_immediately_for_zero_delay) {
+    ozo::failover::detail::backoff_connection_provider<recording_connection_provider> provider{{&calls}, duration::zero()};
+    EXPECT_CALL(callback, Call(ozo::error_code{}, nullptr));
+    ozo::async_get_connection(provider, ozo::none, handler());
+    EXPECT_EQ(calls.size(), 1u);
+}
+
+TEST_F(backoff_connection_provider, should_get_connection_after_delay_on_handler_executor) {
+    ozo::failover::detail::backoff_connection_provider<recording_connection_provider> provider{{&calls}, 1ms};
+    ozo::async_get_connection(provider, 1s, handler());
+    EXPECT_TRUE(calls.empty());
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}, nullptr));
+    io.run();
+    EXPECT_EQ(calls.size(), 1u);
+}
+
+TEST(basic_try__backoff, get_context_should_wrap_provider_with_backoff_connection_provider) {
+    using op = ozo::failover::retry_options;
+    auto basic_try = ozo::failover::basic_try(ozo::make_options(
+        op::tries = 3,
+        op::backoff = [](int) { return duration(1ms); }
+    ), ozo::failover::basic_context(recording_connection_provider{}, ozo::none));
+    EXPECT_TRUE((std::is_same_v<std::decay_t<decltype(basic_try.get_context()[hana::size_c<0>])>,
+        ozo::failover::detail::backoff_connection_provider<recording_connection_provider>>));
+}
+
+TEST(exponential_backoff, should_return_delay_in_range_from_zero_to_base_multiplied_by_power_of_two) {
+    const ozo::failover::exponential_backoff backoff{10ms, 1s};
+    for (int i = 0; i < 100; ++i) {
+        const auto first = backoff(0);
+        EXPECT_GE(first, duration::zero());
+        EXPECT_LE(first, 10ms);
+        const auto third = backoff(2);
+        EXPECT_GE(third, duration::zero());
+        EXPECT_LE(third, 40ms);
+    }
+}
+
+TEST(exponential_backoff, should_not_exceed_cap) {
+    const ozo::failover::exponential_backoff backoff{10ms, 50ms};
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_LE(backoff(10), 50ms);
+        EXPECT_LE(backoff(1000), 50ms);
+    }
+}
+
+TEST(retry_budget, should_allow_retries_up_to_reserve) {
+    ozo::failover::retry_budget budget(0.1, 2);
+    EXPECT_TRUE(budget.try_withdraw());
+    EXPECT_TRUE(budget.try_withdraw());
+    EXPECT_FALSE(budget.try_withdraw());
+}
+
+TEST(retry_budget, should_allow_retry_per_ratio_of_operations) {
+    ozo::failover::retry_budget budget(0.5, 1);
+    EXPECT_TRUE(budget.try_withdraw());
+    budget.deposit();
+    EXPECT_FALSE(budget.try_withdraw());
+    budget.deposit();
+    EXPECT_TRUE(budget.try_withdraw());
+}
+
+TEST(retry_budget, should_not_hold_more_tokens_than_reserve) {
+    ozo::failover::retry_budget budget(1, 2);
+    for (int i = 0; i < 10; ++i) {
+        budget.deposit();
+    }
+    EXPECT_EQ(budget.tokens(), 2.0);
+}
+
+TEST(retry_strategy, get_first_try_should_deposit_retry_budget) {
+    auto budget = std::make_shared<ozo::failover::retry_budget>(0.5, 1);
+    ASSERT_TRUE(budget->try_withdraw());
+    const auto strategy = (ozo::failover::retry()*3).set(ozo::failover::retry_options::budget = budget);
+    strategy.get_first_try(0, std::allocator<char>{}, recording_connection_provider{}, ozo::none);
+    EXPECT_EQ(budget->tokens(), 0.5);
+}
+
 } // namespace
@@ -37,7 +37,9 @@ struct role_based_connection_source_mock {
     MOCK_CONST_METHOD1(rebind_role, void(std::decay_t<decltype(ozo::failover::master)>));
     MOCK_CONST_METHOD1(rebind_role, void(std::decay_t<decltype(ozo::failover::replica)>));
     MOCK_CONST_METHOD1(rebind_role, void(std::decay_t<decltype(test_role)>));
+    MOCK_CONST_METHOD1(rebind_role, void(std::decay_t<decltype(another_test_role)>));
     MOCK_CONST_METHOD0(move, void());
+    bool available = true;
 };
 
 template <typename Role>
@@ -62,6 +64,8 @@ struct role_based_connection_source {
         mock_->call(std::forward<Handler>(h));
     }
 
+    bool is_available() const { return mock_->available; }
+
     role_based_connection_source_mock* mock_ = nullptr;
 };
 
@@ -233,6 +237,18 @@ TEST_F(role_based_try__initiate_next_try, should_not_call_initiator_for_non_matc
     role_based_try.initiate_next_try(ozo::tests::error::another_error, null_conn, std::cref(initiator));
 }
 
+TEST_F(role_based_try__initiate_next_try, should_not_call_initiator_for_unavailable_fallback_source) {
+    auto role_based_try = ozo::failover::role_based_try(
+        ozo::make_options(
+            opt::roles=hana::make_tuple(test_role, test_role)
+        ), ctx()
+    );
+    source.available = false;
+    EXPECT_CALL(source, rebind_role(An<std::decay_t<decltype(test_role)>>())).Times(AnyNumber());
+    EXPECT_CALL(initiator, call()).Times(0);
+    role_based_try.initiate_next_try(ozo::tests::error::error, null_conn, std::cref(initiator));
+}
+
 TEST_F(role_based_try__initiate_next_try, should_not_call_initiator_for_no_roles_left) {
     auto role_based_try = ozo::failover::role_based_try(
         ozo::make_options(
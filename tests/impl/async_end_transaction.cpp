@@ -38,4 +38,78 @@ TEST_F(async_end_transaction, should_call_async_execute) {
     ozo::detail::async_end_transaction(std::move(transaction), empty_query {}, timeout, wrap(callback));
 }
 
+TEST_F(async_end_transaction, should_report_output_error_after_commit_as_committed) {
+    execution_context cb_io;
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {ozo::error::bad_result_process_after_commit}, _)).WillOnce(Return());
+
+    ozo::detail::make_async_end_transaction_op(wrap(callback))
+        (ozo::error::bad_result_process, ozo::transaction(std::move(conn), options));
+}
+
+struct async_end_nested_transaction : Test {
+    decltype(ozo::make_options()) options = ozo::make_options();
+    using outer_type = ozo::transaction<connection_ptr<>, decltype(options)>;
+    using nested_type = ozo::transaction<outer_type, decltype(options)>;
+    StrictMock<connection_gmock> connection {};
+    StrictMock<callback_gmock<outer_type>> callback {};
+    execution_context cb_io;
+    io_context io;
+    StrictMock<PGconn_mock> handle;
+    connection_ptr<> conn = make_connection(connection, io, handle);
+
+    nested_type make_nested(std::vector<std::string> deferred) {
+        nested_type nested(outer_type(std::move(conn), options), options);
+        for (auto& statement : deferred) {
+            nested.defer_statement(std::move(statement));
+        }
+        return nested;
+    }
+
+    void expect_outer_statements(std::vector<std::string> expected) {
+        EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+        EXPECT_CALL(cb_io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+        EXPECT_CALL(callback, call(error_code {}, _))
+            .WillOnce(Invoke([expected] (error_code, auto outer) {
+                EXPECT_EQ(take_deferred_statements(outer), expected);
+            }));
+    }
+};
+
+TEST_F(async_end_nested_transaction, commit_should_drop_savepoint_which_has_not_been_sent) {
+    expect_outer_statements({"BEGIN"});
+    ozo::detail::async_end_nested_transaction(make_nested({"BEGIN", "SAVEPOINT ozo_savepoint_1"}),
+        true, wrap(callback));
+}
+
+TEST_F(async_end_nested_transaction, rollback_should_drop_savepoint_which_has_not_been_sent) {
+    expect_outer_statements({});
+    ozo::detail::async_end_nested_transaction(make_nested({"SAVEPOINT ozo_savepoint_1"}),
+        false, wrap(callback));
+}
+
+TEST_F(async_end_nested_transaction, commit_should_defer_release_savepoint) {
+    expect_outer_statements({"RELEASE SAVEPOINT ozo_savepoint_1"});
+    ozo::detail::async_end_nested_transaction(make_nested({}), true, wrap(callback));
+}
+
+TEST_F(async_end_nested_transaction, rollback_should_defer_rollback_to_and_release_savepoint) {
+    expect_outer_statements({"ROLLBACK TO SAVEPOINT ozo_savepoint_1", "RELEASE SAVEPOINT ozo_savepoint_1"});
+    ozo::detail::async_end_nested_transaction(make_nested({}), false, wrap(callback));
+}
+
+TEST_F(async_end_nested_transaction, last_request_output_error_should_not_defer_rollback_of_released_savepoint) {
+    using op_type = ozo::detail::async_end_nested_transaction_op<decltype(wrap(callback))>;
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {ozo::error::bad_result_process_after_commit}, _))
+        .WillOnce(Invoke([] (error_code, auto outer) {
+            EXPECT_FALSE(outer.has_deferred_statements());
+        }));
+
+    ozo::detail::make_async_end_nested_transaction_op(wrap(callback), op_type::savepoint_action::none)
+        (ozo::error::bad_result_process, make_nested({}));
+}
+
 } // namespace
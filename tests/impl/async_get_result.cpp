@@ -452,4 +452,11 @@ INSTANTIATE_TEST_SUITE_P(
     async_get_result_,
     Values(PGRES_COPY_OUT, PGRES_COPY_IN, PGRES_COPY_BOTH, PGRES_NONFATAL_ERROR));
 
+#ifdef LIBPQ_HAS_PIPELINING
+INSTANTIATE_TEST_SUITE_P(
+    with_pipeline_result_status,
+    async_get_result_,
+    Values(PGRES_PIPELINE_SYNC, PGRES_PIPELINE_ABORTED));
+#endif
+
 } // namespace
@@ -116,4 +116,184 @@ TEST_F(async_request_op, should_cancel_connection_io_on_timeout) {
     ozo::impl::async_request_op{empty_query {}, timeout, ozo::none, wrap(callback)}(error_code {}, conn);
 }
 
+#ifdef LIBPQ_HAS_PIPELINING
+
+using transaction_type = ozo::transaction<connection_ptr<>, decltype(ozo::make_options())>;
+
+struct async_request_op_with_deferred_statements : async_request_op {
+    StrictMock<callback_gmock<transaction_type>> transaction_callback {};
+    transaction_type transaction {connection_ptr<>(conn), ozo::make_options()};
+    ozo::tests::pg_result begin_result {PGRES_COMMAND_OK, nullptr};
+    ozo::tests::pg_result query_result {PGRES_TUPLES_OK, nullptr};
+    ozo::tests::pg_result failed_result {PGRES_FATAL_ERROR, "40001"};
+    ozo::tests::pg_result aborted_result {PGRES_PIPELINE_ABORTED, nullptr};
+    ozo::tests::pg_result sync_result {PGRES_PIPELINE_SYNC, nullptr};
+
+    async_request_op_with_deferred_statements() {
+        transaction.defer_statement("BEGIN");
+    }
+};
+
+TEST_F(async_request_op_with_deferred_statements, should_send_deferred_statements_and_query_in_one_pipeline) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(transaction_callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQenterPipelineMode()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("BEGIN"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq(""), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQpipelineSync()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&begin_result));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(connection, async_wait_read(_)).InSequence(s).WillOnce(InvokeArgument<0>(error_code {}));
+    EXPECT_CALL(strand, post(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(native_handle, PQconsumeInput()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&query_result));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQisBusy()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&sync_result));
+    EXPECT_CALL(native_handle, PQexitPipelineMode()).InSequence(s).WillOnce(Return(1));
+
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(transaction_callback, call(error_code {}, _)).InSequence(s)
+        .WillOnce(Invoke([] (error_code, transaction_type transaction) {
+            EXPECT_FALSE(transaction.has_deferred_statements());
+        }));
+
+    ozo::impl::async_request_op{empty_query {}, ozo::none, ozo::none, wrap(transaction_callback)}(error_code {}, std::move(transaction));
+}
+
+TEST_F(async_request_op_with_deferred_statements, should_call_handler_with_error_of_failed_deferred_statement) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(transaction_callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQenterPipelineMode()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("BEGIN"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq(""), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQpipelineSync()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+
+    EXPECT_CALL(native_handle, PQisBusy()).WillRepeatedly(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&failed_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&aborted_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&sync_result));
+    EXPECT_CALL(native_handle, PQexitPipelineMode()).InSequence(s).WillOnce(Return(1));
+
+    EXPECT_CALL(connection, cancel()).InSequence(s).WillOnce(Return());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(transaction_callback, call(ozo::sqlstate::make_error_code(ozo::sqlstate::serialization_failure), _)).InSequence(s)
+        .WillOnce(Invoke([] (error_code, transaction_type transaction) {
+            EXPECT_EQ(ozo::get_error_context(transaction), "error in pipeline statement: BEGIN");
+        }));
+
+    ozo::impl::async_request_op{empty_query {}, ozo::none, ozo::none, wrap(transaction_callback)}(error_code {}, std::move(transaction));
+}
+
+TEST_F(async_request_op_with_deferred_statements, should_send_epilogue_after_query_in_one_pipeline) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQenterPipelineMode()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq(""), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("COMMIT"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQpipelineSync()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+
+    EXPECT_CALL(native_handle, PQisBusy()).WillRepeatedly(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&query_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&begin_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&sync_result));
+    EXPECT_CALL(native_handle, PQexitPipelineMode()).InSequence(s).WillOnce(Return(1));
+
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {}, _)).InSequence(s).WillOnce(Return());
+
+    ozo::impl::async_request_op{empty_query {}, ozo::none, ozo::none, wrap(callback), "COMMIT"}(error_code {}, conn);
+}
+
+TEST_F(async_request_op_with_deferred_statements, should_call_handler_with_error_of_failed_epilogue_instead_of_output_error) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQenterPipelineMode()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq(""), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("COMMIT"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQpipelineSync()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+
+    EXPECT_CALL(native_handle, PQisBusy()).WillRepeatedly(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&query_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&failed_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&sync_result));
+    EXPECT_CALL(native_handle, PQexitPipelineMode()).InSequence(s).WillOnce(Return(1));
+
+    EXPECT_CALL(connection, cancel()).InSequence(s).WillOnce(Return());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(ozo::sqlstate::make_error_code(ozo::sqlstate::serialization_failure), _)).InSequence(s)
+        .WillOnce(Invoke([] (error_code, auto conn) {
+            EXPECT_EQ(ozo::get_error_context(conn), "error in pipeline statement: COMMIT");
+        }));
+
+    const auto failing_out = [] (auto&&, auto&) { throw std::runtime_error("conversion failed"); };
+    ozo::impl::async_request_op{empty_query {}, ozo::none, failing_out, wrap(callback), "COMMIT"}(error_code {}, conn);
+}
+
+TEST_F(async_request_op_with_deferred_statements, should_call_handler_with_output_error_after_succeeded_epilogue) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQenterPipelineMode()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq(""), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("COMMIT"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQpipelineSync()).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+
+    EXPECT_CALL(native_handle, PQisBusy()).WillRepeatedly(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&query_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&begin_result));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&sync_result));
+    EXPECT_CALL(native_handle, PQexitPipelineMode()).InSequence(s).WillOnce(Return(1));
+
+    EXPECT_CALL(connection, cancel()).InSequence(s).WillOnce(Return());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {ozo::error::bad_result_process}, _)).InSequence(s)
+        .WillOnce(Invoke([] (error_code, auto conn) {
+            EXPECT_EQ(ozo::get_error_context(conn), "conversion failed");
+        }));
+
+    const auto failing_out = [] (auto&&, auto&) { throw std::runtime_error("conversion failed"); };
+    ozo::impl::async_request_op{empty_query {}, ozo::none, failing_out, wrap(callback), "COMMIT"}(error_code {}, conn);
+}
+
+#endif
+
 } // namespace
@@ -56,6 +56,23 @@ TEST_F(async_send_query_params_op, should_set_non_blocking_mode_and_send_query_p
     EXPECT_EQ(m.ctx->state, ozo::impl::query_state::send_in_progress);
 }
 
+TEST_F(async_send_query_params_op, should_send_query_prepared_for_prepared_statement_query) {
+    const InSequence s;
+
+    EXPECT_CALL(m.native_handle, PQsetnonblocking(1)).WillOnce(Return(0));
+    EXPECT_CALL(m.native_handle, PQsendQueryPrepared(StrEq("ozo_statement"), 1, _, _, _, 1)).WillOnce(Return(1));
+    EXPECT_CALL(m.native_handle, PQflush())
+        .WillOnce(Return(1));
+    EXPECT_CALL(m.connection, async_wait_write(_))
+        .WillOnce(Return());
+
+    const auto query = ozo::to_binary_query(
+        ozo::make_query(ozo::prepared_statement {"ozo_statement"}, std::int32_t(42)), ozo::empty_oid_map_c);
+    ozo::impl::async_send_query_params_op(m.ctx, query).perform();
+
+    EXPECT_EQ(m.ctx->state, ozo::impl::query_state::send_in_progress);
+}
+
 TEST_F(async_send_query_params_op, should_set_error_state_and_cancel_io_and_invoke_callback_with_error_if_pg_set_nonbloking_failed) {
     const InSequence s;
 
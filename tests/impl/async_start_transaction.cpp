@@ -34,4 +34,63 @@ TEST_F(async_start_transaction, should_call_async_execute) {
     ozo::detail::async_start_transaction(conn, options, empty_query {}, timeout, wrap(callback));
 }
 
+struct async_start_pipelined_transaction : Test {
+    decltype(ozo::make_options(ozo::transaction_options::pipelined = true)) options =
+        ozo::make_options(ozo::transaction_options::pipelined = true);
+    StrictMock<connection_gmock> connection {};
+    StrictMock<callback_gmock<ozo::transaction<connection_ptr<>, decltype(options)>>> callback {};
+    execution_context cb_io;
+    io_context io;
+    StrictMock<PGconn_mock> handle;
+    connection_ptr<> conn = make_connection(connection, io, handle);
+    time_traits::duration timeout {42};
+};
+
+TEST_F(async_start_pipelined_transaction, should_not_execute_begin_statement_but_defer_it) {
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    const InSequence s;
+
+    EXPECT_CALL(io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {}, _))
+        .WillOnce(Invoke([] (error_code, auto transaction) {
+            EXPECT_THAT(take_deferred_statements(transaction), ElementsAre("BEGIN ISOLATION LEVEL SERIALIZABLE"));
+        }));
+
+    ozo::detail::async_start_transaction(conn, options, ozo::make_query("BEGIN ISOLATION LEVEL SERIALIZABLE"),
+        timeout, wrap(callback));
+}
+
+struct async_start_nested_transaction : Test {
+    decltype(ozo::make_options()) options = ozo::make_options();
+    using outer_type = ozo::transaction<connection_ptr<>, decltype(options)>;
+    StrictMock<connection_gmock> connection {};
+    StrictMock<callback_gmock<ozo::transaction<outer_type, decltype(options)>>> callback {};
+    execution_context cb_io;
+    io_context io;
+    StrictMock<PGconn_mock> handle;
+    connection_ptr<> conn = make_connection(connection, io, handle);
+    time_traits::duration timeout {42};
+};
+
+TEST_F(async_start_nested_transaction, should_not_execute_savepoint_statement_but_defer_it_after_outer_statements) {
+    outer_type outer(std::move(conn), options);
+    outer.defer_statement("BEGIN");
+
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    const InSequence s;
+
+    EXPECT_CALL(io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {}, _))
+        .WillOnce(Invoke([] (error_code, auto transaction) {
+            EXPECT_THAT(take_deferred_statements(transaction), ElementsAre("BEGIN", "SAVEPOINT ozo_savepoint_1"));
+        }));
+
+    ozo::detail::async_start_transaction(std::move(outer), options, ozo::make_query("BEGIN"),
+        timeout, wrap(callback));
+}
+
 } // namespace
@@ -0,0 +1,161 @@
+#include <connection_mock.h>
+#include <test_error.h>
+
+#include <ozo/transaction_script.h>
+#include <ozo/time_traits.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace testing;
+using namespace ozo::tests;
+
+using callback_mock = callback_gmock<connection_ptr<>>;
+
+using ozo::error_code;
+
+#ifdef LIBPQ_HAS_PIPELINING
+
+struct async_transaction_script_op : Test {
+    StrictMock<connection_gmock> connection {};
+    StrictMock<PGconn_mock> native_handle{};
+    StrictMock<callback_mock> callback {};
+    StrictMock<executor_mock> strand {};
+    io_context io;
+    execution_context cb_io;
+    connection_ptr<> conn = make_connection(connection, io, native_handle);
+    ozo::tests::pg_result command_result {PGRES_COMMAND_OK, nullptr};
+    ozo::tests::pg_result query_result {PGRES_TUPLES_OK, nullptr};
+    ozo::tests::pg_result failed_result {PGRES_FATAL_ERROR, "40001"};
+    ozo::tests::pg_result aborted_result {PGRES_PIPELINE_ABORTED, nullptr};
+    ozo::tests::pg_result sync_result {PGRES_PIPELINE_SYNC, nullptr};
+
+    auto make_op() {
+        return ozo::impl::async_transaction_script_op{
+            ozo::detail::begin_statement_builder::build(ozo::make_options()),
+            std::make_tuple(empty_query {}, empty_query {}),
+            ozo::none,
+            std::make_tuple(ozo::none, ozo::none),
+            wrap(callback)
+        };
+    }
+
+    void expect_send_script(Sequence& s) {
+        EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+        EXPECT_CALL(native_handle, PQenterPipelineMode()).InSequence(s).WillOnce(Return(1));
+        EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("BEGIN"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+        EXPECT_CALL(native_handle, PQsendQueryParams(StrEq(""), 0, _, _, _, _, _)).Times(2).InSequence(s).WillRepeatedly(Return(1));
+        EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("COMMIT"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+        EXPECT_CALL(native_handle, PQpipelineSync()).InSequence(s).WillOnce(Return(1));
+        EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+    }
+
+    void expect_results(Sequence& s, std::vector<ozo::tests::pg_result*> results) {
+        EXPECT_CALL(native_handle, PQisBusy()).WillRepeatedly(Return(0));
+        for (const auto result : results) {
+            EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(result));
+            EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+        }
+        EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(&sync_result));
+        EXPECT_CALL(native_handle, PQexitPipelineMode()).InSequence(s).WillOnce(Return(1));
+    }
+};
+
+TEST_F(async_transaction_script_op, should_send_begin_queries_and_commit_in_one_pipeline) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    expect_send_script(s);
+    expect_results(s, {&command_result, &query_result, &query_result, &command_result});
+
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(error_code {}, _)).InSequence(s).WillOnce(Return());
+
+    make_op()(error_code {}, conn);
+}
+
+TEST_F(async_transaction_script_op, should_rollback_failed_transaction_and_call_handler_with_error_of_failed_query) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillRepeatedly(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    expect_send_script(s);
+    expect_results(s, {&command_result, &failed_result, &aborted_result, &aborted_result});
+
+    EXPECT_CALL(connection, cancel()).InSequence(s).WillOnce(Return());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(native_handle, PQtransactionStatus()).InSequence(s).WillOnce(Return(PQTRANS_INERROR));
+
+    EXPECT_CALL(io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQsendQueryParams(StrEq("ROLLBACK"), 0, _, _, _, _, _)).InSequence(s).WillOnce(Return(1));
+    EXPECT_CALL(native_handle, PQflush()).InSequence(s).WillOnce(Return(0));
+    EXPECT_CALL(native_handle, PQgetResult()).InSequence(s).WillOnce(Return(nullptr));
+
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(ozo::sqlstate::make_error_code(ozo::sqlstate::serialization_failure), _)).InSequence(s)
+        .WillOnce(Invoke([] (error_code, connection_ptr<> conn) {
+            EXPECT_EQ(ozo::get_error_context(conn), "error in pipeline statement: ");
+        }));
+
+    make_op()(error_code {}, conn);
+}
+
+TEST_F(async_transaction_script_op, should_not_rollback_when_connection_is_not_in_transaction) {
+    EXPECT_CALL(io.strand_service_, get_executor()).WillOnce(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    expect_send_script(s);
+    expect_results(s, {&failed_result, &aborted_result, &aborted_result, &aborted_result});
+
+    EXPECT_CALL(connection, cancel()).InSequence(s).WillOnce(Return());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(native_handle, PQtransactionStatus()).InSequence(s).WillOnce(Return(PQTRANS_IDLE));
+    EXPECT_CALL(callback, call(ozo::sqlstate::make_error_code(ozo::sqlstate::serialization_failure), _)).InSequence(s)
+        .WillOnce(Return());
+
+    make_op()(error_code {}, conn);
+}
+
+TEST_F(async_transaction_script_op, should_report_output_error_as_committed_without_rollback) {
+    EXPECT_CALL(callback, call(error_code {ozo::error::bad_result_process_after_commit}, _)).WillOnce(Return());
+
+    ozo::impl::async_transaction_script_rollback_op{wrap(callback), ozo::none}(ozo::error::bad_result_process, conn);
+}
+
+TEST_F(async_transaction_script_op, should_limit_rollback_with_script_deadline) {
+    const auto deadline = ozo::time_traits::now() + std::chrono::seconds(1);
+    StrictMock<steady_timer_mock> timer;
+    std::function<void (error_code)> on_timer_expired;
+    EXPECT_CALL(io.strand_service_, get_executor()).WillRepeatedly(ReturnRef(strand));
+    EXPECT_CALL(callback, get_executor()).WillRepeatedly(Return(cb_io.get_executor()));
+
+    Sequence s;
+
+    EXPECT_CALL(native_handle, PQtransactionStatus()).InSequence(s).WillOnce(Return(PQTRANS_INERROR));
+    EXPECT_CALL(io.executor_, dispatch(_)).InSequence(s).WillOnce(InvokeArgument<0>());
+    EXPECT_CALL(io.timer_service_, timer(deadline)).InSequence(s).WillOnce(ReturnRef(timer));
+    EXPECT_CALL(timer, async_wait(_)).InSequence(s).WillOnce(SaveArg<0>(&on_timer_expired));
+    EXPECT_CALL(native_handle, PQsetnonblocking(1)).InSequence(s).WillOnce(Return(-1));
+    EXPECT_CALL(timer, cancel()).WillRepeatedly(Return(1));
+    EXPECT_CALL(connection, cancel()).WillRepeatedly(Return());
+    EXPECT_CALL(strand, post(_)).WillRepeatedly(InvokeArgument<0>());
+    EXPECT_CALL(cb_io.executor_, dispatch(_)).WillRepeatedly(InvokeArgument<0>());
+    EXPECT_CALL(callback, call(ozo::sqlstate::make_error_code(ozo::sqlstate::serialization_failure), _)).WillOnce(Return());
+
+    ozo::impl::async_transaction_script_rollback_op{wrap(callback), deadline}(
+        ozo::sqlstate::make_error_code(ozo::sqlstate::serialization_failure), conn);
+    on_timer_expired(boost::asio::error::operation_aborted);
+}
+
+#endif
+
+} // namespace
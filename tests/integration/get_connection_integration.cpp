@@ -1,4 +1,7 @@
 #include <ozo/connection_info.h>
+#include <ozo/request.h>
+#include <ozo/shortcuts.h>
+#include <ozo/statistics.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -36,4 +39,59 @@ TEST(get_connection, should_return_connection_for_max_connect_timeout) {
     io.run();
 }
 
+TEST(get_connection, should_execute_session_statements_on_new_connection) {
+    using namespace ozo::literals;
+    ozo::io_context io;
+    const ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO,
+        {"SET application_name = 'ozo_session_test'", "SET statement_timeout = 12345"});
+
+    std::atomic_flag called {};
+    ozo::rows_of<std::string, std::string> rows;
+    const auto query = "SELECT current_setting('application_name'), current_setting('statement_timeout')"_SQL;
+    ozo::request(conn_info[io], query, std::chrono::seconds(1), ozo::into(rows), [&] (ozo::error_code ec, auto conn) {
+        EXPECT_FALSE(called.test_and_set());
+        ASSERT_FALSE(ec) << ec.message() << "|" << ozo::error_message(conn) << "|" << ozo::get_error_context(conn);
+        ASSERT_EQ(rows.size(), 1u);
+        EXPECT_EQ(std::get<0>(rows.front()), "ozo_session_test");
+        EXPECT_EQ(std::get<1>(rows.front()), "12345ms");
+    });
+
+    io.run();
+    EXPECT_TRUE(called.test_and_set());
+}
+
+TEST(get_connection, should_return_error_for_failed_session_statement) {
+    ozo::io_context io;
+    const ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO,
+        {"SET application_name = 'ozo_session_test'", "SET ozo_no_such_parameter = 1"});
+
+    std::atomic_flag called {};
+    ozo::get_connection(conn_info[io], std::chrono::seconds(1), [&] (ozo::error_code ec, auto conn) {
+        EXPECT_FALSE(called.test_and_set());
+        EXPECT_EQ(ec, ozo::sqlstate::undefined_object);
+        EXPECT_FALSE(ozo::get_error_context(conn).empty());
+    });
+
+    io.run();
+    EXPECT_TRUE(called.test_and_set());
+}
+
+TEST(get_connection, should_report_connect_phases_to_statistics) {
+    ozo::io_context io;
+    const ozo::connect_statistics statistics;
+    const ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO, ozo::empty_oid_map{}, statistics);
+
+    std::atomic_flag called {};
+    ozo::get_connection(conn_info[io], std::chrono::seconds(1), [&] (ozo::error_code ec, auto conn) {
+        EXPECT_FALSE(called.test_and_set());
+        EXPECT_FALSE(ec) << ec.message() << "|" << ozo::error_message(conn) << "|" << ozo::get_error_context(conn);
+    });
+
+    io.run();
+    EXPECT_TRUE(called.test_and_set());
+    EXPECT_EQ(statistics.histograms()[ozo::connect_phase::resolve].count(), 1u);
+    EXPECT_EQ(statistics.histograms()[ozo::connect_phase::connect].count(), 1u);
+    EXPECT_EQ(statistics.histograms()[ozo::connect_phase::bootstrap].count(), 0u);
+}
+
 } // namespace
@@ -0,0 +1,56 @@
+#include <ozo/connection_info.h>
+#include <ozo/query_builder.h>
+#include <ozo/request.h>
+#include <ozo/shortcuts.h>
+#include <ozo/failover/hedged.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+#define ASSERT_REQUEST_OK(ec, conn)\
+    ASSERT_FALSE(ec) << ec.message() \
+        << "|" << ozo::error_message(conn) \
+        << "|" << (!ozo::is_null_recursive(conn) ? ozo::get_error_context(conn) : "") << std::endl
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+TEST(request, should_return_success_for_hedged_request) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info<> conn_info(OZO_PG_TEST_CONNINFO);
+
+    std::vector<int> res;
+    int calls = 0;
+    ozo::request[ozo::failover::hedge(0ms)](conn_info[io], "SELECT 1"_SQL + " + 1"_SQL, 1s, ozo::into(res),
+            [&](ozo::error_code ec, auto conn) {
+        ++calls;
+        ASSERT_REQUEST_OK(ec, conn);
+        EXPECT_EQ(res.front(), 2);
+    });
+
+    io.run();
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(request, should_return_success_for_request_hedged_by_latency_percentile) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info<> conn_info(OZO_PG_TEST_CONNINFO);
+    auto percentile = std::make_shared<ozo::failover::latency_percentile>(0.9, 100ms);
+
+    std::vector<int> res;
+    ozo::request[ozo::failover::hedge(percentile)](conn_info[io], "SELECT 2"_SQL, 10s, ozo::into(res),
+            [&](ozo::error_code ec, auto conn) {
+        ASSERT_REQUEST_OK(ec, conn);
+        EXPECT_EQ(res.front(), 2);
+    });
+
+    io.run();
+}
+
+} // namespace
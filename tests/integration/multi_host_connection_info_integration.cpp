@@ -0,0 +1,62 @@
+#include <ozo/multi_host_connection_info.h>
+#include <ozo/request.h>
+#include <ozo/shortcuts.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace std::chrono_literals;
+using namespace ozo::literals;
+
+TEST(multi_host_connection_info, should_return_connection_to_one_of_the_hosts) {
+    ozo::io_context io;
+    const ozo::multi_host_connection_info<> source({OZO_PG_TEST_CONNINFO, OZO_PG_TEST_CONNINFO});
+
+    std::atomic_flag called {};
+    ozo::rows_of<std::int32_t> rows;
+    ozo::request(source[io], "SELECT 1"_SQL, 1s, ozo::into(rows), [&] (ozo::error_code ec, auto conn) {
+        EXPECT_FALSE(called.test_and_set());
+        ASSERT_FALSE(ec) << ec.message() << "|" << ozo::error_message(conn) << "|" << ozo::get_error_context(conn);
+        EXPECT_FALSE(ozo::connection_bad(conn));
+        ASSERT_EQ(rows.size(), 1u);
+        EXPECT_EQ(std::get<0>(rows.front()), 1);
+    });
+
+    io.run();
+    EXPECT_TRUE(called.test_and_set());
+}
+
+TEST(multi_host_connection_info, should_return_connection_when_some_hosts_fail) {
+    ozo::io_context io;
+    const ozo::multi_host_connection_info<> source({"invalid connection info", OZO_PG_TEST_CONNINFO},
+        {10ms, "any"});
+
+    std::atomic_flag called {};
+    ozo::get_connection(source[io], 1s, [&] (ozo::error_code ec, auto conn) {
+        EXPECT_FALSE(called.test_and_set());
+        EXPECT_FALSE(ec) << ec.message() << "|" << ozo::error_message(conn) << "|" << ozo::get_error_context(conn);
+        EXPECT_FALSE(ozo::connection_bad(conn));
+    });
+
+    io.run();
+    EXPECT_TRUE(called.test_and_set());
+}
+
+TEST(multi_host_connection_info, should_return_timeout_error_for_zero_connect_timeout) {
+    ozo::io_context io;
+    const ozo::multi_host_connection_info<> source({OZO_PG_TEST_CONNINFO, OZO_PG_TEST_CONNINFO});
+
+    std::atomic_flag called {};
+    ozo::get_connection(source[io], 0s, [&] (ozo::error_code ec, auto conn) {
+        EXPECT_FALSE(called.test_and_set());
+        EXPECT_EQ(ec, boost::asio::error::timed_out);
+        EXPECT_TRUE(ozo::connection_bad(conn));
+    });
+
+    io.run();
+    EXPECT_TRUE(called.test_and_set());
+}
+
+} // namespace
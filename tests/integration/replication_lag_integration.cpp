@@ -0,0 +1,40 @@
+#include <ozo/connection_info.h>
+#include <ozo/query_builder.h>
+#include <ozo/request.h>
+#include <ozo/shortcuts.h>
+#include <ozo/failover/replication_lag.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+#define ASSERT_REQUEST_OK(ec, conn)\
+    ASSERT_FALSE(ec) << ec.message() \
+        << "|" << ozo::error_message(conn) \
+        << "|" << (!ozo::is_null_recursive(conn) ? ozo::get_error_context(conn) : "") << std::endl
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+TEST(request, should_return_success_for_request_to_lag_aware_source_with_min_lsn) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info<> conn_info(OZO_PG_TEST_CONNINFO);
+    auto source = ozo::failover::lag_aware_connection_source(conn_info, {conn_info});
+    source.start_monitoring(io, 10ms);
+
+    std::vector<int> res;
+    ozo::request(source.min_lsn(1)[io], "SELECT 1"_SQL, 1s, ozo::into(res),
+            [&](ozo::error_code ec, auto conn) {
+        source.stop_monitoring();
+        ASSERT_REQUEST_OK(ec, conn);
+        EXPECT_EQ(res.front(), 1);
+    });
+
+    io.run();
+    EXPECT_FALSE(source.position(0).known);
+}
+
+} // namespace
@@ -1,6 +1,8 @@
 #include <ozo/connection_info.h>
 #include <ozo/connection_pool.h>
+#include <ozo/dynamic_query.h>
 #include <ozo/query_builder.h>
+#include <ozo/query_conf.h>
 #include <ozo/request.h>
 #include <ozo/execute.h>
 #include <ozo/shortcuts.h>
@@ -631,4 +633,87 @@ TEST(request, should_send_and_receive_composite_with_ltree_field) {
     io.run();
 }
 
+using namespace hana::literals;
+
+struct prepared_sum_query {
+    static constexpr auto name = "prepared sum"_s;
+    using parameters_type = std::tuple<std::int32_t, std::int32_t>;
+};
+
+TEST(request, should_execute_prepared_statement_of_query_repository) {
+
+    const auto repository = ozo::make_query_repository(
+        std::string_view("-- name: prepared sum\nSELECT :0 + :1"),
+        hana::tuple<prepared_sum_query>()
+    );
+    ozo::io_context io;
+    const ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO, repository.prepare_statements());
+
+    boost::asio::spawn(io, [&] (boost::asio::yield_context yield) {
+        ozo::rows_of<std::int32_t> result;
+        ozo::error_code ec;
+        auto conn = ozo::request(conn_info[io], repository.make_prepared_query<prepared_sum_query>(40, 2),
+                                 ozo::into(result), yield[ec]);
+        ASSERT_REQUEST_OK(ec, conn);
+        EXPECT_THAT(result, ElementsAre(std::make_tuple(42)));
+    });
+
+    io.run();
+}
+
+TEST(request, should_return_rows_selected_by_dynamic_query) {
+    ozo::io_context io;
+    const ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    ozo::dynamic_query query;
+    query.text("SELECT value FROM unnest(").param(std::vector<std::int32_t>({1, 2, 3, 4}))
+        .text(") AS value WHERE value > ").param(std::int32_t(1))
+        .text(" AND value ").any(std::vector<std::int32_t>({2, 4}))
+        .text(" ORDER BY value");
+
+    boost::asio::spawn(io, [&] (boost::asio::yield_context yield) {
+        ozo::rows_of<std::int32_t> result;
+        ozo::error_code ec;
+        auto conn = ozo::request(conn_info[io], query, ozo::into(result), yield[ec]);
+        ASSERT_REQUEST_OK(ec, conn);
+        EXPECT_THAT(result, ElementsAre(std::make_tuple(2), std::make_tuple(4)));
+    });
+
+    io.run();
+}
+
+TEST(request, should_update_connection_statistics) {
+    namespace asio = boost::asio;
+    using namespace ozo::literals;
+    using namespace std::chrono_literals;
+
+    ozo::io_context io;
+    const ozo::connection_statistics statistics;
+    const ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO, ozo::empty_oid_map{}, statistics);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        ozo::rows_of<std::int32_t> result;
+        ozo::error_code ec;
+        auto conn = ozo::request(conn_info[io], "SELECT "_SQL + std::int32_t(42) + " UNION ALL SELECT 13"_SQL,
+            1s, ozo::into(result), yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(conn) << " | " << ozo::get_error_context(conn);
+
+        const auto& requests = statistics.requests();
+        EXPECT_GE(requests[ozo::request_counter::requests], 1u);
+        EXPECT_GT(requests[ozo::request_counter::bytes_sent], 0u);
+        EXPECT_GE(requests[ozo::request_counter::bytes_received], 8u);
+        EXPECT_GE(requests[ozo::request_counter::rows_decoded], 2u);
+        EXPECT_GE(requests[ozo::request_phase::send].count(), 1u);
+        EXPECT_GE(requests[ozo::request_phase::first_byte].count(), 1u);
+        EXPECT_GE(requests[ozo::request_phase::last_result].count(), 1u);
+        EXPECT_GE(requests[ozo::request_phase::decode].count(), 1u);
+
+        ozo::execute(conn, "SELECT 1 / 0"_SQL, 1s, yield[ec]);
+        EXPECT_EQ(ec, ozo::sqlstate::division_by_zero);
+        EXPECT_EQ(requests[ozo::request_error_category::sql], 1u);
+    });
+
+    io.run();
+}
+
 } // namespace
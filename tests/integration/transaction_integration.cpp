@@ -1,8 +1,11 @@
 #include <ozo/connection_info.h>
+#include <ozo/execute.h>
 #include <ozo/query_builder.h>
 #include <ozo/result.h>
 #include <ozo/request.h>
+#include <ozo/shortcuts.h>
 #include <ozo/transaction.h>
+#include <ozo/transaction_script.h>
 
 #include <boost/asio/spawn.hpp>
 
@@ -196,4 +199,196 @@ TEST(transaction_integration, transaction_deferrability_options_should_not_gener
     io.run();
 }
 
+TEST(transaction_integration, pipelined_transaction_should_begin_with_first_request_and_commit_with_last_one) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        const auto options = ozo::make_options(
+            ozo::transaction_options::isolation_level = ozo::isolation_level::repeatable_read,
+            ozo::transaction_options::pipelined = true
+        );
+        ozo::error_code ec;
+        auto transaction = ozo::begin.with_transaction_options(options)(conn_info[io], yield[ec]);
+        ASSERT_FALSE(ec);
+        EXPECT_TRUE(transaction.has_deferred_statements());
+        EXPECT_EQ(ozo::get_transaction_status(transaction), ozo::transaction_status::idle);
+
+        ozo::rows_of<std::string> level;
+        ozo::request(transaction, "SHOW transaction_isolation"_SQL, ozo::into(level), yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(transaction) << " | " << ozo::get_error_context(transaction);
+        EXPECT_FALSE(transaction.has_deferred_statements());
+        EXPECT_THAT(level, ElementsAre(std::make_tuple("repeatable read")));
+        EXPECT_EQ(ozo::get_transaction_status(transaction), ozo::transaction_status::transaction);
+
+        ozo::rows_of<std::int32_t> result;
+        auto connection = ozo::commit(std::move(transaction), "SELECT 42"_SQL, ozo::into(result), yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(connection) << " | " << ozo::get_error_context(connection);
+        EXPECT_THAT(result, ElementsAre(std::make_tuple(42)));
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::idle);
+    });
+
+    io.run();
+}
+
+TEST(transaction_integration, pipelined_transaction_should_begin_and_commit_in_one_pipeline_with_request) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        const auto options = ozo::make_options(ozo::transaction_options::pipelined = true);
+        ozo::error_code ec;
+        auto transaction = ozo::begin.with_transaction_options(options)(conn_info[io], yield[ec]);
+        ASSERT_FALSE(ec);
+
+        ozo::rows_of<std::int64_t> result;
+        auto connection = ozo::commit(std::move(transaction), "SELECT count(*) FROM pg_stat_activity WHERE pid = pg_backend_pid() AND xact_start IS NOT NULL"_SQL,
+            ozo::into(result), yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(connection) << " | " << ozo::get_error_context(connection);
+        EXPECT_THAT(result, ElementsAre(std::make_tuple(1)));
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::idle);
+    });
+
+    io.run();
+}
+
+TEST(transaction_integration, pipelined_commit_should_not_be_executed_when_last_request_fails) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        const auto options = ozo::make_options(ozo::transaction_options::pipelined = true);
+        ozo::error_code ec;
+        auto transaction = ozo::begin.with_transaction_options(options)(conn_info[io], yield[ec]);
+        ASSERT_FALSE(ec);
+
+        ozo::rows_of<std::int32_t> result;
+        auto connection = ozo::commit(std::move(transaction), "SELECT 1 / 0"_SQL, ozo::into(result), yield[ec]);
+        EXPECT_EQ(ec, ozo::sqlstate::division_by_zero);
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::error);
+    });
+
+    io.run();
+}
+
+TEST(transaction_integration, nested_transaction_rollback_should_keep_outer_transaction_changes) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        ozo::error_code ec;
+        auto transaction = ozo::begin(conn_info[io], yield[ec]);
+        ASSERT_FALSE(ec);
+        ozo::execute(transaction, "CREATE TEMPORARY TABLE nested_transaction_test (value integer CHECK (value > 0))"_SQL, yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(transaction);
+
+        for (const std::int32_t value : {1, -2, 3}) {
+            auto nested = ozo::begin(std::move(transaction), yield[ec]);
+            ASSERT_FALSE(ec);
+            ozo::execute(nested, "INSERT INTO nested_transaction_test VALUES ("_SQL + value + ")"_SQL, yield[ec]);
+            EXPECT_EQ(bool(ec), value < 0) << ec.message() << " | " << ozo::error_message(nested);
+            transaction = ec ? ozo::rollback(std::move(nested), yield[ec]) : ozo::commit(std::move(nested), yield[ec]);
+            ASSERT_FALSE(ec);
+        }
+
+        ozo::rows_of<std::int32_t> result;
+        auto connection = ozo::commit(std::move(transaction), "SELECT value FROM nested_transaction_test ORDER BY value"_SQL,
+            ozo::into(result), yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(connection) << " | " << ozo::get_error_context(connection);
+        EXPECT_THAT(result, ElementsAre(std::make_tuple(1), std::make_tuple(3)));
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::idle);
+    });
+
+    io.run();
+}
+
+TEST(transaction_integration, nested_transaction_commit_with_failed_query_should_roll_back_to_savepoint) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        ozo::error_code ec;
+        auto transaction = ozo::begin(conn_info[io], yield[ec]);
+        ASSERT_FALSE(ec);
+
+        auto nested = ozo::begin(std::move(transaction), yield[ec]);
+        ASSERT_FALSE(ec);
+        ozo::rows_of<std::int32_t> result;
+        transaction = ozo::commit(std::move(nested), "SELECT 1 / 0"_SQL, ozo::into(result), yield[ec]);
+        EXPECT_EQ(ec, ozo::sqlstate::division_by_zero);
+
+        auto connection = ozo::commit(std::move(transaction), "SELECT 1"_SQL, ozo::into(result), yield[ec]);
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(connection) << " | " << ozo::get_error_context(connection);
+        EXPECT_THAT(result, ElementsAre(std::make_tuple(1)));
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::idle);
+    });
+
+    io.run();
+}
+
+TEST(transaction_integration, transaction_script_should_execute_queries_within_transaction_and_return_results) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        const auto options = ozo::make_options(
+            ozo::transaction_options::isolation_level = ozo::isolation_level::serializable,
+            ozo::transaction_options::mode = ozo::transaction_mode::read_only
+        );
+        ozo::rows_of<std::string> isolation_level;
+        ozo::rows_of<std::string> read_only;
+        ozo::rows_of<std::int32_t> value;
+        ozo::error_code ec;
+        auto connection = ozo::transaction_script.with_transaction_options(options)(
+            conn_info[io],
+            std::make_tuple("SHOW transaction_isolation"_SQL, "SHOW transaction_read_only"_SQL, "SELECT 42"_SQL),
+            std::make_tuple(ozo::into(isolation_level), ozo::into(read_only), ozo::into(value)),
+            yield[ec]
+        );
+        ASSERT_FALSE(ec) << ec.message() << " | " << ozo::error_message(connection) << " | " << ozo::get_error_context(connection);
+        EXPECT_THAT(isolation_level, ElementsAre(std::make_tuple("serializable")));
+        EXPECT_THAT(read_only, ElementsAre(std::make_tuple("on")));
+        EXPECT_THAT(value, ElementsAre(std::make_tuple(42)));
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::idle);
+    });
+
+    io.run();
+}
+
+TEST(transaction_integration, transaction_script_should_rollback_transaction_on_failed_query) {
+    using namespace ozo::literals;
+
+    ozo::io_context io;
+    ozo::connection_info conn_info(OZO_PG_TEST_CONNINFO);
+
+    asio::spawn(io, [&] (asio::yield_context yield) {
+        ozo::rows_of<std::int32_t> value;
+        ozo::error_code ec;
+        auto connection = ozo::transaction_script(
+            conn_info[io],
+            std::make_tuple("SELECT 1"_SQL, "SELECT 1 / 0"_SQL, "SELECT 2"_SQL),
+            std::chrono::seconds(1),
+            std::make_tuple(ozo::into(value), ozo::none, ozo::into(value)),
+            yield[ec]
+        );
+        EXPECT_EQ(ec, ozo::sqlstate::division_by_zero);
+        EXPECT_EQ(ozo::get_error_context(connection), "error in pipeline statement: SELECT 1 / 0");
+        EXPECT_EQ(ozo::get_transaction_status(connection), ozo::transaction_status::idle);
+    });
+
+    io.run();
+}
+
 } // namespace
@@ -0,0 +1,68 @@
+#include <ozo/multi_host_connection_info.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(add_target_session_attrs, should_return_connection_string_as_is_for_empty_attrs) {
+    EXPECT_EQ(ozo::detail::add_target_session_attrs("host=localhost", ""), "host=localhost");
+}
+
+TEST(add_target_session_attrs, should_append_parameter_to_keyword_value_connection_string) {
+    EXPECT_EQ(ozo::detail::add_target_session_attrs("host=localhost", "read-write"),
+        "host=localhost target_session_attrs=read-write");
+}
+
+TEST(add_target_session_attrs, should_append_query_parameter_to_uri) {
+    EXPECT_EQ(ozo::detail::add_target_session_attrs("postgresql://localhost/db", "read-write"),
+        "postgresql://localhost/db?target_session_attrs=read-write");
+    EXPECT_EQ(ozo::detail::add_target_session_attrs("postgres://localhost/db?sslmode=disable", "any"),
+        "postgres://localhost/db?sslmode=disable&target_session_attrs=any");
+}
+
+TEST(multi_host_connection_info, should_throw_for_empty_connection_strings) {
+    EXPECT_THROW(ozo::multi_host_connection_info<>({}), std::invalid_argument);
+}
+
+TEST(multi_host_connection_info, should_apply_target_session_attrs_to_each_host) {
+    ozo::multi_host_connection_info<> source({"host=a", "host=b"}, {0ms, "read-write"});
+    ASSERT_EQ(source.size(), 2u);
+    EXPECT_EQ(source.conn_str(0), "host=a target_session_attrs=read-write");
+    EXPECT_EQ(source.conn_str(1), "host=b target_session_attrs=read-write");
+}
+
+TEST(multi_host_connection_info, should_return_error_and_bad_connect_when_all_hosts_fail) {
+    ozo::io_context io;
+    ozo::multi_host_connection_info<> source({"invalid connection info", "invalid connection info"});
+
+    int calls = 0;
+    ozo::get_connection(source[io], [&](ozo::error_code ec, auto conn){
+        ++calls;
+        EXPECT_TRUE(ec);
+        EXPECT_TRUE(!ozo::error_message(conn).empty());
+        EXPECT_TRUE(ozo::connection_bad(conn));
+    });
+
+    io.run();
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(multi_host_connection_info, should_try_next_host_without_stagger_delay_after_failure) {
+    ozo::io_context io;
+    ozo::multi_host_connection_info<> source({"invalid connection info", "invalid connection info"}, {1h, ""});
+
+    int calls = 0;
+    ozo::get_connection(source[io], 1h, [&](ozo::error_code ec, auto conn){
+        ++calls;
+        EXPECT_TRUE(ec);
+        EXPECT_TRUE(ozo::connection_bad(conn));
+    });
+
+    io.run();
+    EXPECT_EQ(calls, 1);
+}
+
+} // namespace
@@ -0,0 +1,122 @@
+#include <ozo/oid_map_cache.h>
+
+#include "connection_mock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace ozo::tests {
+
+struct cached_oid_type_a {};
+struct cached_oid_type_b {};
+
+} // namespace ozo::tests
+
+OZO_PG_DEFINE_CUSTOM_TYPE(ozo::tests::cached_oid_type_a, "cached_oid_type_a")
+OZO_PG_DEFINE_CUSTOM_TYPE(ozo::tests::cached_oid_type_b, "cached_oid_type_b")
+
+namespace {
+
+using namespace testing;
+using namespace ozo::tests;
+
+struct oid_map_cache : Test {
+    ozo::oid_map_cache cache;
+
+    oid_map_cache() { cache.enabled(true); }
+};
+
+TEST_F(oid_map_cache, get_should_return_false_for_unknown_server) {
+    auto oid_map = ozo::register_types<cached_oid_type_a>();
+    EXPECT_FALSE(cache.get("server", oid_map));
+}
+
+TEST_F(oid_map_cache, get_should_fill_oid_map_with_stored_oids) {
+    auto stored = ozo::register_types<cached_oid_type_a, cached_oid_type_b>();
+    ozo::set_type_oid<cached_oid_type_a>(stored, 100);
+    ozo::set_type_oid<cached_oid_type_b>(stored, 200);
+    cache.put("server", stored);
+
+    auto oid_map = ozo::register_types<cached_oid_type_b>();
+    EXPECT_TRUE(cache.get("server", oid_map));
+    EXPECT_EQ(ozo::type_oid<cached_oid_type_b>(oid_map), 200u);
+}
+
+TEST_F(oid_map_cache, get_should_return_false_and_leave_oid_map_untouched_if_some_type_is_missing) {
+    auto stored = ozo::register_types<cached_oid_type_a>();
+    ozo::set_type_oid<cached_oid_type_a>(stored, 100);
+    cache.put("server", stored);
+
+    auto oid_map = ozo::register_types<cached_oid_type_a, cached_oid_type_b>();
+    EXPECT_FALSE(cache.get("server", oid_map));
+    EXPECT_EQ(ozo::type_oid<cached_oid_type_a>(oid_map), ozo::null_oid);
+}
+
+TEST_F(oid_map_cache, get_should_not_mix_servers) {
+    auto stored = ozo::register_types<cached_oid_type_a>();
+    ozo::set_type_oid<cached_oid_type_a>(stored, 100);
+    cache.put("server", stored);
+
+    auto oid_map = ozo::register_types<cached_oid_type_a>();
+    EXPECT_FALSE(cache.get("other server", oid_map));
+}
+
+TEST_F(oid_map_cache, invalidate_should_remove_server_oids) {
+    auto stored = ozo::register_types<cached_oid_type_a>();
+    ozo::set_type_oid<cached_oid_type_a>(stored, 100);
+    cache.put("server", stored);
+    cache.put("other server", stored);
+    cache.invalidate("server");
+
+    EXPECT_EQ(cache.size(), 1u);
+    auto oid_map = ozo::register_types<cached_oid_type_a>();
+    EXPECT_FALSE(cache.get("server", oid_map));
+    EXPECT_TRUE(cache.get("other server", oid_map));
+}
+
+TEST_F(oid_map_cache, invalidate_should_remove_server_oids_for_all_session_statements) {
+    auto stored = ozo::register_types<cached_oid_type_a>();
+    ozo::set_type_oid<cached_oid_type_a>(stored, 100);
+    cache.put("server", stored);
+    cache.put("server~42", stored);
+    cache.put("server:2~42", stored);
+    cache.invalidate("server");
+
+    EXPECT_EQ(cache.size(), 1u);
+    auto oid_map = ozo::register_types<cached_oid_type_a>();
+    EXPECT_FALSE(cache.get("server~42", oid_map));
+    EXPECT_TRUE(cache.get("server:2~42", oid_map));
+}
+
+TEST_F(oid_map_cache, should_ignore_empty_key) {
+    auto stored = ozo::register_types<cached_oid_type_a>();
+    cache.put("", stored);
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_FALSE(cache.get("", stored));
+}
+
+TEST_F(oid_map_cache, should_not_be_used_when_disabled) {
+    auto stored = ozo::register_types<cached_oid_type_a>();
+    ozo::set_type_oid<cached_oid_type_a>(stored, 100);
+    cache.put("server", stored);
+    cache.enabled(false);
+
+    auto oid_map = ozo::register_types<cached_oid_type_a>();
+    EXPECT_FALSE(cache.get("server", oid_map));
+    cache.put("other server", stored);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(oid_map_cache_instance, should_be_disabled_by_default) {
+    EXPECT_FALSE(ozo::oid_map_cache::instance().enabled());
+}
+
+TEST(oid_map_cache_key, should_return_empty_key_for_non_libpq_connection) {
+    connection_mock mock;
+    io_context io;
+    PGconn_mock handle;
+    auto conn = make_connection(mock, io, handle);
+    EXPECT_TRUE(ozo::oid_map_cache_key(conn).empty());
+}
+
+} // namespace
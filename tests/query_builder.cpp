@@ -1,4 +1,5 @@
 #include <ozo/query_builder.h>
+#include <ozo/pg/types.h>
 
 #include <boost/hana/size.hpp>
 
@@ -136,6 +137,20 @@ TEST(query_builder_build, with_text_and_custom_type_param_element_returns_query_
     EXPECT_EQ(decltype(hana::size(params))::value, 1u);
 }
 
+TEST(query_builder_static_text, should_be_equal_to_text) {
+    using namespace ozo::literals;
+    using builder_type = decltype("SELECT "_SQL + std::int32_t(42) + " + "_SQL + std::int64_t(13));
+    static_assert(std::string_view(builder_type::static_text()) == "SELECT $1 + $2");
+    EXPECT_STREQ(builder_type::static_text(), "SELECT $1 + $2");
+}
+
+TEST(query_builder_static_types, should_be_equal_to_built_in_params_type_oids) {
+    using namespace ozo::literals;
+    using builder_type = decltype("SELECT "_SQL + std::int32_t(42) + " + "_SQL + std::int64_t(13));
+    static_assert(builder_type::static_types()[0] == ozo::type_oid<std::int32_t>(ozo::empty_oid_map_c));
+    EXPECT_EQ(builder_type::static_types()[1], ozo::type_oid<std::int64_t>(ozo::empty_oid_map_c));
+}
+
 using namespace ozo::literals;
 using namespace hana::literals;
 
@@ -1,4 +1,5 @@
 #include <ozo/query_conf.h>
+#include <ozo/io/binary_query.h>
 
 #include <boost/hana/adapt_struct.hpp>
 #include <boost/hana/contains.hpp>
@@ -676,6 +677,37 @@ TEST(query_repository_make_query, should_return_query_for_query_conf_with_two_qu
     );
 }
 
+TEST(query_repository_make_query, should_return_query_for_any_declaration_order) {
+    const auto repository = ozo::make_query_repository(
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer\n"
+        "-- name: query without parameters\n"
+        "SELECT 1",
+        hana::tuple<query_without_parameters, query_with_one_parameter>()
+    );
+    EXPECT_EQ(
+        repository.make_query<query_with_one_parameter>(42),
+        ozo::make_query("SELECT $1::integer", 42)
+    );
+    EXPECT_EQ(
+        repository.make_query<query_without_parameters>(),
+        ozo::make_query("SELECT 1")
+    );
+}
+
+TEST(query_repository_make_query, should_throw_for_query_not_defined_in_query_conf) {
+    auto descriptions = std::vector<ozo::detail::query_description>{{"query without parameters", "SELECT 1"}};
+    const ozo::query_repository<query_without_parameters, query_with_one_parameter> repository(
+        ozo::detail::make_query_conf(std::move(descriptions)));
+    EXPECT_EQ(repository.make_query<query_without_parameters>(), ozo::make_query("SELECT 1"));
+    EXPECT_THROW(repository.make_query<query_with_one_parameter>(42), std::out_of_range);
+}
+
+TEST(query_index, should_return_position_of_query_in_declaration) {
+    EXPECT_EQ((ozo::detail::query_index_v<query_with_one_parameter, query_without_parameters, query_with_one_parameter>), 1u);
+    EXPECT_EQ((ozo::detail::query_index_v<query_with_one_parameter, query_without_parameters>), 1u);
+}
+
 TEST(query_repository_make_query, should_return_query_for_query_conf_with_single_query_with_struct_parameters) {
     const auto repository = ozo::make_query_repository(
         "-- name: query with struct parameters\n"
@@ -766,4 +798,72 @@ TEST(query_repository_make_query, should_copy_struct_parameters_passed_by_const_
     repository.make_query<require_copy_struct_query>(parameters);
 }
 
+TEST(query_repository_prepared_statements, statement_name_should_be_made_of_query_name_and_hash) {
+    const auto repository = ozo::make_query_repository(
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer",
+        hana::tuple<query_with_one_parameter>()
+    );
+    const auto name = repository.statement_name<query_with_one_parameter>();
+    EXPECT_THAT(std::string(name), MatchesRegex("ozo_query_with_one_parameter_[0-9a-f]{16}"));
+}
+
+TEST(query_repository_prepared_statements, statement_name_should_be_stable_for_same_query_definition) {
+    const std::string_view conf = "-- name: query with one parameter\n"
+        "SELECT :0::integer";
+    const auto first = ozo::make_query_repository(conf, hana::tuple<query_with_one_parameter>());
+    const auto second = ozo::make_query_repository(conf, hana::tuple<query_with_one_parameter>());
+    EXPECT_EQ(first.statement_name<query_with_one_parameter>(), second.statement_name<query_with_one_parameter>());
+}
+
+TEST(query_repository_prepared_statements, statement_name_should_differ_for_different_query_text) {
+    const auto first = ozo::make_query_repository(
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer",
+        hana::tuple<query_with_one_parameter>()
+    );
+    const auto second = ozo::make_query_repository(
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer + 1",
+        hana::tuple<query_with_one_parameter>()
+    );
+    EXPECT_NE(first.statement_name<query_with_one_parameter>(), second.statement_name<query_with_one_parameter>());
+}
+
+TEST(query_repository_prepared_statements, prepare_statements_should_declare_parameter_types) {
+    const auto repository = ozo::make_query_repository(
+        "-- name: query without parameters\n"
+        "SELECT 1\n"
+        "-- name: query with struct parameters\n"
+        "SELECT :string::text || :number::text",
+        hana::tuple<query_without_parameters, query_with_struct_parameters>()
+    );
+    EXPECT_THAT(
+        repository.prepare_statements(),
+        ElementsAre(
+            "PREPARE " + std::string(repository.statement_name<query_without_parameters>()) + " AS SELECT 1",
+            "PREPARE " + std::string(repository.statement_name<query_with_struct_parameters>())
+                + " (text, int4) AS SELECT $1::text || $2::text"
+        )
+    );
+}
+
+TEST(query_repository_prepared_statements, make_prepared_query_should_return_query_with_statement_name_text) {
+    const auto repository = ozo::make_query_repository(
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer",
+        hana::tuple<query_with_one_parameter>()
+    );
+    const auto query = repository.make_prepared_query<query_with_one_parameter>(42);
+    EXPECT_EQ(ozo::get_query_text(query).name, repository.statement_name<query_with_one_parameter>());
+    EXPECT_EQ(ozo::get_query_params(query), hana::make_tuple(42));
+    EXPECT_TRUE(ozo::to_binary_query(query, ozo::empty_oid_map_c).is_prepared());
+    EXPECT_FALSE(ozo::to_binary_query(repository.make_query<query_with_one_parameter>(42), ozo::empty_oid_map_c).is_prepared());
+}
+
+TEST(query_repository_prepared_statements, make_prepared_query_should_throw_for_not_defined_query) {
+    const ozo::query_repository<query_with_one_parameter> empty;
+    EXPECT_THROW(empty.make_prepared_query<query_with_one_parameter>(42), std::out_of_range);
+}
+
 } // namespace
@@ -0,0 +1,149 @@
+#include <ozo/reloadable_query_repository.h>
+
+#include <boost/hana/string.hpp>
+#include <boost/hana/tuple.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <optional>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+namespace hana = boost::hana;
+
+using namespace boost::hana::literals;
+using namespace testing;
+
+struct query_without_parameters {
+    static constexpr auto name = "query without parameters"_s;
+    using parameters_type = std::tuple<>;
+};
+
+struct query_with_one_parameter {
+    static constexpr auto name = "query with one parameter"_s;
+    using parameters_type = std::tuple<std::int32_t>;
+};
+
+using repository_type = ozo::reloadable_query_repository<query_without_parameters, query_with_one_parameter>;
+
+template <class Query>
+std::string_view text(const Query& query) {
+    return ozo::to_const_char(ozo::get_query_text(query));
+}
+
+struct reloadable_query_repository : Test {
+    std::string path = TempDir() + "ozo_reloadable_query_repository_test.sql";
+
+    void write(const std::string& content) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+    }
+
+    reloadable_query_repository() {
+        write(
+            "-- name: query without parameters\n"
+            "SELECT 1\n"
+            "-- name: query with one parameter\n"
+            "SELECT :0::integer\n"
+        );
+    }
+
+    ~reloadable_query_repository() {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(reloadable_query_repository, should_load_query_conf_on_construction) {
+    const repository_type repository(path);
+    EXPECT_EQ(repository.generation(), 1u);
+    EXPECT_EQ(text(repository.make_query<query_without_parameters>()), "SELECT 1");
+    EXPECT_EQ(text(repository.make_query<query_with_one_parameter>(42)), "SELECT $1::integer");
+}
+
+TEST_F(reloadable_query_repository, should_throw_on_construction_for_missing_file) {
+    EXPECT_THROW(repository_type(path + ".missing"), std::runtime_error);
+}
+
+TEST_F(reloadable_query_repository, reload_should_publish_new_snapshot_for_changed_file) {
+    repository_type repository(path);
+    const auto query = repository.make_query<query_without_parameters>();
+    write(
+        "-- name: query without parameters\n"
+        "SELECT /*+ IndexScan(t) */ 1\n"
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer\n"
+    );
+    EXPECT_TRUE(repository.reload());
+    EXPECT_EQ(repository.generation(), 2u);
+    EXPECT_EQ(text(repository.make_query<query_without_parameters>()), "SELECT /*+ IndexScan(t) */ 1");
+    EXPECT_EQ(text(query), "SELECT 1");
+}
+
+TEST_F(reloadable_query_repository, reload_should_not_publish_snapshot_for_unchanged_file) {
+    repository_type repository(path);
+    const auto snapshot = repository.snapshot();
+    EXPECT_FALSE(repository.reload());
+    EXPECT_EQ(repository.generation(), 1u);
+    EXPECT_EQ(repository.snapshot(), snapshot);
+}
+
+TEST_F(reloadable_query_repository, reload_should_release_previous_snapshot_when_queries_made_from_it_are_destroyed) {
+    repository_type repository(path);
+    const std::weak_ptr<const repository_type::repository_type> snapshot = repository.snapshot();
+    auto query = std::make_optional(repository.make_query<query_with_one_parameter>(42));
+    write(
+        "-- name: query without parameters\n"
+        "SELECT 2\n"
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer + 1\n"
+    );
+    EXPECT_TRUE(repository.reload());
+    EXPECT_EQ(text(repository.make_query<query_with_one_parameter>(42)), "SELECT $1::integer + 1");
+    EXPECT_FALSE(snapshot.expired());
+    EXPECT_EQ(text(*query), "SELECT $1::integer");
+    query.reset();
+    EXPECT_TRUE(snapshot.expired());
+}
+
+TEST_F(reloadable_query_repository, should_make_queries_from_own_snapshot_for_repositories_of_same_type) {
+    repository_type repository(path);
+    write(
+        "-- name: query without parameters\n"
+        "SELECT 2\n"
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer\n"
+    );
+    repository_type other(path);
+    EXPECT_EQ(text(repository.make_query<query_without_parameters>()), "SELECT 1");
+    EXPECT_EQ(text(other.make_query<query_without_parameters>()), "SELECT 2");
+    EXPECT_EQ(text(repository.make_query<query_without_parameters>()), "SELECT 1");
+}
+
+TEST_F(reloadable_query_repository, reload_should_throw_and_keep_snapshot_for_invalid_query_conf) {
+    repository_type repository(path);
+    write(
+        "-- name: query without parameters\n"
+        "SELECT 2\n"
+    );
+    EXPECT_THROW(repository.reload(), std::invalid_argument);
+    EXPECT_EQ(repository.generation(), 1u);
+    EXPECT_EQ(text(repository.make_query<query_without_parameters>()), "SELECT 1");
+}
+
+TEST_F(reloadable_query_repository, reload_should_throw_and_keep_snapshot_for_duplicate_query) {
+    repository_type repository(path);
+    write(
+        "-- name: query without parameters\n"
+        "SELECT 2\n"
+        "-- name: query without parameters\n"
+        "SELECT 3\n"
+        "-- name: query with one parameter\n"
+        "SELECT :0::integer\n"
+    );
+    EXPECT_THROW(repository.reload(), std::invalid_argument);
+    EXPECT_EQ(text(repository.make_query<query_without_parameters>()), "SELECT 1");
+}
+
+} // namespace
@@ -0,0 +1,122 @@
+#include <ozo/static_query_conf.h>
+#include <ozo/query_builder.h>
+
+#include <boost/hana/adapt_struct.hpp>
+#include <boost/hana/string.hpp>
+#include <boost/hana/tuple.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+namespace hana = boost::hana;
+
+using namespace boost::hana::literals;
+using namespace testing;
+
+struct query_without_parameters {
+    static constexpr auto name = "query without parameters"_s;
+    using parameters_type = std::tuple<>;
+};
+
+struct query_with_one_parameter {
+    static constexpr auto name = "query with one parameter"_s;
+    using parameters_type = std::tuple<std::int32_t>;
+};
+
+struct struct_parameters {
+    std::string_view string;
+    int number;
+};
+
+} // namespace
+
+BOOST_HANA_ADAPT_STRUCT(struct_parameters, string, number);
+
+namespace {
+
+struct query_with_struct_parameters {
+    static constexpr auto name = "query with struct parameters"_s;
+    using parameters_type = struct_parameters;
+};
+
+constexpr auto conf =
+    "-- name: query without parameters\n"
+    "SELECT 1\n"
+    "-- some comment\n"
+    "-- name: query with one parameter\r\n"
+    "SELECT :0::integer\r\n"
+    "  WHERE true\n"
+    "-- name: query with struct parameters\n"
+    "\n"
+    "SELECT :string::text || :number::text\n"_s;
+
+template <class Lhs, class Rhs>
+constexpr bool same_string(Lhs lhs, Rhs rhs) {
+    return std::is_same_v<Lhs, Rhs> && std::string_view(hana::to<const char*>(lhs)) == hana::to<const char*>(rhs);
+}
+
+static_assert(same_string(ozo::make_static_query_text<query_without_parameters>(conf), "SELECT 1"_s));
+static_assert(same_string(ozo::make_static_query_text<query_with_one_parameter>(conf), "SELECT $1::integer\r\n  WHERE true"_s));
+static_assert(same_string(ozo::make_static_query_text<query_with_struct_parameters>(conf), "SELECT $1::text || $2::text"_s));
+
+constexpr std::array<std::string_view, 2> declared {"query without parameters", "query with one parameter"};
+
+TEST(static_query_conf_check, should_accept_conf_with_all_declared_queries_defined) {
+    EXPECT_NO_THROW(ozo::detail::static_query_conf::check(
+        "-- name: query without parameters\nSELECT 1\n-- name: query with one parameter\nSELECT :0\n", declared));
+}
+
+TEST(static_query_conf_check, should_throw_for_declared_but_not_defined_query) {
+    EXPECT_THROW(ozo::detail::static_query_conf::check(
+        "-- name: query without parameters\nSELECT 1\n", declared), std::invalid_argument);
+}
+
+TEST(static_query_conf_check, should_throw_for_defined_but_not_declared_query) {
+    EXPECT_THROW(ozo::detail::static_query_conf::check(
+        "-- name: query without parameters\nSELECT 1\n-- name: query with one parameter\nSELECT :0\n"
+        "-- name: other query\nSELECT 2\n", declared), std::invalid_argument);
+}
+
+TEST(make_static_query_text, should_be_same_as_query_builder_text) {
+    using namespace ozo::literals;
+    const auto built = ("SELECT "_SQL + std::string_view("42") + "::text || "_SQL + 13 + "::text"_SQL).build();
+    EXPECT_TRUE(same_string(ozo::make_static_query_text<query_with_struct_parameters>(conf), ozo::get_query_text(built)));
+}
+
+TEST(make_static_query_text, should_be_same_as_query_repository_text) {
+    const auto repository = ozo::make_query_repository(std::string_view(hana::to<const char*>(conf)),
+        hana::tuple<query_without_parameters, query_with_one_parameter, query_with_struct_parameters>());
+    EXPECT_EQ(hana::to<const char*>(ozo::make_static_query_text<query_without_parameters>(conf)),
+        ozo::get_query_text(repository.make_query<query_without_parameters>()));
+    EXPECT_EQ(hana::to<const char*>(ozo::make_static_query_text<query_with_one_parameter>(conf)),
+        ozo::get_query_text(repository.make_query<query_with_one_parameter>(42)));
+    EXPECT_EQ(hana::to<const char*>(ozo::make_static_query_text<query_with_struct_parameters>(conf)),
+        ozo::get_query_text(repository.make_query<query_with_struct_parameters>(struct_parameters {"42", 13})));
+}
+
+TEST(static_query_repository, make_query_should_return_query_with_static_text_and_parameters) {
+    constexpr auto repository = ozo::make_static_query_repository(conf,
+        hana::tuple<query_without_parameters, query_with_one_parameter, query_with_struct_parameters>());
+    const auto query = repository.make_query<query_with_one_parameter>(42);
+    EXPECT_TRUE(same_string(ozo::get_query_text(query), "SELECT $1::integer\r\n  WHERE true"_s));
+    EXPECT_EQ(ozo::get_query_params(query), hana::make_tuple(42));
+}
+
+TEST(static_query_repository, make_query_should_unpack_struct_parameters) {
+    constexpr auto repository = ozo::make_static_query_repository(conf,
+        hana::tuple<query_without_parameters, query_with_one_parameter, query_with_struct_parameters>());
+    const auto query = repository.make_query<query_with_struct_parameters>(struct_parameters {"42", 13});
+    EXPECT_TRUE(same_string(ozo::get_query_text(query), "SELECT $1::text || $2::text"_s));
+    EXPECT_EQ(ozo::get_query_params(query), hana::make_tuple(std::string_view("42"), 13));
+}
+
+TEST(static_query_repository, make_query_should_accept_parameters_tuple) {
+    constexpr auto repository = ozo::make_static_query_repository(conf,
+        hana::tuple<query_without_parameters, query_with_one_parameter, query_with_struct_parameters>());
+    const auto query = repository.make_query<query_with_one_parameter>(std::make_tuple(std::int32_t(42)));
+    EXPECT_EQ(ozo::get_query_params(query), hana::make_tuple(42));
+}
+
+} // namespace
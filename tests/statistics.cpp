@@ -0,0 +1,195 @@
+#include <ozo/statistics.h>
+#include <ozo/impl/async_connect.h>
+#include <ozo/impl/async_request.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+TEST(latency_histogram, should_count_values_in_exponential_buckets) {
+    ozo::latency_histogram histogram;
+    histogram.add(0us);
+    histogram.add(1us);
+    histogram.add(3us);
+    histogram.add(1000us);
+    EXPECT_EQ(histogram.count(), 4u);
+    EXPECT_EQ(histogram.sum(), 1004us);
+    EXPECT_EQ(histogram.bucket(0), 1u);
+    EXPECT_EQ(histogram.bucket(1), 1u);
+    EXPECT_EQ(histogram.bucket(2), 1u);
+    EXPECT_EQ(histogram.bucket(10), 1u);
+    EXPECT_EQ(ozo::latency_histogram::upper_bound(10), 1024us);
+}
+
+TEST(latency_histogram, should_count_huge_values_in_the_last_bucket) {
+    ozo::latency_histogram histogram;
+    histogram.add(24h * 365);
+    EXPECT_EQ(histogram.bucket(ozo::latency_histogram::buckets_count - 1), 1u);
+}
+
+TEST(connect_statistics, copies_should_share_histograms) {
+    const ozo::connect_statistics statistics;
+    const auto copy = statistics;
+    copy.on_connect_phase(ozo::connect_phase::tls, 10ms);
+    EXPECT_EQ(statistics.histograms()[ozo::connect_phase::tls].count(), 1u);
+    EXPECT_EQ(statistics.histograms()[ozo::connect_phase::connect].count(), 0u);
+}
+
+TEST(to_string, should_return_connect_phase_name) {
+    EXPECT_EQ(ozo::to_string(ozo::connect_phase::authentication), "authentication");
+}
+
+TEST(get_connect_phase, should_map_connection_status_to_phase) {
+    using ozo::connect_phase;
+    using ozo::impl::get_connect_phase;
+    EXPECT_EQ(get_connect_phase(CONNECTION_STARTED, connect_phase::resolve), connect_phase::connect);
+    EXPECT_EQ(get_connect_phase(CONNECTION_MADE, connect_phase::connect), connect_phase::connect);
+    EXPECT_EQ(get_connect_phase(CONNECTION_SSL_STARTUP, connect_phase::connect), connect_phase::tls);
+    EXPECT_EQ(get_connect_phase(CONNECTION_AWAITING_RESPONSE, connect_phase::tls), connect_phase::authentication);
+    EXPECT_EQ(get_connect_phase(CONNECTION_AUTH_OK, connect_phase::authentication), connect_phase::startup);
+    EXPECT_EQ(get_connect_phase(CONNECTION_OK, connect_phase::startup), connect_phase::startup);
+}
+
+TEST(connection_statistics, copies_should_share_request_metrics) {
+    const ozo::connection_statistics statistics;
+    const auto copy = statistics;
+    copy.update(ozo::request_counter::bytes_sent, 42);
+    copy.update(ozo::request_error_category::sql, 1);
+    copy.update(ozo::request_phase::first_byte, 10ms);
+    EXPECT_EQ(statistics.requests()[ozo::request_counter::bytes_sent], 42u);
+    EXPECT_EQ(statistics.requests()[ozo::request_counter::bytes_received], 0u);
+    EXPECT_EQ(statistics.requests()[ozo::request_error_category::sql], 1u);
+    EXPECT_EQ(statistics.requests()[ozo::request_error_category::timeout], 0u);
+    EXPECT_EQ(statistics.requests()[ozo::request_phase::first_byte].count(), 1u);
+    EXPECT_EQ(statistics.requests()[ozo::request_phase::decode].count(), 0u);
+}
+
+TEST(connection_statistics, should_collect_connect_phases) {
+    const ozo::connection_statistics statistics;
+    statistics.on_connect_phase(ozo::connect_phase::tls, 10ms);
+    EXPECT_EQ(statistics.histograms()[ozo::connect_phase::tls].count(), 1u);
+}
+
+TEST(update_statistics, should_ignore_keys_which_are_not_supported_by_statistics) {
+    ozo::connect_statistics statistics;
+    ozo::update_statistics(statistics, ozo::request_counter::requests, 1);
+    ozo::no_statistics none;
+    ozo::update_statistics(none, ozo::request_phase::send, ozo::time_traits::duration(1ms));
+    EXPECT_FALSE((ozo::detail::has_statistics_update<ozo::connect_statistics, ozo::request_counter, int>::value));
+    EXPECT_TRUE((ozo::detail::has_statistics_update<ozo::connection_statistics, ozo::request_counter, int>::value));
+}
+
+TEST(connection, update_statistics_should_update_connection_statistics) {
+    ozo::io_context io;
+    const ozo::connection_statistics statistics;
+    ozo::connection<ozo::empty_oid_map, ozo::connection_statistics> conn(io, statistics);
+    conn.update_statistics(ozo::request_counter::rows_decoded, 3);
+    EXPECT_EQ(statistics.requests()[ozo::request_counter::rows_decoded], 3u);
+}
+
+TEST(to_string, should_return_request_statistics_key_names) {
+    EXPECT_EQ(ozo::to_string(ozo::request_counter::rows_decoded), "rows_decoded");
+    EXPECT_EQ(ozo::to_string(ozo::request_error_category::timeout), "timeout");
+    EXPECT_EQ(ozo::to_string(ozo::request_phase::last_result), "last_result");
+}
+
+TEST(get_request_error_category, should_map_error_code_to_category) {
+    using ozo::request_error_category;
+    using ozo::impl::get_request_error_category;
+    EXPECT_EQ(get_request_error_category(boost::asio::error::operation_aborted), request_error_category::timeout);
+    EXPECT_EQ(get_request_error_category(boost::asio::error::connection_reset), request_error_category::connection);
+    EXPECT_EQ(get_request_error_category(ozo::error::pg_flush_failed), request_error_category::connection);
+    EXPECT_EQ(get_request_error_category(ozo::sqlstate::make_error_code(ozo::sqlstate::division_by_zero)),
+        request_error_category::sql);
+    EXPECT_EQ(get_request_error_category(ozo::error::bad_result_process), request_error_category::result);
+    EXPECT_EQ(get_request_error_category(ozo::error::oid_type_mismatch), request_error_category::result);
+    EXPECT_EQ(get_request_error_category(ozo::error::result_status_empty_query), request_error_category::result);
+    EXPECT_EQ(get_request_error_category(boost::system::errc::make_error_code(boost::system::errc::invalid_argument)),
+        request_error_category::other);
+}
+
+TEST(get_query_size, should_return_size_of_query_text_and_parameters) {
+    using namespace ozo::literals;
+    const auto query = ozo::to_binary_query(("SELECT "_SQL + std::int32_t(42) + ", "_SQL + std::string("text")).build(),
+        ozo::empty_oid_map{});
+    EXPECT_EQ(ozo::impl::get_query_size(query), std::strlen("SELECT $1, $2") + 4 + 4);
+}
+
+struct connection_with_statistics {
+    ozo::connect_statistics statistics_;
+    ozo::connect_statistics& statistics() { return statistics_; }
+};
+
+struct connection_with_request_statistics {
+    ozo::connection_statistics statistics_;
+    ozo::connection_statistics& statistics() { return statistics_; }
+};
+
+struct connection_without_statistics {};
+
+} // namespace
+
+namespace ozo {
+
+template <>
+struct is_connection<connection_with_statistics> : std::true_type {};
+
+template <>
+struct is_connection<connection_without_statistics> : std::true_type {};
+
+template <>
+struct is_connection<connection_with_request_statistics> : std::true_type {};
+
+} // namespace ozo
+
+namespace {
+
+TEST(has_connect_phase_hook, should_detect_statistics_with_hook) {
+    EXPECT_TRUE(ozo::impl::has_connect_phase_hook<connection_with_statistics>::value);
+    EXPECT_FALSE(ozo::impl::has_connect_phase_hook<connection_without_statistics>::value);
+    EXPECT_FALSE((ozo::impl::has_connect_phase_hook<std::shared_ptr<ozo::connection<ozo::empty_oid_map, ozo::no_statistics>>>::value));
+    EXPECT_TRUE((ozo::impl::has_connect_phase_hook<std::shared_ptr<ozo::connection<ozo::empty_oid_map, ozo::connect_statistics>>>::value));
+}
+
+TEST(connect_phase_handler, should_report_bootstrap_phase_and_call_handler) {
+    connection_with_statistics conn;
+    StrictMock<MockFunction<void(ozo::error_code)>> callback;
+    auto handler = ozo::impl::apply_bootstrap_phase_timing<connection_with_statistics>(
+        [&] (ozo::error_code ec, auto&&) { callback.Call(ec); });
+
+    EXPECT_CALL(callback, Call(ozo::error_code{}));
+    handler(ozo::error_code{}, conn);
+    EXPECT_EQ(conn.statistics_.histograms()[ozo::connect_phase::bootstrap].count(), 1u);
+}
+
+TEST(has_request_statistics, should_detect_statistics_which_accept_request_keys) {
+    using ozo::impl::has_request_statistics;
+    EXPECT_TRUE((has_request_statistics<connection_with_request_statistics, ozo::request_phase, ozo::time_traits::duration>::value));
+    EXPECT_FALSE((has_request_statistics<connection_with_statistics, ozo::request_phase, ozo::time_traits::duration>::value));
+    EXPECT_FALSE((has_request_statistics<connection_without_statistics, ozo::request_phase, ozo::time_traits::duration>::value));
+    EXPECT_FALSE((has_request_statistics<std::shared_ptr<ozo::connection<ozo::empty_oid_map, ozo::no_statistics>>,
+        ozo::request_counter, std::uint64_t>::value));
+    EXPECT_TRUE((has_request_statistics<std::shared_ptr<ozo::connection<ozo::empty_oid_map, ozo::connection_statistics>>,
+        ozo::request_counter, std::uint64_t>::value));
+}
+
+TEST(start_request_statistics, should_count_request_and_measure_phases_since_request_start) {
+    connection_with_request_statistics conn;
+    const auto& requests = conn.statistics_.requests();
+    auto ctx = ozo::impl::make_request_operation_context(connection_with_request_statistics(conn),
+        [] (ozo::error_code, auto&&) {});
+
+    ozo::impl::start_request_statistics(ctx);
+    EXPECT_EQ(requests[ozo::request_counter::requests], 1u);
+    EXPECT_NE(ctx->started, ozo::time_traits::time_point{});
+
+    ozo::impl::update_request_phase(ctx, ozo::request_phase::send);
+    EXPECT_EQ(requests[ozo::request_phase::send].count(), 1u);
+    EXPECT_EQ(requests[ozo::request_phase::first_byte].count(), 0u);
+}
+
+} // namespace